@@ -0,0 +1,155 @@
+// Đo thông lượng tra cứu bảng client khi tăng số luồng xử lý từ 1 đến 32.
+//
+// So sánh bảng một khóa toàn cục (thiết kế cũ của NetworkServer) với ClientTable
+// chia shard dùng std::shared_mutex. Mỗi thao tác mô phỏng đường gửi gói tin:
+// getUsername(fd), getClientFD(username) rồi khóa write_mutex của client.
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../server/client_table.hpp"
+
+static const int CLIENT_COUNT = 4096;
+static const int FIRST_FD = 5;
+static const std::chrono::milliseconds RUN_TIME(300);
+
+// Thiết kế cũ: mọi thao tác đi qua một std::mutex duy nhất
+class GlobalLockTable
+{
+public:
+    std::shared_ptr<ClientInfo> findOrCreate(int client_fd)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<ClientInfo> &slot = clients[client_fd];
+        if (!slot)
+            slot = std::make_shared<ClientInfo>();
+        return slot;
+    }
+
+    std::shared_ptr<ClientInfo> find(int client_fd)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = clients.find(client_fd);
+        return it == clients.end() ? nullptr : it->second;
+    }
+
+    void setUsername(int client_fd, const std::string &username)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        clients[client_fd]->username = username;
+        fds[username] = client_fd;
+    }
+
+    std::string getUsername(int client_fd)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = clients.find(client_fd);
+        return it == clients.end() ? "" : it->second->username;
+    }
+
+    int getClientFD(const std::string &username)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = fds.find(username);
+        return it == fds.end() ? -1 : it->second;
+    }
+
+private:
+    std::mutex mutex;
+    std::unordered_map<int, std::shared_ptr<ClientInfo>> clients;
+    std::unordered_map<std::string, int> fds;
+};
+
+template <typename Table>
+void populate(Table &table, std::vector<std::string> &usernames)
+{
+    for (int i = 0; i < CLIENT_COUNT; ++i)
+    {
+        table.findOrCreate(FIRST_FD + i);
+        table.setUsername(FIRST_FD + i, usernames[i]);
+    }
+}
+
+template <typename Table>
+double measure(Table &table, int thread_count)
+{
+    std::atomic<bool> start(false);
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> total_ops(0);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < thread_count; ++t)
+    {
+        threads.emplace_back([&, t]()
+                             {
+            uint64_t ops = 0;
+            uint32_t seed = 2654435761u * (t + 1);
+            while (!start.load(std::memory_order_acquire)) {}
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                seed = seed * 1664525u + 1013904223u;
+                int index = static_cast<int>(seed % CLIENT_COUNT);
+
+                std::string username = table.getUsername(FIRST_FD + index);
+                int fd = table.getClientFD(username);
+                std::shared_ptr<ClientInfo> client = table.find(fd);
+                if (client)
+                {
+                    std::lock_guard<std::mutex> lock(client->write_mutex);
+                }
+                ++ops;
+            }
+            total_ops += ops; });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(RUN_TIME);
+    stop = true;
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return total_ops.load() / seconds;
+}
+
+int main()
+{
+    std::vector<std::string> usernames;
+    for (int i = 0; i < CLIENT_COUNT; ++i)
+    {
+        usernames.push_back("player_" + std::to_string(i));
+    }
+
+    GlobalLockTable global_table;
+    ClientTable sharded_table;
+    populate(global_table, usernames);
+    populate(sharded_table, usernames);
+
+    std::cout << "Client table contention benchmark (" << CLIENT_COUNT << " clients, "
+              << std::thread::hardware_concurrency() << " hardware threads)" << std::endl;
+    std::cout << std::left << std::setw(10) << "threads"
+              << std::setw(20) << "global mutex op/s"
+              << std::setw(20) << "sharded op/s"
+              << "speedup" << std::endl;
+
+    for (int thread_count : {1, 2, 4, 8, 16, 32})
+    {
+        double global_rate = measure(global_table, thread_count);
+        double sharded_rate = measure(sharded_table, thread_count);
+
+        std::cout << std::left << std::setw(10) << thread_count
+                  << std::setw(20) << std::fixed << std::setprecision(0) << global_rate
+                  << std::setw(20) << sharded_rate
+                  << std::setprecision(2) << sharded_rate / global_rate << "x" << std::endl;
+    }
+
+    return 0;
+}
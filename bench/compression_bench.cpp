@@ -0,0 +1,165 @@
+// So sánh số byte và thời gian CPU khi nén payload bằng Lz trên dữ liệu thật data/matches.json.
+//
+// Ba loại dữ liệu:
+//   - toàn bộ tệp matches.json;
+//   - payload MATCH_HISTORY v2 của từng người chơi (câu trả lời lịch sử trận đấu);
+//   - từng trận đấu dạng JSON (nước đi + FEN, tương đương dữ liệu xuất ván cờ).
+// Với mỗi loại in tổng byte gốc, tổng byte sau nén (chỉ tính các payload vượt ngưỡng nén
+// như server), tỉ lệ, và tốc độ nén / giải nén.
+// Tham số (tùy chọn): đường dẫn matches.json, ngưỡng nén (mặc định Const::COMPRESSION_THRESHOLD).
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../libraries/json.hpp"
+#include "../common/const.hpp"
+#include "../common/lz_codec.hpp"
+#include "../common/message.hpp"
+
+using json = nlohmann::json;
+
+static const std::chrono::milliseconds RUN_TIME(300);
+
+using Corpus = std::vector<std::vector<uint8_t>>;
+
+static std::vector<uint8_t> bytesOf(const std::string &text)
+{
+    return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+// Lặp fn trên toàn bộ corpus trong khoảng RUN_TIME, trả về MB/s theo số byte gốc
+template <typename Fn>
+double throughput(const Corpus &corpus, size_t raw_bytes, Fn &&fn)
+{
+    size_t rounds = 0;
+    auto begin = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::duration::zero();
+    do
+    {
+        for (size_t i = 0; i < corpus.size(); ++i)
+        {
+            fn(i);
+        }
+        ++rounds;
+        elapsed = std::chrono::steady_clock::now() - begin;
+    } while (elapsed < RUN_TIME);
+
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    return static_cast<double>(raw_bytes) * rounds / seconds / (1024.0 * 1024.0);
+}
+
+static void report(const std::string &name, const Corpus &corpus, size_t threshold)
+{
+    size_t raw_bytes = 0;
+    size_t wire_bytes = 0;
+    size_t compressed_count = 0;
+    Corpus compressed(corpus.size());
+    std::vector<uint8_t> output;
+
+    for (size_t i = 0; i < corpus.size(); ++i)
+    {
+        const std::vector<uint8_t> &payload = corpus[i];
+        raw_bytes += payload.size();
+
+        compressed[i].resize(Lz::compressBound(payload.size()));
+        compressed[i].resize(Lz::compress(payload.data(), payload.size(), compressed[i].data()));
+
+        output.resize(payload.size());
+        if (!Lz::decompress(compressed[i].data(), compressed[i].size(), output.data(), output.size()) ||
+            output != payload)
+        {
+            std::cerr << name << ": giải nén không khớp dữ liệu gốc (mục " << i << ")" << std::endl;
+            std::exit(1);
+        }
+
+        // Như NetworkServer::compressFrame: chỉ nén khi vượt ngưỡng và nén có lợi
+        // (tính cả 1 byte type gốc và varint độ dài gốc)
+        size_t framed = 1 + varint_size(payload.size()) + compressed[i].size();
+        if (threshold != 0 && payload.size() >= threshold && framed < payload.size())
+        {
+            wire_bytes += framed;
+            ++compressed_count;
+        }
+        else
+        {
+            wire_bytes += payload.size();
+        }
+    }
+
+    std::vector<uint8_t> scratch(Lz::compressBound(raw_bytes));
+    double compress_rate = throughput(corpus, raw_bytes, [&](size_t i)
+                                      { Lz::compress(corpus[i].data(), corpus[i].size(), scratch.data()); });
+    double decompress_rate = throughput(corpus, raw_bytes, [&](size_t i)
+                                        { Lz::decompress(compressed[i].data(), compressed[i].size(), scratch.data(), corpus[i].size()); });
+
+    std::cout << std::left << std::setw(22) << name
+              << std::setw(8) << corpus.size()
+              << std::setw(10) << compressed_count
+              << std::setw(12) << raw_bytes
+              << std::setw(12) << wire_bytes
+              << std::setw(9) << std::fixed << std::setprecision(2)
+              << (raw_bytes == 0 ? 1.0 : static_cast<double>(wire_bytes) / raw_bytes)
+              << std::setw(14) << std::setprecision(1) << compress_rate
+              << decompress_rate << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string path = argc > 1 ? argv[1] : "data/matches.json";
+    size_t threshold = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : Const::COMPRESSION_THRESHOLD;
+
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cerr << "Không mở được " << path << std::endl;
+        return 1;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+    json matches = json::parse(text);
+
+    Corpus whole_file = {bytesOf(text)};
+
+    Corpus per_match;
+    std::map<std::string, MatchHistoryMessage> histories;
+    for (auto it = matches.begin(); it != matches.end(); ++it)
+    {
+        per_match.push_back(bytesOf(it.value().dump()));
+
+        const json &match = it.value();
+        std::string white = match.at("white_username").get<std::string>();
+        std::string black = match.at("black_username").get<std::string>();
+        std::string result = match.at("result").get<std::string>();
+        std::string date = std::to_string(match.at("start_time").get<int64_t>());
+        histories[white].matches.push_back({it.key(), black, result == white, date});
+        histories[black].matches.push_back({it.key(), white, result == black, date});
+    }
+
+    Corpus history_payloads;
+    for (const auto &[username, history] : histories)
+    {
+        history_payloads.push_back(history.serialize(Protocol::V2));
+    }
+
+    std::cout << "Lz compression benchmark on " << path << " (threshold " << threshold << " bytes)" << std::endl;
+    std::cout << std::left << std::setw(22) << "corpus"
+              << std::setw(8) << "items"
+              << std::setw(10) << "packed"
+              << std::setw(12) << "raw B"
+              << std::setw(12) << "wire B"
+              << std::setw(9) << "ratio"
+              << std::setw(14) << "comp MB/s"
+              << "decomp MB/s" << std::endl;
+
+    report("matches.json", whole_file, threshold);
+    report("MATCH_HISTORY v2", history_payloads, threshold);
+    report("match JSON", per_match, threshold);
+    return 0;
+}
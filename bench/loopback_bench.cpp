@@ -0,0 +1,144 @@
+// Đo thông lượng và độ trễ khứ hồi của server qua loopback.
+//
+// Mỗi luồng mở một kết nối tới server đang chạy và lặp lại REQUEST_PLAYER_LIST ->
+// PLAYER_LIST trong một khoảng thời gian cố định. Chạy lần lượt với hai backend để so sánh:
+//   ./build/server_main --backend=epoll     rồi  ./build/loopback_bench
+//   ./build/server_main --backend=io_uring  rồi  ./build/loopback_bench
+// Tham số (tùy chọn): số kết nối, số mili giây mỗi lần đo.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../common/const.hpp"
+#include "../common/packet_framer.hpp"
+
+static int connectToServer()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1)
+        return -1;
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(Const::SERVER_PORT);
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Gửi một yêu cầu và chờ đến khi nhận được PLAYER_LIST
+static bool roundTrip(int fd, PacketFramer &framer, const std::vector<uint8_t> &request)
+{
+    if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size()))
+        return false;
+
+    PacketView view;
+    while (true)
+    {
+        while (framer.next(view))
+        {
+            if (view.type == MessageType::PLAYER_LIST)
+                return true;
+        }
+
+        size_t span_size;
+        uint8_t *span = framer.writableSpan(span_size);
+        ssize_t received = recv(fd, span, span_size, 0);
+        if (received <= 0)
+            return false;
+        framer.commit(received);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int connections = argc > 1 ? std::stoi(argv[1]) : 8;
+    int run_ms = argc > 2 ? std::stoi(argv[2]) : 2000;
+
+    Packet packet;
+    packet.type = MessageType::REQUEST_PLAYER_LIST;
+    packet.length = 0;
+    std::vector<uint8_t> request = packet.serialize();
+
+    int probe = connectToServer();
+    if (probe == -1)
+    {
+        std::cout << "loopback_bench: không kết nối được server trên cổng " << Const::SERVER_PORT
+                  << ", bỏ qua (hãy chạy ./build/server_main trước)." << std::endl;
+        return 0;
+    }
+    close(probe);
+
+    std::atomic<bool> start(false);
+    std::atomic<bool> stop(false);
+    std::vector<std::vector<double>> latencies(connections);
+    std::vector<std::thread> threads;
+
+    for (int c = 0; c < connections; ++c)
+    {
+        threads.emplace_back([&, c]()
+                             {
+            int fd = connectToServer();
+            if (fd == -1)
+                return;
+            PacketFramer framer;
+            while (!start.load()) {}
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                auto begin = std::chrono::steady_clock::now();
+                if (!roundTrip(fd, framer, request))
+                    break;
+                latencies[c].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+            }
+            close(fd); });
+    }
+
+    // Chờ các kết nối được server chấp nhận trước khi bắt đầu đo
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    auto begin = std::chrono::steady_clock::now();
+    start = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(run_ms));
+    stop = true;
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::vector<double> all;
+    for (const auto &samples : latencies)
+    {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    if (all.empty())
+    {
+        std::cout << "loopback_bench: không nhận được phản hồi nào." << std::endl;
+        return 1;
+    }
+    std::sort(all.begin(), all.end());
+
+    std::cout << "Loopback round-trip benchmark (" << connections << " connections, " << run_ms << " ms)" << std::endl;
+    std::cout << std::fixed << std::setprecision(0)
+              << "requests/s: " << all.size() / seconds << std::endl
+              << std::setprecision(1)
+              << "p50 latency: " << all[all.size() / 2] << " us" << std::endl
+              << "p99 latency: " << all[all.size() * 99 / 100] << " us" << std::endl;
+    return 0;
+}
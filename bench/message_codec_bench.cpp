@@ -0,0 +1,752 @@
+// Thông lượng mã hóa / giải mã (thông điệp/giây) và số lần cấp phát mỗi thông điệp cho
+// mọi MessageType trong AllMessages, ở cả v1 và v2.
+//
+// Dữ liệu mẫu lấy từ data/users.json và data/matches.json: username và elo thật, game_id,
+// nước đi, FEN và lịch sử trận đấu thật. Các cột:
+//   - encode: encodeTo() vào buffer của người gọi (đường gửi của server);
+//   - serialize: serialize() trả về vector (đường cũ);
+//   - decode: deserialize() ra thông điệp sở hữu dữ liệu;
+//   - view: decode() ra MessageView (không sao chép chuỗi).
+// Tham số (tùy chọn): thư mục data, thời gian đo mỗi ô (ms).
+// --corpus=DIR ghi các payload mẫu làm corpus khởi đầu cho fuzz/message_fuzz rồi thoát.
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../libraries/json.hpp"
+#include "../chess_engine/chess.hpp"
+#include "../common/message.hpp"
+
+using json = nlohmann::json;
+
+// Đếm mọi lần cấp phát trong tiến trình (bench chạy một luồng)
+static size_t allocations = 0;
+
+void *operator new(size_t size)
+{
+    ++allocations;
+    if (void *ptr = std::malloc(size == 0 ? 1 : size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// operator new ở trên cấp phát bằng malloc, nên free là đúng; GCC không biết điều này
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+#pragma GCC diagnostic pop
+
+static std::chrono::milliseconds run_time(50);
+
+struct Corpus
+{
+    struct User
+    {
+        std::string username;
+        uint16_t elo;
+        std::vector<std::string> match_history;
+    };
+
+    struct Move
+    {
+        std::string uci_move;
+        std::string fen_before;
+        std::string fen;
+    };
+
+    struct Match
+    {
+        std::string game_id;
+        std::string white_username;
+        std::string black_username;
+        std::string result;
+        std::string reason;
+        std::string start_fen;
+        std::vector<Move> moves;
+    };
+
+    std::vector<User> users;
+    std::vector<Match> matches;
+
+    static json load(const std::string &path)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            std::cerr << "Không mở được " << path << std::endl;
+            std::exit(1);
+        }
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return json::parse(buffer.str());
+    }
+
+    explicit Corpus(const std::string &data_dir)
+    {
+        json users_json = load(data_dir + "/users.json");
+        for (auto it = users_json.begin(); it != users_json.end(); ++it)
+        {
+            users.push_back({it.key(), it.value().at("elo").get<uint16_t>(),
+                             it.value().at("match_history").get<std::vector<std::string>>()});
+        }
+
+        json matches_json = load(data_dir + "/matches.json");
+        for (auto it = matches_json.begin(); it != matches_json.end(); ++it)
+        {
+            const json &value = it.value();
+            Match match{it.key(), value.at("white_username"), value.at("black_username"),
+                        value.at("result"), value.at("reason"), value.at("start_fen"), {}};
+            std::string fen_before = match.start_fen;
+            for (const json &move : value.at("moves"))
+            {
+                match.moves.push_back({move.at("uci_move"), fen_before, move.at("fen")});
+                fen_before = match.moves.back().fen;
+            }
+            matches.push_back(std::move(match));
+        }
+    }
+
+    template <typename Fn>
+    void forEachMove(Fn &&fn) const
+    {
+        for (size_t i = 0; i < matches.size(); ++i)
+        {
+            for (size_t ply = 0; ply < matches[i].moves.size(); ++ply)
+            {
+                fn(i, matches[i], static_cast<uint32_t>(ply), matches[i].moves[ply]);
+            }
+        }
+    }
+};
+
+#pragma region Samples
+// Mỗi hàm build tạo các thông điệp mẫu cho một loại từ Corpus
+
+static void build(const Corpus &, std::vector<HelloMessage> &out)
+{
+    out.push_back(HelloMessage{});
+}
+
+static void build(const Corpus &, std::vector<HelloAckMessage> &out)
+{
+    HelloAckMessage message;
+    message.version = Protocol::V2;
+    out.push_back(message);
+}
+
+static void build(const Corpus &corpus, std::vector<RegisterMessage> &out)
+{
+    for (const auto &user : corpus.users)
+    {
+        RegisterMessage message;
+        message.username = user.username;
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &corpus, std::vector<RegisterSuccessMessage> &out)
+{
+    for (const auto &user : corpus.users)
+    {
+        RegisterSuccessMessage message;
+        message.username = user.username;
+        message.elo = user.elo;
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &, std::vector<RegisterFailureMessage> &out)
+{
+    RegisterFailureMessage message;
+    message.error_message = "Tên người dùng đã tồn tại.";
+    out.push_back(message);
+}
+
+static void build(const Corpus &corpus, std::vector<LoginMessage> &out)
+{
+    for (const auto &user : corpus.users)
+    {
+        LoginMessage message;
+        message.username = user.username;
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &corpus, std::vector<LoginSuccessMessage> &out)
+{
+    for (const auto &user : corpus.users)
+    {
+        LoginSuccessMessage message;
+        message.username = user.username;
+        message.elo = user.elo;
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &, std::vector<LoginFailureMessage> &out)
+{
+    LoginFailureMessage message;
+    message.error_message = "Tên người dùng không tồn tại.";
+    out.push_back(message);
+}
+
+static void build(const Corpus &corpus, std::vector<RequestPlayerListMessage> &out)
+{
+    RequestPlayerListMessage message;
+    out.push_back(message);
+    message.limit = 20;
+    message.cursor = corpus.users.front().username;
+    out.push_back(message);
+}
+
+static void build(const Corpus &corpus, std::vector<PlayerListMessage> &out)
+{
+    PlayerListMessage message;
+    for (size_t i = 0; i < corpus.users.size(); ++i)
+    {
+        const auto &user = corpus.users[i];
+        bool in_game = i % 2 == 0 && !user.match_history.empty();
+        message.players.push_back({user.username, user.elo, in_game, in_game ? user.match_history.back() : ""});
+    }
+    out.push_back(message);
+}
+
+static void build(const Corpus &, std::vector<RequestMatchHistoryMessage> &out)
+{
+    RequestMatchHistoryMessage message;
+    out.push_back(message);
+    message.limit = 20;
+    message.cursor = "20";
+    out.push_back(message);
+}
+
+static void build(const Corpus &corpus, std::vector<MatchHistoryMessage> &out)
+{
+    for (const auto &user : corpus.users)
+    {
+        MatchHistoryMessage message;
+        for (const auto &match : corpus.matches)
+        {
+            if (match.white_username == user.username || match.black_username == user.username)
+            {
+                bool white = match.white_username == user.username;
+                message.matches.push_back({match.game_id, white ? match.black_username : match.white_username,
+                                           match.result == user.username, "2024-12-16 09:28:30"});
+            }
+        }
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &corpus, std::vector<GameStartMessage> &out)
+{
+    for (size_t i = 0; i < corpus.matches.size(); ++i)
+    {
+        const auto &match = corpus.matches[i];
+        GameStartMessage message;
+        message.game_id = match.game_id;
+        message.player1_username = match.white_username;
+        message.player2_username = match.black_username;
+        message.starting_player_username = match.white_username;
+        message.fen = match.start_fen;
+        message.game_handle = i + 1;
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &corpus, std::vector<MoveMessage> &out)
+{
+    corpus.forEachMove([&out](size_t index, const Corpus::Match &match, uint32_t, const Corpus::Move &move)
+                       {
+        MoveMessage message;
+        message.game_id = match.game_id;
+        message.game_handle = index + 1;
+        message.uci_move = move.uci_move;
+        out.push_back(message); });
+}
+
+static void build(const Corpus &corpus, std::vector<InvalidMoveMessage> &out)
+{
+    for (size_t i = 0; i < corpus.matches.size(); ++i)
+    {
+        InvalidMoveMessage message;
+        message.game_id = corpus.matches[i].game_id;
+        message.game_handle = i + 1;
+        message.error_message = "Nước đi không hợp lệ.";
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &corpus, std::vector<GameStatusUpdateMessage> &out)
+{
+    corpus.forEachMove([&out](size_t index, const Corpus::Match &match, uint32_t ply, const Corpus::Move &move)
+                       {
+        GameStatusUpdateMessage message;
+        message.game_id = match.game_id;
+        message.game_handle = index + 1;
+        message.fen = move.fen;
+        message.current_turn_username = ply % 2 == 0 ? match.black_username : match.white_username;
+        message.is_game_over = ply + 1 == match.moves.size();
+        message.message = message.is_game_over ? match.reason : "";
+        out.push_back(message); });
+}
+
+static void build(const Corpus &corpus, std::vector<GameEndMessage> &out)
+{
+    for (size_t i = 0; i < corpus.matches.size(); ++i)
+    {
+        const auto &match = corpus.matches[i];
+        GameEndMessage message;
+        message.game_id = match.game_id;
+        message.game_handle = i + 1;
+        message.winner_username = match.result;
+        message.reason = match.reason;
+        message.half_moves_count = static_cast<uint16_t>(match.moves.size());
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &corpus, std::vector<SurrenderMessage> &out)
+{
+    for (size_t i = 0; i < corpus.matches.size(); ++i)
+    {
+        SurrenderMessage message;
+        message.game_id = corpus.matches[i].game_id;
+        message.game_handle = i + 1;
+        message.from_username = corpus.matches[i].black_username;
+        out.push_back(message);
+    }
+}
+
+static uint16_t rawMove(const Corpus::Move &move)
+{
+    chess::Board board(move.fen_before);
+    return chess::uci::uciToMove(board, move.uci_move).move();
+}
+
+static void build(const Corpus &corpus, std::vector<MoveV2Message> &out)
+{
+    corpus.forEachMove([&out](size_t index, const Corpus::Match &, uint32_t ply, const Corpus::Move &move)
+                       {
+        MoveV2Message message;
+        message.game_handle = index + 1;
+        message.ply = ply;
+        message.move = rawMove(move);
+        out.push_back(message); });
+}
+
+static void build(const Corpus &corpus, std::vector<GameMoveDeltaMessage> &out)
+{
+    corpus.forEachMove([&out](size_t index, const Corpus::Match &match, uint32_t ply, const Corpus::Move &move)
+                       {
+        GameMoveDeltaMessage message;
+        message.game_handle = index + 1;
+        message.ply = ply + 1;
+        message.move = rawMove(move);
+        message.flags = ply + 1 == match.moves.size() ? GameMoveDeltaMessage::GAME_OVER : 0;
+        out.push_back(message); });
+}
+
+static void build(const Corpus &corpus, std::vector<GameKeyframeMessage> &out)
+{
+    corpus.forEachMove([&out](size_t index, const Corpus::Match &, uint32_t ply, const Corpus::Move &move)
+                       {
+        GameKeyframeMessage message;
+        message.game_handle = index + 1;
+        message.ply = ply + 1;
+        message.board = chess::Board::Compact::encode(chess::Board(move.fen));
+        out.push_back(message); });
+}
+
+static void build(const Corpus &corpus, std::vector<ResyncRequestMessage> &out)
+{
+    for (size_t i = 0; i < corpus.matches.size(); ++i)
+    {
+        ResyncRequestMessage message;
+        message.game_handle = i + 1;
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &corpus, std::vector<ChallengeRequestMessage> &out)
+{
+    for (const auto &user : corpus.users)
+    {
+        ChallengeRequestMessage message;
+        message.to_username = user.username;
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &corpus, std::vector<ChallengeNotificationMessage> &out)
+{
+    for (const auto &user : corpus.users)
+    {
+        ChallengeNotificationMessage message;
+        message.from_username = user.username;
+        message.elo = user.elo;
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &corpus, std::vector<ChallengeResponseMessage> &out)
+{
+    for (const auto &user : corpus.users)
+    {
+        ChallengeResponseMessage message;
+        message.from_username = user.username;
+        message.response = ChallengeResponseMessage::Response::ACCEPTED;
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &corpus, std::vector<ChallengeAcceptedMessage> &out)
+{
+    for (size_t i = 0; i < corpus.matches.size(); ++i)
+    {
+        ChallengeAcceptedMessage message;
+        message.from_username = corpus.matches[i].white_username;
+        message.game_id = corpus.matches[i].game_id;
+        message.game_handle = i + 1;
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &corpus, std::vector<ChallengeDeclinedMessage> &out)
+{
+    for (const auto &user : corpus.users)
+    {
+        ChallengeDeclinedMessage message;
+        message.from_username = user.username;
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &corpus, std::vector<AutoMatchRequestMessage> &out)
+{
+    for (const auto &user : corpus.users)
+    {
+        AutoMatchRequestMessage message;
+        message.username = user.username;
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &corpus, std::vector<AutoMatchFoundMessage> &out)
+{
+    for (size_t i = 0; i < corpus.matches.size(); ++i)
+    {
+        AutoMatchFoundMessage message;
+        message.opponent_username = corpus.matches[i].black_username;
+        message.opponent_elo = corpus.users[i % corpus.users.size()].elo;
+        message.game_id = corpus.matches[i].game_id;
+        message.game_handle = i + 1;
+        out.push_back(message);
+    }
+}
+
+// AUTO_MATCH_ACCEPTED, AUTO_MATCH_DECLINED, MATCH_DECLINED_NOTIFICATION, SPECTATE_SUCCESS,
+// SPECTATE_EXIT: chỉ có định danh ván cờ
+template <typename Message>
+static void buildGameIdOnly(const Corpus &corpus, std::vector<Message> &out)
+{
+    for (size_t i = 0; i < corpus.matches.size(); ++i)
+    {
+        Message message;
+        message.game_id = corpus.matches[i].game_id;
+        message.game_handle = i + 1;
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &corpus, std::vector<AutoMatchAcceptedMessage> &out) { buildGameIdOnly(corpus, out); }
+static void build(const Corpus &corpus, std::vector<AutoMatchDeclinedMessage> &out) { buildGameIdOnly(corpus, out); }
+static void build(const Corpus &corpus, std::vector<MatchDeclinedNotificationMessage> &out) { buildGameIdOnly(corpus, out); }
+static void build(const Corpus &corpus, std::vector<SpectateSuccessMessage> &out) { buildGameIdOnly(corpus, out); }
+static void build(const Corpus &corpus, std::vector<SpectateExitMessage> &out) { buildGameIdOnly(corpus, out); }
+
+static void build(const Corpus &corpus, std::vector<PlayWithBotMessage> &out)
+{
+    for (const auto &user : corpus.users)
+    {
+        PlayWithBotMessage message;
+        message.username = user.username;
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &corpus, std::vector<RequestSpectateMessage> &out)
+{
+    for (const auto &user : corpus.users)
+    {
+        RequestSpectateMessage message;
+        message.username = user.username;
+        out.push_back(message);
+    }
+}
+
+static void build(const Corpus &, std::vector<SpectateFailureMessage> &out)
+{
+    out.push_back(SpectateFailureMessage{});
+}
+
+static void build(const Corpus &corpus, std::vector<SpectateMoveMessage> &out)
+{
+    corpus.forEachMove([&out](size_t, const Corpus::Match &match, uint32_t ply, const Corpus::Move &move)
+                       {
+        SpectateMoveMessage message;
+        message.fen = move.fen;
+        message.current_turn_username = ply % 2 == 0 ? match.black_username : match.white_username;
+        message.is_white = ply % 2 == 1;
+        out.push_back(message); });
+}
+
+static void build(const Corpus &, std::vector<SpectateEndMessage> &out)
+{
+    out.push_back(SpectateEndMessage{});
+}
+#pragma endregion Samples
+
+static const char *typeName(MessageType type)
+{
+    switch (type)
+    {
+    case MessageType::HELLO:
+        return "HELLO";
+    case MessageType::HELLO_ACK:
+        return "HELLO_ACK";
+    case MessageType::REGISTER:
+        return "REGISTER";
+    case MessageType::REGISTER_SUCCESS:
+        return "REGISTER_SUCCESS";
+    case MessageType::REGISTER_FAILURE:
+        return "REGISTER_FAILURE";
+    case MessageType::LOGIN:
+        return "LOGIN";
+    case MessageType::LOGIN_SUCCESS:
+        return "LOGIN_SUCCESS";
+    case MessageType::LOGIN_FAILURE:
+        return "LOGIN_FAILURE";
+    case MessageType::REQUEST_PLAYER_LIST:
+        return "REQUEST_PLAYER_LIST";
+    case MessageType::PLAYER_LIST:
+        return "PLAYER_LIST";
+    case MessageType::REQUEST_MATCH_HISTORY:
+        return "REQUEST_MATCH_HISTORY";
+    case MessageType::MATCH_HISTORY:
+        return "MATCH_HISTORY";
+    case MessageType::GAME_START:
+        return "GAME_START";
+    case MessageType::MOVE:
+        return "MOVE";
+    case MessageType::INVALID_MOVE:
+        return "INVALID_MOVE";
+    case MessageType::GAME_STATUS_UPDATE:
+        return "GAME_STATUS_UPDATE";
+    case MessageType::GAME_END:
+        return "GAME_END";
+    case MessageType::SURRENDER:
+        return "SURRENDER";
+    case MessageType::MOVE_V2:
+        return "MOVE_V2";
+    case MessageType::GAME_MOVE_DELTA:
+        return "GAME_MOVE_DELTA";
+    case MessageType::GAME_KEYFRAME:
+        return "GAME_KEYFRAME";
+    case MessageType::RESYNC_REQUEST:
+        return "RESYNC_REQUEST";
+    case MessageType::CHALLENGE_REQUEST:
+        return "CHALLENGE_REQUEST";
+    case MessageType::CHALLENGE_NOTIFICATION:
+        return "CHALLENGE_NOTIFICATION";
+    case MessageType::CHALLENGE_RESPONSE:
+        return "CHALLENGE_RESPONSE";
+    case MessageType::CHALLENGE_ACCEPTED:
+        return "CHALLENGE_ACCEPTED";
+    case MessageType::CHALLENGE_DECLINED:
+        return "CHALLENGE_DECLINED";
+    case MessageType::AUTO_MATCH_REQUEST:
+        return "AUTO_MATCH_REQUEST";
+    case MessageType::AUTO_MATCH_FOUND:
+        return "AUTO_MATCH_FOUND";
+    case MessageType::AUTO_MATCH_ACCEPTED:
+        return "AUTO_MATCH_ACCEPTED";
+    case MessageType::AUTO_MATCH_DECLINED:
+        return "AUTO_MATCH_DECLINED";
+    case MessageType::MATCH_DECLINED_NOTIFICATION:
+        return "MATCH_DECLINED_NOTIFICATION";
+    case MessageType::PLAY_WITH_BOT:
+        return "PLAY_WITH_BOT";
+    case MessageType::REQUEST_SPECTATE:
+        return "REQUEST_SPECTATE";
+    case MessageType::SPECTATE_SUCCESS:
+        return "SPECTATE_SUCCESS";
+    case MessageType::SPECTATE_FAILURE:
+        return "SPECTATE_FAILURE";
+    case MessageType::SPECTATE_MOVE:
+        return "SPECTATE_MOVE";
+    case MessageType::SPECTATE_END:
+        return "SPECTATE_END";
+    case MessageType::SPECTATE_EXIT:
+        return "SPECTATE_EXIT";
+    default:
+        return "?";
+    }
+}
+
+struct Measure
+{
+    double messages_per_second;
+    double allocations_per_message;
+};
+
+// Lặp fn(i) trên mọi mẫu trong khoảng run_time
+template <typename Fn>
+Measure measure(size_t count, Fn &&fn)
+{
+    size_t calls = 0;
+    size_t allocations_before = allocations;
+    auto begin = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::duration::zero();
+    do
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            fn(i);
+        }
+        calls += count;
+        elapsed = std::chrono::steady_clock::now() - begin;
+    } while (elapsed < run_time);
+
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    return {calls / seconds, static_cast<double>(allocations - allocations_before) / calls};
+}
+
+static volatile size_t sink;
+
+static void printMeasure(const Measure &value)
+{
+    std::cout << std::setw(10) << std::setprecision(2) << value.messages_per_second / 1e6
+              << std::setw(7) << std::setprecision(1) << value.allocations_per_message;
+}
+
+template <typename Message>
+void report(const std::vector<Message> &samples, uint8_t version)
+{
+    using View = MessageView<Message>;
+
+    std::vector<std::vector<uint8_t>> payloads;
+    size_t max_frame = 0;
+    size_t total_bytes = 0;
+    for (const Message &message : samples)
+    {
+        payloads.push_back(message.serialize(version));
+        max_frame = std::max(max_frame, encodedSize(message, version));
+        total_bytes += payloads.back().size();
+    }
+    std::vector<uint8_t> buffer(max_frame);
+
+    Measure encode = measure(samples.size(), [&](size_t i)
+                             { sink = encodeTo(samples[i], buffer.data(), version); });
+    Measure serialize = measure(samples.size(), [&](size_t i)
+                                { sink = samples[i].serialize(version).size(); });
+    Measure decode = measure(samples.size(), [&](size_t i)
+                             { sink = Message::deserialize(payloads[i], version).getType() == samples[i].getType(); });
+    Measure view = measure(samples.size(), [&](size_t i)
+                           {
+        View decoded{};
+        sink = View::decode(payloads[i].data(), payloads[i].size(), decoded, version); });
+
+    std::cout << "0x" << std::hex << std::setw(2) << std::setfill('0')
+              << static_cast<int>(samples.front().getType()) << std::dec << std::setfill(' ') << "  "
+              << std::left << std::setw(34) << typeName(samples.front().getType()) << std::right
+              << std::setw(4) << static_cast<int>(version)
+              << std::setw(8) << samples.size()
+              << std::setw(9) << total_bytes / samples.size()
+              << std::fixed;
+    printMeasure(encode);
+    printMeasure(serialize);
+    printMeasure(decode);
+    printMeasure(view);
+    std::cout << std::endl;
+}
+
+// Ghi corpus cho fuzz/message_fuzz: [chỉ số trong AllMessages][phiên bản][payload]
+template <typename Message>
+void writeSeeds(const std::string &dir, size_t index, const std::vector<Message> &samples)
+{
+    for (uint8_t version : {Protocol::V1, Protocol::V2})
+    {
+        for (size_t i = 0; i < samples.size() && i < 4; ++i)
+        {
+            std::vector<uint8_t> payload = samples[i].serialize(version);
+            std::ofstream file(dir + "/" + std::to_string(index) + "_v" + std::to_string(version) + "_" + std::to_string(i),
+                               std::ios::binary);
+            file.put(static_cast<char>(index));
+            file.put(static_cast<char>(version));
+            file.write(reinterpret_cast<const char *>(payload.data()), static_cast<std::streamsize>(payload.size()));
+        }
+    }
+}
+
+template <typename... Message>
+void runAll(const Corpus &corpus, const std::string &corpus_dir, MessageList<Message...>)
+{
+    size_t index = 0;
+    auto one = [&](auto *tag)
+    {
+        using Type = std::remove_pointer_t<decltype(tag)>;
+        std::vector<Type> samples;
+        build(corpus, samples);
+        if (!corpus_dir.empty())
+        {
+            writeSeeds(corpus_dir, index++, samples);
+            return;
+        }
+        report(samples, Protocol::V1);
+        report(samples, Protocol::V2);
+    };
+    (one(static_cast<Message *>(nullptr)), ...);
+}
+
+int main(int argc, char *argv[])
+{
+    std::string data_dir = "data";
+    std::string corpus_dir;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--corpus=", 0) == 0)
+            corpus_dir = arg.substr(9);
+        else if (i == 1)
+            data_dir = arg;
+        else
+            run_time = std::chrono::milliseconds(std::atoi(argv[i]));
+    }
+
+    Corpus corpus(data_dir);
+    if (!corpus_dir.empty())
+    {
+        runAll(corpus, corpus_dir, AllMessages{});
+        std::cout << "Wrote fuzz corpus to " << corpus_dir << std::endl;
+        return 0;
+    }
+
+    std::cout << "Message codec benchmark on " << data_dir << " (" << corpus.users.size() << " users, "
+              << corpus.matches.size() << " matches), Mmsg/s and allocations per message" << std::endl;
+    std::cout << std::left << std::setw(40) << "type" << std::right
+              << std::setw(4) << "ver" << std::setw(8) << "samples" << std::setw(9) << "bytes"
+              << std::setw(17) << "encode" << std::setw(17) << "serialize"
+              << std::setw(17) << "decode" << std::setw(17) << "view" << std::endl;
+    runAll(corpus, corpus_dir, AllMessages{});
+    return 0;
+}
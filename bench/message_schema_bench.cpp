@@ -0,0 +1,212 @@
+// So sánh bộ mã hóa / giải mã sinh từ Schema::Fields với phiên bản viết tay trước đây.
+//
+// "hand" là đúng thân write()/deserialize() cũ trong message.hpp (giải mã không kiểm tra
+// giới hạn), "schema" là Fields::write / MessageCodec::deserialize, "view" là bản
+// std::string_view sinh từ cùng khai báo. Mỗi cột là nano giây cho một thông điệp (-O2).
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../common/message.hpp"
+
+static const std::chrono::milliseconds RUN_TIME(300);
+
+namespace hand
+{
+    inline size_t read_length(const std::vector<uint8_t> &payload, size_t &pos, uint8_t version)
+    {
+        if (version < Protocol::V2)
+        {
+            return payload[pos++];
+        }
+        uint64_t length;
+        if (!read_varint(payload.data(), payload.size(), pos, length) || length > payload.size() - pos)
+        {
+            pos = payload.size();
+            return 0;
+        }
+        return static_cast<size_t>(length);
+    }
+
+    inline std::string read_string(const std::vector<uint8_t> &payload, size_t &pos, uint8_t version)
+    {
+        size_t length = read_length(payload, pos, version);
+        std::string value(payload.begin() + pos, payload.begin() + pos + length);
+        pos += length;
+        return value;
+    }
+
+    template <typename Writer>
+    void write(const GameStatusUpdateMessage &message, Writer &writer)
+    {
+        writer.writeGameId(message.game_id, message.game_handle);
+        writer.writeString(message.fen);
+        writer.writeString(message.current_turn_username);
+        writer.writeU8(message.is_game_over);
+        writer.writeString(message.message);
+    }
+
+    GameStatusUpdateMessage deserialize(const std::vector<uint8_t> &payload, uint8_t version, GameStatusUpdateMessage)
+    {
+        GameStatusUpdateMessage message;
+        size_t pos = 0;
+        message.game_id = read_string(payload, pos, version);
+        message.fen = read_string(payload, pos, version);
+        message.current_turn_username = read_string(payload, pos, version);
+        message.is_game_over = payload[pos++];
+        message.message = read_string(payload, pos, version);
+        return message;
+    }
+
+    template <typename Writer>
+    void write(const MatchHistoryMessage &message, Writer &writer)
+    {
+        size_t count = std::min(message.matches.size(), max_list_size(writer.version()));
+        writer.writeLength(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const MatchHistoryMessage::Match &match = message.matches[i];
+            writer.writeString(match.game_id);
+            writer.writeString(match.opponent_username);
+            writer.writeU8(static_cast<uint8_t>(match.won));
+            writer.writeString(match.date);
+        }
+    }
+
+    MatchHistoryMessage deserialize(const std::vector<uint8_t> &payload, uint8_t version, MatchHistoryMessage)
+    {
+        MatchHistoryMessage message;
+        size_t pos = 0;
+        size_t number_of_matches = read_length(payload, pos, version);
+        for (size_t i = 0; i < number_of_matches; ++i)
+        {
+            MatchHistoryMessage::Match match;
+            match.game_id = read_string(payload, pos, version);
+            match.opponent_username = read_string(payload, pos, version);
+            match.won = payload[pos++];
+            match.date = read_string(payload, pos, version);
+            message.matches.push_back(match);
+        }
+        return message;
+    }
+
+    template <typename Writer>
+    void write(const MoveMessage &message, Writer &writer)
+    {
+        writer.writeGameId(message.game_id, message.game_handle);
+        writer.writeString(message.uci_move);
+    }
+
+    MoveMessage deserialize(const std::vector<uint8_t> &payload, uint8_t version, MoveMessage)
+    {
+        MoveMessage message;
+        size_t pos = 0;
+        message.game_id = read_string(payload, pos, version);
+        message.uci_move = read_string(payload, pos, version);
+        return message;
+    }
+}
+
+// Chạy fn lặp lại trong RUN_TIME, trả về ns cho một lần gọi
+template <typename Fn>
+double nanosPerCall(Fn &&fn)
+{
+    size_t calls = 0;
+    auto begin = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::duration::zero();
+    do
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            fn();
+        }
+        calls += 256;
+        elapsed = std::chrono::steady_clock::now() - begin;
+    } while (elapsed < RUN_TIME);
+    return std::chrono::duration<double, std::nano>(elapsed).count() / calls;
+}
+
+static volatile size_t sink;
+
+template <typename Message, typename View>
+void report(const std::string &name, const Message &message)
+{
+    const uint8_t version = Protocol::V1;
+    std::vector<uint8_t> payload = message.serialize(version);
+    std::vector<uint8_t> buffer(payload.size());
+
+    if (hand::deserialize(payload, version, Message{}).serialize(version) != payload)
+    {
+        std::cerr << name << ": bản viết tay không khớp payload của Schema" << std::endl;
+        std::exit(1);
+    }
+
+    double hand_encode = nanosPerCall([&]
+                                      {
+        PayloadSizer sizer(version);
+        hand::write(message, sizer);
+        PayloadWriter writer(buffer.data(), version);
+        hand::write(message, writer);
+        sink = sizer.size() + buffer[0]; });
+    double schema_encode = nanosPerCall([&]
+                                        {
+        PayloadSizer sizer(version);
+        Message::Fields::write(message, sizer);
+        PayloadWriter writer(buffer.data(), version);
+        Message::Fields::write(message, writer);
+        sink = sizer.size() + buffer[0]; });
+    double hand_decode = nanosPerCall([&]
+                                      { sink = hand::deserialize(payload, version, Message{}).getType() == message.getType(); });
+    double schema_decode = nanosPerCall([&]
+                                        { sink = Message::deserialize(payload, version).getType() == message.getType(); });
+    double view_decode = nanosPerCall([&]
+                                      {
+        View view{};
+        sink = View::decode(payload.data(), payload.size(), view, version); });
+
+    std::cout << std::left << std::setw(26) << name
+              << std::setw(8) << payload.size()
+              << std::fixed << std::setprecision(1)
+              << std::setw(14) << hand_encode
+              << std::setw(14) << schema_encode
+              << std::setw(14) << hand_decode
+              << std::setw(14) << schema_decode
+              << view_decode << std::endl;
+}
+
+int main()
+{
+    GameStatusUpdateMessage status;
+    status.game_id = "alice_bob_20241201_120000";
+    status.fen = "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1";
+    status.current_turn_username = "bob";
+    status.is_game_over = 0;
+    status.message = "";
+
+    MatchHistoryMessage history;
+    for (int i = 0; i < 40; ++i)
+    {
+        history.matches.push_back({"alice_player" + std::to_string(i) + "_20241201_120000",
+                                   "player" + std::to_string(i), i % 3 == 0, "2024-12-01 12:00:00"});
+    }
+
+    MoveMessage move;
+    move.game_id = "alice_bob_20241201_120000";
+    move.uci_move = "e2e4";
+
+    std::cout << "Schema codec vs hand-written codec, v1 payloads (ns/message)" << std::endl;
+    std::cout << std::left << std::setw(26) << "message"
+              << std::setw(8) << "bytes"
+              << std::setw(14) << "hand enc"
+              << std::setw(14) << "schema enc"
+              << std::setw(14) << "hand dec"
+              << std::setw(14) << "schema dec"
+              << "view dec" << std::endl;
+
+    report<GameStatusUpdateMessage, BasicGameStatusUpdateMessage<std::string_view>>("GameStatusUpdate", status);
+    report<MatchHistoryMessage, BasicMatchHistoryMessage<std::string_view>>("MatchHistory (40)", history);
+    report<MoveMessage, MoveMessageView>("Move", move);
+    return 0;
+}
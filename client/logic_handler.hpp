@@ -72,9 +72,10 @@ public:
             {
                 std::string username = UI::displayRegister();
 
-                RegisterMessage reg_msg = RegisterMessage{username};
+                RegisterMessage reg_msg;
+                reg_msg.username = username;
 
-                if (!network_client.sendPacket(reg_msg.getType(), reg_msg.serialize()))
+                if (!network_client.sendMessage(reg_msg))
                 {
                     UI::printErrorMessage("Gửi yêu cầu đăng ký thất bại.");
                     break;
@@ -85,9 +86,10 @@ public:
             {
                 std::string username = UI::displayLogin(network_client);
 
-                LoginMessage login_msg = LoginMessage{username};
+                LoginMessage login_msg;
+                login_msg.username = username;
 
-                if (!network_client.sendPacket(login_msg.getType(), login_msg.serialize()))
+                if (!network_client.sendMessage(login_msg))
                 {
                     UI::printErrorMessage("Gửi yêu cầu đăng nhập thất bại.");
                     break;
@@ -143,7 +145,7 @@ public:
                 AutoMatchRequestMessage auto_match_request_msg;
                 auto_match_request_msg.username = session_data.getUsername();
 
-                if (!network_client.sendPacket(auto_match_request_msg.getType(), auto_match_request_msg.serialize()))
+                if (!network_client.sendMessage(auto_match_request_msg))
                 {
                     UI::printErrorMessage("Gửi yêu cầu ghép trận tự động thất bại.");
                     break;
@@ -158,7 +160,7 @@ public:
                 PlayWithBotMessage play_with_bot_msg;
                 play_with_bot_msg.username = session_data.getUsername();
 
-                if (!network_client.sendPacket(play_with_bot_msg.getType(), play_with_bot_msg.serialize()))
+                if (!network_client.sendMessage(play_with_bot_msg))
                 {
                     UI::printErrorMessage("Gửi yêu cầu chơi với máy thất bại.");
                 }
@@ -170,7 +172,7 @@ public:
             {
                 // Xem danh sách người chơi trực tuyến
                 RequestPlayerListMessage request_player_list_msg;
-                if (!network_client.sendPacket(request_player_list_msg.getType(), request_player_list_msg.serialize()))
+                if (!network_client.sendRequest(request_player_list_msg, MessageType::PLAYER_LIST))
                 {
                     UI::printErrorMessage("Tải danh sách người chơi trực tuyến thất bại.");
                     break;
@@ -183,7 +185,7 @@ public:
                 // Xem lịch sử trận đấu
                 RequestMatchHistoryMessage request_match_history_msg;
 
-                if (!network_client.sendPacket(request_match_history_msg.getType(), request_match_history_msg.serialize()))
+                if (!network_client.sendRequest(request_match_history_msg, MessageType::MATCH_HISTORY))
                 {
                     UI::printErrorMessage("Tải lịch sử trận đấu thất bại.");
                     break;
@@ -239,8 +241,9 @@ public:
                 // Chấp nhận
                 AutoMatchAcceptedMessage auto_match_accepted_msg;
                 auto_match_accepted_msg.game_id = message.game_id;
+                auto_match_accepted_msg.game_handle = message.game_handle;
 
-                if (!network_client.sendPacket(auto_match_accepted_msg.getType(), auto_match_accepted_msg.serialize()))
+                if (!network_client.sendMessage(auto_match_accepted_msg))
                 {
                     UI::printErrorMessage("Gửi yêu cầu chấp nhận ghép trận tự động thất bại.");
                     break;
@@ -254,8 +257,9 @@ public:
                 // Từ chối
                 AutoMatchDeclinedMessage auto_match_declined_msg;
                 auto_match_declined_msg.game_id = message.game_id;
+                auto_match_declined_msg.game_handle = message.game_handle;
 
-                if (!network_client.sendPacket(auto_match_declined_msg.getType(), auto_match_declined_msg.serialize()))
+                if (!network_client.sendMessage(auto_match_declined_msg))
                 {
                     UI::printErrorMessage("Gửi yêu cầu từ chối ghép trận tự động thất bại.");
                     break;
@@ -288,6 +292,7 @@ public:
 
         bool is_white = message.starting_player_username == session_data.getUsername();
         session_data.setGameStatus(message.game_id, is_white, message.fen);
+        session_data.setGameHandle(message.game_handle);
 
         // Bắt đầu trò chơi
         handleMove();
@@ -318,6 +323,43 @@ public:
         handleMove();
     }
 
+    void handleGameMoveDelta(const GameMoveDeltaMessage &message)
+    {
+        SessionData &session_data = SessionData::getInstance();
+        NetworkClient &network_client = NetworkClient::getInstance();
+
+        if (message.game_handle != session_data.getGameHandle())
+        {
+            return;
+        }
+
+        // Lệch ply hoặc nước đi không hợp lệ trên bàn cờ của client: xin keyframe
+        if (!session_data.applyMove(message.move, message.ply))
+        {
+            ResyncRequestMessage resync_msg;
+            resync_msg.game_handle = message.game_handle;
+            network_client.sendMessage(resync_msg);
+            return;
+        }
+
+        showGameUpdate(message.flags);
+    }
+
+    void handleGameKeyframe(const GameKeyframeMessage &message)
+    {
+        SessionData &session_data = SessionData::getInstance();
+
+        if (message.game_handle != session_data.getGameHandle())
+        {
+            return;
+        }
+
+        // GameKeyframeMessage::board có cùng kiểu với chess::PackedBoard
+        session_data.setBoard(message.board, message.ply);
+
+        showGameUpdate(message.flags);
+    }
+
     void handleMove()
     {
         SessionData &session_data = SessionData::getInstance();
@@ -341,9 +383,10 @@ public:
                 // Gửi thông điệp đầu hàng
                 SurrenderMessage surrender_msg;
                 surrender_msg.game_id = session_data.getGameId();
+                surrender_msg.game_handle = session_data.getGameHandle();
                 surrender_msg.from_username = session_data.getUsername();
 
-                if (!network_client.sendPacket(surrender_msg.getType(), surrender_msg.serialize()))
+                if (!network_client.sendMessage(surrender_msg))
                 {
                     UI::printErrorMessage("Gửi thông điệp đầu hàng thất bại.");
                     return;
@@ -354,12 +397,34 @@ public:
 
             std::string uci_move = result;
 
+            // Có handle (v2): gửi nước đi nhị phân, server không phải phân tích chuỗi
+            uint64_t game_handle = session_data.getGameHandle();
+            if (game_handle != 0)
+            {
+                chess::Board board = session_data.getBoard();
+                chess::Move move = chess::uci::uciToMove(board, uci_move);
+                if (move != chess::Move::NO_MOVE)
+                {
+                    MoveV2Message move_msg;
+                    move_msg.game_handle = game_handle;
+                    move_msg.ply = session_data.getPly();
+                    move_msg.move = move.move();
+
+                    if (!network_client.sendMessage(move_msg))
+                    {
+                        UI::printErrorMessage("Gửi nước đi thất bại.");
+                    }
+                    return;
+                }
+            }
+
             // Gửi nước đi
             MoveMessage move_msg;
             move_msg.game_id = session_data.getGameId();
+            move_msg.game_handle = game_handle;
             move_msg.uci_move = uci_move;
 
-            if (!network_client.sendPacket(move_msg.getType(), move_msg.serialize()))
+            if (!network_client.sendMessage(move_msg))
             {
                 UI::printErrorMessage("Gửi nước đi thất bại.");
                 return;
@@ -371,6 +436,26 @@ public:
             UI::printInfoMessage("Đang chờ đối thủ ra nước đi...");
         }
     }
+    // Phần chung của GAME_MOVE_DELTA và GAME_KEYFRAME sau khi bàn cờ đã được cập nhật
+    void showGameUpdate(uint8_t flags)
+    {
+        SessionData &session_data = SessionData::getInstance();
+
+        UI::printInfoMessage("Trò chơi đã cập nhật.");
+        if (flags & GameMoveDeltaMessage::CHECK)
+        {
+            UI::printInfoMessage("Check!");
+        }
+
+        if (flags & GameMoveDeltaMessage::GAME_OVER)
+        {
+            UI::showBoard(session_data.getFen(), !session_data.isWhite());
+            return;
+        }
+
+        handleMove();
+    }
+
     void handlePlayerListDecision(std::vector<PlayerListMessage::Player> &players)
     {
         NetworkClient &network_client = NetworkClient::getInstance();
@@ -426,7 +511,7 @@ public:
 
             challenge_request_msg.to_username = decision.username;
 
-            if (!network_client.sendPacket(challenge_request_msg.getType(), challenge_request_msg.serialize()))
+            if (!network_client.sendMessage(challenge_request_msg))
             {
                 UI::printErrorMessage("Gửi yêu cầu thách đấu thất bại.");
                 handleGameMenu();
@@ -477,7 +562,7 @@ public:
             }
 
             request_spectate_msg.username = decision.username;
-            if (!network_client.sendPacket(request_spectate_msg.getType(), request_spectate_msg.serialize()))
+            if (!network_client.sendMessage(request_spectate_msg))
             {
                 UI::printErrorMessage("Gửi yêu cầu xem trận thất bại.");
                 handleGameMenu();
@@ -545,7 +630,7 @@ public:
 
                 challenge_response_msg.response = ChallengeResponseMessage::Response::ACCEPTED;
 
-                if (!network_client.sendPacket(challenge_response_msg.getType(), challenge_response_msg.serialize()))
+                if (!network_client.sendMessage(challenge_response_msg))
                 {
                     UI::printErrorMessage("Gửi yêu cầu chấp nhận thách đấu thất bại.");
                     break;
@@ -561,7 +646,7 @@ public:
 
                 challenge_response_msg.response = ChallengeResponseMessage::Response::DECLINED;
 
-                if (!network_client.sendPacket(challenge_response_msg.getType(), challenge_response_msg.serialize()))
+                if (!network_client.sendMessage(challenge_response_msg))
                 {
                     UI::printErrorMessage("Gửi yêu cầu từ chối thách đấu thất bại.");
                     break;
@@ -604,7 +689,7 @@ public:
 
         // NetworkClient &network_client = NetworkClient::getInstance();
 
-        // if (!network_client.sendPacket(request_match_data_msg.getType(), request_match_data_msg.serialize()))
+        // if (!network_client.sendMessage(request_match_data_msg))
         // {
         //     UI::printErrorMessage("Gửi yêu cầu xem lại trận đấu thất bại.");
         //     handleGameMenu();
@@ -8,6 +8,11 @@
 #include <iomanip>      // Optional if using std::put_time
 #include <sstream> 
 #include <chrono>
+#include <iterator>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <atomic>
 
 #include "../common/protocol.hpp"
 #include "../common/message.hpp"
@@ -24,19 +29,28 @@ public:
     /**
      * @brief Đẩy một gói tin mới vào hàng đợi xử lý
      *
-     * Tạo một luồng mới để xử lý gói tin và chạy ngầm
+     * Tạo một luồng mới để xử lý gói tin và chạy ngầm.
+     *
+     * Các luồng nhận quyền xử lý (current handler) theo đúng thứ tự gói tin đến: nhiều gói tin
+     * trong cùng một lần đọc (BATCH) tạo các luồng gần như cùng lúc, nếu không gói tin cũ có thể
+     * giành lại quyền của gói tin mới (ví dụ cập nhật cuối ván hủy menu của GAME_END).
      * @param packet Gói tin cần xử lý
      * @return true nếu đẩy thành công
      */
-    bool pushMessage(const Packet &packet)
+    bool pushMessage(Packet packet)
     {
         SessionData &session_data = SessionData::getInstance();
+        uint64_t ticket = ++dispatched;
         // Start new handler thread
-        std::thread([this, packet, &session_data]()
+        std::thread([this, packet, ticket, &session_data]()
                     {
             {
+                std::unique_lock<std::mutex> lock(handover_mutex);
+                handover_cv.wait(lock, [this, ticket]() { return handed_over == ticket - 1; });
                 session_data.setCurrentHandler(std::this_thread::get_id());
+                handed_over = ticket;
             }
+            handover_cv.notify_all();
 
             handleMessage(packet);
             
@@ -49,6 +63,19 @@ public:
     }
 
 private:
+    // Thứ tự nhận quyền xử lý: số gói tin đã giao cho luồng xử lý (chỉ dùng trên luồng nhận)
+    // và số luồng đã nhận quyền
+    uint64_t dispatched = 0;
+    std::mutex handover_mutex;
+    std::condition_variable handover_cv;
+    uint64_t handed_over = 0;
+
+    // Người chơi của các trang danh sách đã nhận (v2), chờ trang cuối để chọn người thách đấu
+    std::vector<PlayerListMessage::Player> player_list_pages;
+    std::mutex player_list_mutex;
+    // Đang nhận các trang lịch sử trận đấu (đã in tiêu đề)
+    std::atomic<bool> match_history_paging{false};
+
     // Handle incoming messages ================================================================================
 
     /**
@@ -59,6 +86,12 @@ private:
      */
     bool handleMessage(const Packet &packet)
     {
+        // Câu trả lời mang request ID lạ hoặc trùng lặp thì bỏ qua
+        if (!NetworkClient::getInstance().completeRequest(packet))
+        {
+            return false;
+        }
+
         bool success = true;
         switch (packet.type)
         {
@@ -87,6 +120,14 @@ private:
             // Handle game status update
             handleGameStatusUpdate(packet.payload);
             break;
+        case MessageType::GAME_MOVE_DELTA:
+            // Handle move delta (v2)
+            handleGameMoveDelta(packet.payload);
+            break;
+        case MessageType::GAME_KEYFRAME:
+            // Handle board keyframe (v2)
+            handleGameKeyframe(packet.payload);
+            break;
         case MessageType::INVALID_MOVE:
             // Handle invalid move
             handleInvalidMove(packet.payload);
@@ -166,7 +207,7 @@ private:
 
     void handleRegisterSuccess(const std::vector<uint8_t> &payload)
     {
-        RegisterSuccessMessage message = RegisterSuccessMessage::deserialize(payload);
+        RegisterSuccessMessage message = RegisterSuccessMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
         UI::printSuccessMessage("Đăng ký thành công.");
         std::cout << "Username: " << message.username << "\n"
@@ -185,7 +226,7 @@ private:
 
     void handleRegisterFailure(const std::vector<uint8_t> &payload)
     {
-        RegisterFailureMessage message = RegisterFailureMessage::deserialize(payload);
+        RegisterFailureMessage message = RegisterFailureMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
         UI::printErrorMessage("Đăng ký thất bại.");
         std::cout << "Error_message: " << message.error_message << std::endl;
@@ -193,7 +234,7 @@ private:
 
     void handleLoginSuccess(const std::vector<uint8_t> &payload)
     {
-        LoginSuccessMessage message = LoginSuccessMessage::deserialize(payload);
+        LoginSuccessMessage message = LoginSuccessMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
         UI::printSuccessMessage("Đăng nhập thành công.");
         std::cout << "Username: " << message.username << "\n"
@@ -212,7 +253,7 @@ private:
 
     void handleLoginFailure(const std::vector<uint8_t> &payload)
     {
-        LoginFailureMessage message = LoginFailureMessage::deserialize(payload);
+        LoginFailureMessage message = LoginFailureMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
         UI::printErrorMessage("Đăng nhập thất bại.");
         std::cout << "Error_message: " << message.error_message << std::endl;
@@ -223,7 +264,7 @@ private:
 
     void handleGameStart(const std::vector<uint8_t> &payload)
     {
-        GameStartMessage message = GameStartMessage::deserialize(payload);
+        GameStartMessage message = GameStartMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
         // Display the game menu
         LogicHandler logic_handler;
@@ -232,16 +273,40 @@ private:
 
     void handleGameStatusUpdate(const std::vector<uint8_t> &payload)
     {
-        GameStatusUpdateMessage message = GameStatusUpdateMessage::deserialize(payload);
+        GameStatusUpdateMessage message = GameStatusUpdateMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
         // Handle game status update
         LogicHandler logic_handler;
         logic_handler.handleGameStatusUpdate(message);
     }
 
+    void handleGameMoveDelta(const std::vector<uint8_t> &payload)
+    {
+        GameMoveDeltaMessage message;
+        if (!GameMoveDeltaMessage::decode(payload.data(), payload.size(), message, NetworkClient::getInstance().getProtocolVersion()))
+        {
+            return;
+        }
+
+        LogicHandler logic_handler;
+        logic_handler.handleGameMoveDelta(message);
+    }
+
+    void handleGameKeyframe(const std::vector<uint8_t> &payload)
+    {
+        GameKeyframeMessage message;
+        if (!GameKeyframeMessage::decode(payload.data(), payload.size(), message, NetworkClient::getInstance().getProtocolVersion()))
+        {
+            return;
+        }
+
+        LogicHandler logic_handler;
+        logic_handler.handleGameKeyframe(message);
+    }
+
     void handleInvalidMove(const std::vector<uint8_t> &payload)
     {
-        InvalidMoveMessage message = InvalidMoveMessage::deserialize(payload);
+        InvalidMoveMessage message = InvalidMoveMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
         UI::printErrorMessage("Nước đi không hợp lệ.");
         std::cout << "Game_id: " << message.game_id << "\n"
@@ -253,7 +318,7 @@ private:
 
     void handleGameEnd(const std::vector<uint8_t> &payload)
     {
-        GameEndMessage message = GameEndMessage::deserialize(payload);
+        GameEndMessage message = GameEndMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
         UI::printInfoMessage("Trò chơi đã kết thúc.");
         std::cout << "Game_id: " << message.game_id << "\n"
@@ -269,14 +334,14 @@ private:
 
     void handleAutoMatchFound(const std::vector<uint8_t> &payload)
     {
-        AutoMatchFoundMessage message = AutoMatchFoundMessage::deserialize(payload);
+        AutoMatchFoundMessage message = AutoMatchFoundMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
         LogicHandler logic_handler;
         logic_handler.handleMatchDecision(message);
     }
 
     void handleMatchDeclinedNotification(const std::vector<uint8_t> &payload)
     {
-        MatchDeclinedNotificationMessage message = MatchDeclinedNotificationMessage::deserialize(payload);
+        MatchDeclinedNotificationMessage message = MatchDeclinedNotificationMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
         UI::printInfoMessage("Trận đấu đã bị từ chối.");
         std::cout << "Game_id: " << message.game_id << std::endl;
@@ -287,17 +352,30 @@ private:
 
     void handlePlayerList(const std::vector<uint8_t> &payload)
     {
-        PlayerListMessage message = PlayerListMessage::deserialize(payload);
+        PlayerListMessage message = PlayerListMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
+        // Mỗi trang được in ngay khi nhận; trang tiếp theo chỉ được yêu cầu sau khi in xong
         for (const auto &player : message.players)
         {
             std::cout << "Username: " << player.username << "\n"
                       << "ELO: " << player.elo << std::endl;
         }
 
+        std::vector<PlayerListMessage::Player> players;
+        {
+            std::lock_guard<std::mutex> lock(player_list_mutex);
+            player_list_pages.insert(player_list_pages.end(), std::make_move_iterator(message.players.begin()),
+                                     std::make_move_iterator(message.players.end()));
+            if (!message.final && requestNextPage(RequestPlayerListMessage(), message.next_cursor, MessageType::PLAYER_LIST))
+            {
+                return;
+            }
+            players.swap(player_list_pages);
+        }
+
         LogicHandler logic_handler;
 
-        logic_handler.handlePlayerListDecision(message.players);
+        logic_handler.handlePlayerListDecision(players);
 
         SessionData &session_data = SessionData::getInstance();
         if (session_data.shouldStop())
@@ -310,7 +388,7 @@ private:
 
     void handleChallengeNotification(const std::vector<uint8_t> &payload)
     {
-        ChallengeNotificationMessage message = ChallengeNotificationMessage::deserialize(payload);
+        ChallengeNotificationMessage message = ChallengeNotificationMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
         UI::printInfoMessage("Nhận được thách đấu từ người chơi khác.");
         std::cout << "Challenger: " << message.from_username << std::endl;
@@ -322,7 +400,7 @@ private:
 
     void handleChallengeDeclined(const std::vector<uint8_t> &payload)
     {
-        ChallengeDeclinedMessage message = ChallengeDeclinedMessage::deserialize(payload);
+        ChallengeDeclinedMessage message = ChallengeDeclinedMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
         UI::printInfoMessage("Thách đấu đã bị từ chối.");
 
@@ -332,7 +410,7 @@ private:
 
     void handleChallengeAccepted(const std::vector<uint8_t> &payload)
     {
-        ChallengeAcceptedMessage message = ChallengeAcceptedMessage::deserialize(payload);
+        ChallengeAcceptedMessage message = ChallengeAcceptedMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
         UI::printInfoMessage("Thách đấu đã được chấp nhận.");
     }
@@ -340,7 +418,7 @@ private:
     void handleSpectateSuccess(const std::vector<uint8_t> &payload)
     {
         NetworkClient &network_client = NetworkClient::getInstance();
-        SpectateSuccessMessage message = SpectateSuccessMessage::deserialize(payload);
+        SpectateSuccessMessage message = SpectateSuccessMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
         std::string game_id = message.game_id;
 
         UI::printInfoMessage("Bắt đầu quan sát trận đấu.");
@@ -352,7 +430,8 @@ private:
 
         SpectateExitMessage spectate_exit_msg;
         spectate_exit_msg.game_id = game_id;
-        network_client.sendPacket(spectate_exit_msg.getType(), spectate_exit_msg.serialize());
+        spectate_exit_msg.game_handle = message.game_handle;
+        network_client.sendMessage(spectate_exit_msg);
 
         LogicHandler logic_handler;
         logic_handler.handleGameMenu();
@@ -360,7 +439,7 @@ private:
 
     void handleSpectateFailure(const std::vector<uint8_t> &payload)
     {
-        SpectateFailureMessage message = SpectateFailureMessage::deserialize(payload);
+        SpectateFailureMessage message = SpectateFailureMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
         UI::printErrorMessage("Người chơi này hiện không trong trận đấu nào.");
 
@@ -372,7 +451,7 @@ private:
     {
         LogicHandler logic_handler;
 
-        SpectateEndMessage message = SpectateEndMessage::deserialize(payload);
+        SpectateEndMessage message = SpectateEndMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
         UI::printInfoMessage("Trận đấu bạn quan sát đã kết thúc.");
 
@@ -381,7 +460,7 @@ private:
 
     void handleSpectateMove(const std::vector<uint8_t> &payload)
     {
-        SpectateMoveMessage message = SpectateMoveMessage::deserialize(payload);
+        SpectateMoveMessage message = SpectateMoveMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
         UI::showBoard(message.fen);
         std::cout << "Tiếp theo sẽ đến lượt của: " << message.current_turn_username
@@ -391,9 +470,13 @@ private:
 
     void handleMatchHistory(const std::vector<uint8_t> &payload)
     {
-        MatchHistoryMessage message = MatchHistoryMessage::deserialize(payload);
+        MatchHistoryMessage message = MatchHistoryMessage::deserialize(payload, NetworkClient::getInstance().getProtocolVersion());
 
-        UI::printInfoMessage("Lịch sử trận đấu:");
+        // Tiêu đề chỉ in ở trang đầu tiên
+        if (!match_history_paging.exchange(!message.final))
+        {
+            UI::printInfoMessage("Lịch sử trận đấu:");
+        }
 
         for (const auto &match : message.matches)
         {
@@ -404,10 +487,32 @@ private:
                       << "-------------------------------------------" << std::endl;
         }
 
+        if (!message.final && requestNextPage(RequestMatchHistoryMessage(), message.next_cursor, MessageType::MATCH_HISTORY))
+        {
+            return;
+        }
+        match_history_paging = false;
+
         LogicHandler logic_handler;
         logic_handler.handleMatchHistoryDecision();
     }
 
+    /**
+     * @brief Yêu cầu trang tiếp theo của danh sách phân trang (v2).
+     *
+     * @return true nếu đã gửi yêu cầu, false nếu không còn trang hoặc gửi thất bại.
+     */
+    template <typename RequestMessage>
+    static bool requestNextPage(RequestMessage request, const std::string &next_cursor, MessageType response_type)
+    {
+        if (next_cursor.empty())
+        {
+            return false;
+        }
+        request.cursor = next_cursor;
+        return NetworkClient::getInstance().sendRequest(request, response_type);
+    }
+
 }; // namespace MessageHandler
 
 #endif // MESSAGE_HANDLER_HPP
\ No newline at end of file
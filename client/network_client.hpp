@@ -4,13 +4,16 @@
 #include <string>
 #include <vector>
 #include <mutex>
+#include <unordered_map>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <cerrno>
 #include <cstring>
 #include <iostream>
 
 #include "../common/protocol.hpp"
+#include "../common/packet_framer.hpp"
 #include "../common/message.hpp"
 #include "../common/utils.hpp"
 #include "../common/const.hpp"
@@ -27,8 +30,27 @@ class NetworkClient
 {
 private:
     int socket_fd;
-    std::vector<uint8_t> buffer;
+    PacketFramer framer;
     std::mutex send_mutex;
+    std::vector<uint8_t> send_buffer; // Dùng lại cho mọi lần gửi, chỉ nới rộng khi cần
+    uint8_t protocol_version = Protocol::V1;
+
+    // Yêu cầu đang chờ trả lời: request ID -> loại thông điệp trả lời mong đợi (chỉ ở v2)
+    std::mutex request_mutex;
+    std::unordered_map<uint32_t, MessageType> pending_requests;
+    uint32_t next_request_id = 1;
+
+    // Gửi toàn bộ send_buffer[0, size). Yêu cầu giữ send_mutex.
+    bool sendBufferLocked(size_t size)
+    {
+        ssize_t sent = send(socket_fd, send_buffer.data(), size, 0);
+        if (sent != static_cast<ssize_t>(size))
+        {
+            perror("send failed");
+            return false;
+        }
+        return true;
+    }
 
     /**
      * @brief Kết nối đến máy chủ với IP và cổng được cung cấp.
@@ -78,6 +100,78 @@ private:
         return true;
     }
 
+    // Kết quả thỏa thuận phiên bản trên một kết nối
+    enum class Handshake
+    {
+        ACCEPTED,      // Nhận HELLO_ACK với phiên bản hợp lệ
+        NO_ANSWER,     // Hết thời gian chờ hoặc kết nối bị đóng trước khi có HELLO_ACK
+        PROTOCOL_ERROR // Nhận gói tin khác HELLO_ACK, hoặc HELLO_ACK không hợp lệ
+    };
+
+    /**
+     * @brief Thỏa thuận phiên bản giao thức với máy chủ bằng HELLO / HELLO_ACK.
+     *
+     * HELLO và HELLO_ACK luôn dùng frame v1. Sau khi gửi HELLO, gói tin đầu tiên từ máy chủ
+     * phải là HELLO_ACK: máy chủ đã đổi phiên bản của kết nối trước khi trả lời, nên không
+     * được tự quay về v1 trên cùng socket.
+     */
+    Handshake negotiateVersion()
+    {
+        HelloMessage hello;
+        hello.max_version = Protocol::LATEST;
+        if (!sendMessage(hello))
+        {
+            return Handshake::NO_ANSWER;
+        }
+
+        // Chờ ngắn hơn timeout thông thường để máy chủ cũ không làm chậm lúc khởi động
+        struct timeval handshake_timeout = {2, 0};
+        struct timeval normal_timeout = {5, 0};
+        setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, (char *)&handshake_timeout, sizeof(handshake_timeout));
+
+        Handshake result = Handshake::NO_ANSWER;
+        PacketView view;
+        while (true)
+        {
+            if (framer.next(view))
+            {
+                result = Handshake::PROTOCOL_ERROR;
+                if (view.type == MessageType::HELLO_ACK)
+                {
+                    HelloAckMessage ack = HelloAckMessage::deserialize(view.toPacket().payload);
+                    if (ack.version >= Protocol::V1 && ack.version <= Protocol::LATEST)
+                    {
+                        protocol_version = ack.version;
+                        framer.setVersion(protocol_version);
+                        result = Handshake::ACCEPTED;
+                    }
+                }
+                break;
+            }
+            if (framer.failed())
+            {
+                result = Handshake::PROTOCOL_ERROR;
+                break;
+            }
+
+            size_t span_size;
+            uint8_t *span = framer.writableSpan(span_size);
+            ssize_t bytes_received = recv(socket_fd, span, span_size, 0);
+            if (bytes_received < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (bytes_received <= 0)
+            {
+                break; // Hết thời gian chờ hoặc kết nối bị đóng
+            }
+            framer.commit(bytes_received);
+        }
+
+        setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, (char *)&normal_timeout, sizeof(normal_timeout));
+        return result;
+    }
+
     // Private constructor for Singleton
     NetworkClient() : socket_fd(-1)
     {
@@ -86,6 +180,25 @@ private:
             std::cerr << "Không thể kết nối tới server" << std::endl;
             exit(EXIT_FAILURE);
         }
+
+        Handshake handshake = negotiateVersion();
+        if (handshake == Handshake::PROTOCOL_ERROR)
+        {
+            std::cerr << "Server trả lời HELLO không hợp lệ." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        if (handshake == Handshake::NO_ANSWER)
+        {
+            // Máy chủ cũ không biết HELLO. Kết nối cũ có thể đã bị đổi phiên bản nếu HELLO_ACK
+            // đến muộn, nên dùng v1 trên một kết nối mới không gửi HELLO.
+            closeConnection();
+            framer = PacketFramer();
+            if (!connectToServer(Const::SERVER_IP, Const::SERVER_PORT))
+            {
+                std::cerr << "Không thể kết nối tới server" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        }
     }
 
 public:
@@ -117,22 +230,101 @@ public:
     {
         std::lock_guard<std::mutex> lock(send_mutex);
 
-        Packet packet;
-        packet.type = messageType;
-        packet.length = htons(static_cast<uint16_t>(payload.size()));
-        packet.payload = payload;
+        size_t size = frameHeaderSize(payload.size(), protocol_version) + payload.size();
+        if (send_buffer.size() < size)
+        {
+            send_buffer.resize(size);
+        }
+        uint8_t *body = storeFrameHeader(send_buffer.data(), messageType, payload.size(), protocol_version);
+        std::copy(payload.begin(), payload.end(), body);
+        return sendBufferLocked(size);
+    }
 
-        std::vector<uint8_t> serialized = packet.serialize();
+    /**
+     * Tuần tự hóa và gửi một thông điệp theo phiên bản giao thức đã thỏa thuận.
+     *
+     * Header và payload được ghi trong một lượt vào send_buffer; khi buffer đã đủ lớn
+     * việc gửi không cấp phát bộ nhớ.
+     */
+    template <typename Message>
+    bool sendMessage(const Message &message, uint32_t request_id = Protocol::NO_REQUEST_ID)
+    {
+        std::lock_guard<std::mutex> lock(send_mutex);
 
-        ssize_t sent = send(socket_fd, serialized.data(), serialized.size(), 0);
-        if (sent != static_cast<ssize_t>(serialized.size()))
+        size_t size = encodedSize(message, protocol_version, request_id);
+        if (send_buffer.size() < size)
         {
-            perror("send failed");
+            send_buffer.resize(size);
+        }
+        encodeTo(message, send_buffer.data(), protocol_version, request_id);
+        return sendBufferLocked(size);
+    }
+
+    /**
+     * @brief Gửi một yêu cầu truy vấn kèm request ID để có thể gửi nhiều yêu cầu liên tiếp.
+     *
+     * Server gắn lại request ID vào câu trả lời, nên các câu trả lời có thể được ghép với
+     * yêu cầu theo ID thay vì theo loại và thứ tự. Ở v1 yêu cầu được gửi không có ID.
+     *
+     * @param response_type Loại thông điệp trả lời mong đợi.
+     * @return false nếu gửi thất bại.
+     */
+    template <typename Message>
+    bool sendRequest(const Message &message, MessageType response_type)
+    {
+        if (protocol_version < Protocol::V2)
+        {
+            return sendMessage(message);
+        }
+
+        uint32_t request_id;
+        {
+            std::lock_guard<std::mutex> lock(request_mutex);
+            request_id = next_request_id++;
+            if (next_request_id == Protocol::NO_REQUEST_ID)
+            {
+                next_request_id = 1;
+            }
+            pending_requests[request_id] = response_type;
+        }
+
+        if (!sendMessage(message, request_id))
+        {
+            std::lock_guard<std::mutex> lock(request_mutex);
+            pending_requests.erase(request_id);
             return false;
         }
         return true;
     }
 
+    /**
+     * @brief Đánh dấu yêu cầu đã được trả lời.
+     *
+     * @return true nếu gói tin không mang request ID, hoặc mang ID của một yêu cầu đang chờ
+     * đúng loại trả lời đó; false nếu là câu trả lời lạ hoặc trùng lặp.
+     */
+    bool completeRequest(const Packet &packet)
+    {
+        if (packet.request_id == Protocol::NO_REQUEST_ID)
+        {
+            return true;
+        }
+
+        std::lock_guard<std::mutex> lock(request_mutex);
+        auto it = pending_requests.find(packet.request_id);
+        if (it == pending_requests.end() || it->second != packet.type)
+        {
+            return false;
+        }
+        pending_requests.erase(it);
+        return true;
+    }
+
+    uint8_t getProtocolVersion() const
+    {
+        return protocol_version;
+    }
+
     /**
      * Nhận một gói tin từ socket.
      *
@@ -141,9 +333,19 @@ public:
      */
     bool receivePacket(Packet &packet)
     {
-        uint8_t temp_buffer[Const::BUFFER_SIZE];
+        PacketView view;
+
+        // Gói tin đã nằm sẵn trong buffer từ lần đọc trước
+        if (framer.next(view))
+        {
+            packet = view.toPacket();
+            return true;
+        }
+
+        size_t span_size;
+        uint8_t *span = framer.writableSpan(span_size);
 
-        ssize_t bytes_received = recv(socket_fd, temp_buffer, sizeof(temp_buffer), 0);
+        ssize_t bytes_received = recv(socket_fd, span, span_size, 0);
         if (bytes_received < 0)
         {
             if (errno == EWOULDBLOCK || errno == EAGAIN)
@@ -161,29 +363,21 @@ public:
             return false;
         }
 
-        buffer.insert(buffer.end(), temp_buffer, temp_buffer + bytes_received);
+        framer.commit(bytes_received);
 
-        while (buffer.size() >= 3)
+        if (framer.next(view))
         {
-            MessageType type = static_cast<MessageType>(buffer[0]);
-            uint16_t length = (static_cast<uint16_t>(buffer[1]) << 8) |
-                              static_cast<uint16_t>(buffer[2]);
-
-            length = ntohs(length); // Chuyển đổi sang host byte order
-
-            if (buffer.size() < 3 + length)
-            {
-                break; // Chưa nhận đủ dữ liệu
-            }
-
-            std::vector<uint8_t> payload(buffer.begin() + 3, buffer.begin() + 3 + length);
-            packet = Packet{type, length, payload};
-
-            buffer.erase(buffer.begin(), buffer.begin() + 3 + length);
+            packet = view.toPacket();
             return true;
         }
 
-        return false; // Chưa nhận đủ dữ liệu
+        if (framer.failed())
+        {
+            std::cerr << "Nhận frame không hợp lệ từ server." << std::endl;
+            SessionData::getInstance().setRunning(false);
+        }
+
+        return false; // Chưa nhận đủ dữ liệu, phần còn lại được giữ cho lần đọc sau
     }
 
     void closeConnection()
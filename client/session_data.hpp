@@ -5,6 +5,8 @@
 #include <mutex>
 #include <atomic>
 
+#include "../chess_engine/chess.hpp"
+
 #include "input_handler.hpp"
 
 struct GameStatus
@@ -12,7 +14,8 @@ struct GameStatus
     std::string game_id = "";
     bool is_my_turn;
     bool is_white;
-    std::string fen = "";
+    chess::Board board;       // Bàn cờ của client, cập nhật bằng nước đi (v2) hoặc FEN (v1)
+    uint64_t game_handle = 0; // Chỉ có khi dùng giao thức v2
 };
 
 /**
@@ -81,7 +84,7 @@ public:
         game_status_.game_id = game_id;
         game_status_.is_my_turn = is_white;
         game_status_.is_white = is_white;
-        game_status_.fen = fen;
+        game_status_.board.setFen(fen);
     }
 
     void clearGameStatus() {
@@ -89,7 +92,18 @@ public:
         game_status_.game_id = "";
         game_status_.is_my_turn = false;
         game_status_.is_white = false;
-        game_status_.fen = "";
+        game_status_.board.setFen(chess::constants::STARTPOS);
+        game_status_.game_handle = 0;
+    }
+
+    uint64_t getGameHandle() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return game_status_.game_handle;
+    }
+
+    void setGameHandle(uint64_t game_handle) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        game_status_.game_handle = game_handle;
     }
 
     void setTurn(bool is_my_turn) {
@@ -109,12 +123,56 @@ public:
 
     std::string getFen() const {
         std::lock_guard<std::mutex> lock(mutex_);
-        return game_status_.fen;
+        return game_status_.board.getFen();
     }
 
     void setFen(std::string fen) {
         std::lock_guard<std::mutex> lock(mutex_);
-        game_status_.fen = fen;
+        game_status_.board.setFen(fen);
+    }
+
+    chess::Board getBoard() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return game_status_.board;
+    }
+
+    // Số nửa nước đã đi, cùng cách tính với Game::getPly() của server
+    uint32_t getPly() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return plyOf(game_status_.board);
+    }
+
+    /**
+     * @brief Áp dụng nước đi nhận từ GameMoveDeltaMessage lên bàn cờ.
+     *
+     * @return false nếu ply không nối tiếp ply hiện tại hoặc nước đi không hợp lệ trên
+     * bàn cờ của client; khi đó bàn cờ không đổi và cần xin keyframe.
+     */
+    bool applyMove(uint16_t raw_move, uint32_t ply) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        chess::Board &board = game_status_.board;
+        if (ply != plyOf(board) + 1) {
+            return false;
+        }
+
+        chess::Move move(raw_move);
+        chess::Movelist moves;
+        chess::movegen::legalmoves(moves, board);
+        if (std::find(moves.begin(), moves.end(), move) == moves.end()) {
+            return false;
+        }
+
+        board.makeMove(move);
+        game_status_.is_my_turn = (board.sideToMove() == chess::Color::WHITE) == game_status_.is_white;
+        return true;
+    }
+
+    // Thay bàn cờ bằng keyframe; PackedBoard không chứa bộ đếm nước đi nên dựng lại từ ply
+    void setBoard(const chess::PackedBoard &packed, uint32_t ply) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        chess::Board board = chess::Board::Compact::decode(packed);
+        game_status_.board.setFen(board.getFen(false) + " 0 " + std::to_string(ply / 2 + 1));
+        game_status_.is_my_turn = (game_status_.board.sideToMove() == chess::Color::WHITE) == game_status_.is_white;
     }
 
     bool isInGame() const {
@@ -135,6 +193,10 @@ public:
 private:
     SessionData() : username_(""), elo_(0) {}
 
+    static uint32_t plyOf(const chess::Board &board) {
+        return (board.fullMoveNumber() - 1) * 2 + (board.sideToMove() == chess::Color::BLACK ? 1 : 0);
+    }
+
     std::atomic<bool> running;
 
     std::string username_;
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <cstdint>
+#include <cstddef>
 
 namespace Const
 {
@@ -10,15 +11,25 @@ namespace Const
     const uint16_t SERVER_PORT = 8088;
     const std::string SERVER_IP = "127.0.0.1";
     const uint16_t BUFFER_SIZE = 1024;
-    const uint8_t BACKLOG = 5;
+    const size_t FRAMER_CAPACITY = 4096; // Dung lượng ban đầu của buffer vòng mỗi kết nối
+    const size_t CLIENT_TABLE_SHARDS = 16; // Số shard của bảng client (lũy thừa của 2)
+    const size_t OUTBOUND_LIMIT_BYTES = 256 * 1024; // Giới hạn dữ liệu chờ gửi của mỗi kết nối
+    const uint32_t SLOW_CONSUMER_TIMEOUT_MS = 10000; // Thời gian tối đa được vượt giới hạn trước khi bị ngắt
+    const size_t WORKER_QUEUE_CAPACITY = 1024; // Số công việc tối đa chờ trong hàng đợi của mỗi worker
+    const int BACKLOG = 1024; // Hàng đợi kết nối chờ của mỗi socket lắng nghe (SO_REUSEPORT)
+    const size_t LIST_PAGE_ITEMS = 64; // Số phần tử tối đa trong mỗi trang của danh sách phân trang (v2)
+    const size_t COMPRESSION_THRESHOLD = 512; // Payload v2 từ ngần này byte trở lên được nén (0: tắt)
 
     // Game constants
     const uint16_t DEFAULT_ELO = 1200;
     const uint16_t DEFAULT_TIME = 300; // 5 minutes
     const uint16_t DEFAULT_INCREMENT = 5; // 5 seconds
+    const uint32_t KEYFRAME_INTERVAL = 16; // Số nửa nước giữa hai keyframe gửi cho client v2
 
     // Matchmaking constants
-    const uint16_t ELO_THRESHOLD = 300;
+    const uint16_t ELO_THRESHOLD = 300;      // Chênh lệch ELO cho phép ngay khi vào hàng đợi
+    const uint16_t ELO_THRESHOLD_MAX = 800;  // Chênh lệch tối đa khi cửa sổ đã nới hết
+    const uint16_t ELO_WINDOW_GROWTH = 50;   // Số điểm ELO cửa sổ nới thêm sau mỗi giây chờ
 }
 
 enum class GameResult
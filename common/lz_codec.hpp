@@ -0,0 +1,218 @@
+#ifndef LZ_CODEC_HPP
+#define LZ_CODEC_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+/**
+ * @brief Bộ nén LZ77 nhỏ gọn cho payload của frame v2, không phụ thuộc thư viện ngoài.
+ *
+ * Định dạng khối (giống LZ4): dãy các chuỗi [token][độ dài literal mở rộng][literal]
+ * [offset 2 byte little-endian][độ dài match mở rộng]. Nửa cao của token là số literal,
+ * nửa thấp là độ dài match trừ MIN_MATCH; giá trị 15 được cộng thêm các byte tiếp theo
+ * cho đến khi gặp byte khác 255. Chuỗi cuối cùng chỉ có literal (không có offset).
+ *
+ * Bộ nén dùng bảng băm 4 byte một chiều, chỉ tìm một ứng viên cho mỗi vị trí: nhanh và
+ * đủ tốt cho dữ liệu lặp nhiều như tên người chơi, FEN, game_id.
+ */
+namespace Lz
+{
+    const size_t MIN_MATCH = 4;
+    const size_t MAX_OFFSET = 65535;
+    const int HASH_BITS = 12;
+
+    // Kích thước tối đa của dữ liệu nén cho size byte đầu vào (trường hợp không nén được)
+    inline size_t compressBound(size_t size)
+    {
+        return size + size / 255 + 16;
+    }
+
+    // Kích thước tối đa sau giải nén của size byte dữ liệu nén: mỗi byte độ dài mở rộng thêm tối đa 255 byte
+    inline size_t decompressBound(size_t size)
+    {
+        return size * 255 + 16;
+    }
+
+    namespace detail
+    {
+        inline uint32_t load32(const uint8_t *in)
+        {
+            uint32_t value;
+            std::memcpy(&value, in, sizeof(value));
+            return value;
+        }
+
+        inline uint32_t hash(uint32_t sequence)
+        {
+            return (sequence * 2654435761u) >> (32 - HASH_BITS);
+        }
+
+        inline uint8_t *storeLength(uint8_t *out, size_t length)
+        {
+            while (length >= 255)
+            {
+                *out++ = 255;
+                length -= 255;
+            }
+            *out++ = static_cast<uint8_t>(length);
+            return out;
+        }
+
+        inline bool loadLength(const uint8_t *in, size_t size, size_t &pos, size_t &length, size_t limit)
+        {
+            uint8_t byte;
+            do
+            {
+                if (pos >= size)
+                {
+                    return false;
+                }
+                byte = in[pos++];
+                length += byte;
+                if (length > limit)
+                {
+                    return false;
+                }
+            } while (byte == 255);
+            return true;
+        }
+
+        // Ghi một chuỗi: literal [literal, literal + literal_length) rồi match (bỏ qua nếu match_length = 0)
+        inline uint8_t *storeSequence(uint8_t *out, const uint8_t *literal, size_t literal_length,
+                                      size_t offset, size_t match_length)
+        {
+            uint8_t *token = out++;
+            size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+            *token = static_cast<uint8_t>(((literal_length < 15 ? literal_length : 15) << 4) |
+                                          (match_code < 15 ? match_code : 15));
+            if (literal_length >= 15)
+            {
+                out = storeLength(out, literal_length - 15);
+            }
+            std::memcpy(out, literal, literal_length);
+            out += literal_length;
+
+            if (match_length == 0)
+            {
+                return out;
+            }
+            *out++ = static_cast<uint8_t>(offset & 0xFF);
+            *out++ = static_cast<uint8_t>(offset >> 8);
+            if (match_code >= 15)
+            {
+                out = storeLength(out, match_code - 15);
+            }
+            return out;
+        }
+    }
+
+    /**
+     * @brief Nén size byte từ in vào out.
+     *
+     * @param out Buffer đủ chỗ cho compressBound(size) byte.
+     * @return Số byte đã ghi.
+     */
+    inline size_t compress(const uint8_t *in, size_t size, uint8_t *out)
+    {
+        uint32_t table[1 << HASH_BITS] = {};
+        uint8_t *op = out;
+        size_t anchor = 0;
+        size_t pos = 0;
+
+        while (pos + MIN_MATCH <= size)
+        {
+            uint32_t sequence = detail::load32(in + pos);
+            uint32_t &slot = table[detail::hash(sequence)];
+            size_t candidate = slot;
+            slot = static_cast<uint32_t>(pos);
+
+            if (candidate >= pos || pos - candidate > MAX_OFFSET || detail::load32(in + candidate) != sequence)
+            {
+                ++pos;
+                continue;
+            }
+
+            size_t match_length = MIN_MATCH;
+            while (pos + match_length < size && in[candidate + match_length] == in[pos + match_length])
+            {
+                ++match_length;
+            }
+
+            op = detail::storeSequence(op, in + anchor, pos - anchor, pos - candidate, match_length);
+            pos += match_length;
+            anchor = pos;
+        }
+
+        op = detail::storeSequence(op, in + anchor, size - anchor, 0, 0);
+        return static_cast<size_t>(op - out);
+    }
+
+    /**
+     * @brief Giải nén khối nén vào đúng out_size byte.
+     *
+     * Mọi độ dài và offset đều được kiểm tra giới hạn, dữ liệu hỏng không thể ghi ra ngoài out.
+     *
+     * @return false nếu dữ liệu hỏng hoặc kích thước giải nén khác out_size.
+     */
+    inline bool decompress(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size)
+    {
+        size_t ip = 0;
+        size_t op = 0;
+        while (ip < in_size)
+        {
+            uint8_t token = in[ip++];
+
+            size_t literal_length = token >> 4;
+            if (literal_length == 15 && !detail::loadLength(in, in_size, ip, literal_length, out_size))
+            {
+                return false;
+            }
+            if (literal_length > in_size - ip || literal_length > out_size - op)
+            {
+                return false;
+            }
+            std::memcpy(out + op, in + ip, literal_length);
+            ip += literal_length;
+            op += literal_length;
+
+            if (ip == in_size)
+            {
+                break; // Chuỗi cuối chỉ có literal
+            }
+
+            if (in_size - ip < 2)
+            {
+                return false;
+            }
+            size_t offset = static_cast<size_t>(in[ip]) | (static_cast<size_t>(in[ip + 1]) << 8);
+            ip += 2;
+            if (offset == 0 || offset > op)
+            {
+                return false;
+            }
+
+            size_t match_length = token & 0x0F;
+            if (match_length == 15 && !detail::loadLength(in, in_size, ip, match_length, out_size))
+            {
+                return false;
+            }
+            match_length += MIN_MATCH;
+            if (match_length > out_size - op)
+            {
+                return false;
+            }
+
+            // Vùng match có thể chồng lên phần đang ghi (offset < độ dài), phải chép từng byte
+            const uint8_t *match = out + op - offset;
+            for (size_t i = 0; i < match_length; ++i)
+            {
+                out[op + i] = match[i];
+            }
+            op += match_length;
+        }
+        return op == out_size;
+    }
+}
+
+#endif // LZ_CODEC_HPP
@@ -1,183 +1,461 @@
 #ifndef MESSAGE_HPP
 #define MESSAGE_HPP
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 
 #include "utils.hpp"
 #include "protocol.hpp"
-
-#pragma region RegisterMessage 
-// RegisterMessage 
-/*
-Send from client to server to register a new user.
-
-Payload structure:
-    - uint8_t username_length (1 byte)
-    - char[username_length] username (username_length bytes)
-*/
-struct RegisterMessage
+#include "message_schema.hpp"
+
+/**
+ * @brief Con trỏ đọc tuần tự trên payload, không sao chép và không cấp phát.
+ *
+ * Dùng cho các bộ giải mã sinh từ Schema: chuỗi được trả về dưới dạng std::string_view trỏ
+ * thẳng vào payload. Mọi hàm đọc kiểm tra giới hạn và trả về false khi payload bị cắt cụt.
+ */
+class PayloadReader
 {
-    std::string username;
+public:
+    PayloadReader(const uint8_t *data, size_t size, uint8_t version)
+        : data(data), size(size), pos(0), version_(version)
+    {
+    }
 
-    MessageType getType() const
+    bool readU8(uint8_t &value)
     {
-        return MessageType::REGISTER;
+        if (pos >= size)
+        {
+            return false;
+        }
+        value = data[pos++];
+        return true;
     }
 
-    std::vector<uint8_t> serialize() const
+    bool readU16(uint16_t &value)
     {
-        std::vector<uint8_t> payload;
+        if (size - pos < 2)
+        {
+            return false;
+        }
+        value = load_big_endian_16(data + pos);
+        pos += 2;
+        return true;
+    }
 
-        payload.push_back(static_cast<uint8_t>(username.size()));
-        payload.insert(payload.end(), username.begin(), username.end());
+    // Số nguyên varint (dùng cho handle, số thứ tự nước đi), không phụ thuộc phiên bản
+    bool readVarint(uint64_t &value)
+    {
+        return read_varint(data, size, pos, value);
+    }
 
-        return payload;
+    bool readBytes(uint8_t *out, size_t length)
+    {
+        if (size - pos < length)
+        {
+            return false;
+        }
+        std::memcpy(out, data + pos, length);
+        pos += length;
+        return true;
     }
 
-    static RegisterMessage deserialize(const std::vector<uint8_t> &payload)
+    // Độ dài chuỗi và số phần tử: 1 byte ở v1, varint ở v2 (không vượt quá số byte còn lại)
+    bool readLength(size_t &length)
     {
-        RegisterMessage message;
+        if (version_ < Protocol::V2)
+        {
+            uint8_t byte;
+            if (!readU8(byte))
+            {
+                return false;
+            }
+            length = byte;
+            return true;
+        }
 
-        size_t pos = 0;
-        uint8_t username_length = payload[pos++];
-        message.username = std::string(payload.begin() + pos, payload.begin() + pos + username_length);
+        uint64_t value;
+        if (!read_varint(data, size, pos, value) || value > size - pos)
+        {
+            return false;
+        }
+        length = static_cast<size_t>(value);
+        return true;
+    }
 
-        return message;
+    bool readString(std::string_view &value)
+    {
+        size_t length;
+        if (!readLength(length) || length > size - pos)
+        {
+            return false;
+        }
+        value = std::string_view(reinterpret_cast<const char *>(data + pos), length);
+        pos += length;
+        return true;
     }
-};
-#pragma endregion RegisterMessage
 
-#pragma region RegisterSuccessMessage 
-/*
-Send from server to client to notify that the registration was successful.
+    // Chuỗi game_id ở v1, handle varint ở v2
+    bool readGameId(std::string_view &game_id, uint64_t &game_handle)
+    {
+        if (version_ < Protocol::V2)
+        {
+            return readString(game_id);
+        }
+        return readVarint(game_handle);
+    }
 
-Payload structure:
-    - uint8_t username_length (1 byte)
-    - char[username_length] username (username_length bytes)
-    - uint16_t elo (2 bytes)
-*/
-struct RegisterSuccessMessage
+    bool atEnd() const { return pos >= size; }
+    uint8_t version() const { return version_; }
+
+private:
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    uint8_t version_;
+};
+
+/**
+ * @brief Đếm số byte payload mà Fields::write của một thông điệp sẽ ghi, không ghi gì cả.
+ *
+ * Cùng giao diện với PayloadWriter để mỗi thông điệp chỉ mô tả các trường một lần.
+ */
+class PayloadSizer
 {
-    std::string username;
-    uint16_t elo;
+public:
+    explicit PayloadSizer(uint8_t version) : size_(0), version_(version) {}
 
-    MessageType getType() const
+    void writeU8(uint8_t) { size_ += 1; }
+    void writeU16(uint16_t) { size_ += 2; }
+    void writeU32(uint32_t) { size_ += 4; }
+    void writeVarint(uint64_t value) { size_ += varint_size(value); }
+    void writeBytes(const uint8_t *, size_t length) { size_ += length; }
+
+    void writeLength(size_t length)
     {
-        return MessageType::REGISTER_SUCCESS;
+        size_ += version_ >= Protocol::V2 ? varint_size(length) : 1;
     }
 
-    std::vector<uint8_t> serialize() const
+    void writeString(std::string_view value)
     {
-        std::vector<uint8_t> payload;
+        value = value.substr(0, max_string_size(version_));
+        writeLength(value.size());
+        size_ += value.size();
+    }
 
-        payload.push_back(static_cast<uint8_t>(username.size()));
-        payload.insert(payload.end(), username.begin(), username.end());
+    void writeGameId(std::string_view game_id, uint64_t game_handle)
+    {
+        if (version_ >= Protocol::V2)
+            writeVarint(game_handle);
+        else
+            writeString(game_id);
+    }
+
+    uint8_t version() const { return version_; }
+    size_t size() const { return size_; }
+
+private:
+    size_t size_;
+    uint8_t version_;
+};
+
+/**
+ * @brief Ghi payload thẳng vào buffer của người gọi, không cấp phát.
+ *
+ * Buffer phải có đủ chỗ cho số byte PayloadSizer đã đếm.
+ */
+class PayloadWriter
+{
+public:
+    PayloadWriter(uint8_t *out, uint8_t version) : out(out), version_(version) {}
+
+    void writeU8(uint8_t value) { *out++ = value; }
+    void writeU16(uint16_t value) { out = store_big_endian_16(out, value); }
+    void writeU32(uint32_t value) { out = store_big_endian_32(out, value); }
+    void writeVarint(uint64_t value) { out = store_varint(out, value); }
+
+    void writeBytes(const uint8_t *data, size_t length)
+    {
+        std::memcpy(out, data, length);
+        out += length;
+    }
 
-        std::vector<uint8_t> elo_bytes = to_big_endian_16(elo);
-        payload.insert(payload.end(), elo_bytes.begin(), elo_bytes.end());
+    void writeLength(size_t length)
+    {
+        if (version_ >= Protocol::V2)
+        {
+            out = store_varint(out, length);
+        }
+        else
+        {
+            *out++ = static_cast<uint8_t>(length);
+        }
+    }
 
-        return payload;
+    void writeString(std::string_view value)
+    {
+        value = value.substr(0, max_string_size(version_));
+        writeLength(value.size());
+        if (!value.empty())
+        {
+            std::memcpy(out, value.data(), value.size());
+            out += value.size();
+        }
     }
 
-    static RegisterSuccessMessage deserialize(const std::vector<uint8_t> &payload)
+    // Định danh ván cờ trên dây: chuỗi game_id ở v1, handle varint ở v2
+    void writeGameId(std::string_view game_id, uint64_t game_handle)
     {
-        RegisterSuccessMessage message;
+        if (version_ >= Protocol::V2)
+            writeVarint(game_handle);
+        else
+            writeString(game_id);
+    }
 
-        size_t pos = 0;
-        uint8_t username_length = payload[pos++];
-        message.username = std::string(payload.begin() + pos, payload.begin() + pos + username_length);
+    uint8_t version() const { return version_; }
+    uint8_t *position() const { return out; }
+
+private:
+    uint8_t *out;
+    uint8_t version_;
+};
+
+// Kích thước payload chính xác của thông điệp ở phiên bản đã cho
+template <typename Message>
+size_t payloadSize(const Message &message, uint8_t version)
+{
+    PayloadSizer sizer(version);
+    Message::Fields::write(message, sizer);
+    return sizer.size();
+}
+
+// Kích thước chính xác của cả frame (header + payload)
+template <typename Message>
+size_t encodedSize(const Message &message, uint8_t version, uint32_t request_id = Protocol::NO_REQUEST_ID)
+{
+    size_t payload_size = payloadSize(message, version);
+    return frameHeaderSize(payload_size, version, request_id) + payload_size;
+}
+
+/**
+ * @brief Ghi header và payload của thông điệp vào out trong một lượt.
+ *
+ * @param out Buffer của người gọi, đủ chỗ cho encodedSize(message, version, request_id) byte.
+ * @param request_id Request ID ghi vào header v2 (bỏ qua ở v1).
+ * @return Số byte đã ghi.
+ */
+template <typename Message>
+size_t encodeTo(const Message &message, uint8_t *out, uint8_t version, uint32_t request_id = Protocol::NO_REQUEST_ID)
+{
+    size_t payload_size = payloadSize(message, version);
+    PayloadWriter writer(storeFrameHeader(out, message.getType(), payload_size, version, request_id), version);
+    Message::Fields::write(message, writer);
+    return static_cast<size_t>(writer.position() - out);
+}
+
+// Chỉ payload, dưới dạng vector (giao diện serialize() cũ)
+template <typename Message>
+std::vector<uint8_t> serializeMessage(const Message &message, uint8_t version)
+{
+    std::vector<uint8_t> payload(payloadSize(message, version));
+    PayloadWriter writer(payload.data(), version);
+    Message::Fields::write(message, writer);
+    return payload;
+}
+
+/**
+ * @brief serialize(), decode() và deserialize() chung cho mọi thông điệp, sinh từ Derived::Fields.
+ *
+ * Thông điệp chỉ cần khai báo các trường, Fields và getType(). Thông điệp có chuỗi là template
+ * theo kiểu chuỗi: bản std::string sở hữu dữ liệu, bản std::string_view là view không sao chép
+ * (chỉ hợp lệ khi buffer payload còn sống).
+ */
+template <typename Derived>
+struct MessageCodec
+{
+    std::vector<uint8_t> serialize(uint8_t version = Protocol::V1) const
+    {
+        return serializeMessage(static_cast<const Derived &>(*this), version);
+    }
 
-        pos += username_length;
-        message.elo = from_big_endian_16(payload, pos);
+    // Giải mã có kiểm tra giới hạn; false nếu payload bị cắt cụt hoặc sai
+    static bool decode(const uint8_t *data, size_t size, Derived &message, uint8_t version = Protocol::V1)
+    {
+        PayloadReader reader(data, size, version);
+        return Derived::Fields::read(message, reader);
+    }
 
+    // Không bao giờ đọc quá payload; payload hỏng để các trường chưa đọc được ở giá trị mặc định
+    static Derived deserialize(const std::vector<uint8_t> &payload, uint8_t version = Protocol::V1)
+    {
+        Derived message{};
+        decode(payload.data(), payload.size(), message, version);
         return message;
     }
 };
-#pragma endregion RegisterSuccessMessage
 
-#pragma region RegisterFailureMessage 
+#pragma region HelloMessage
 /*
-Send from server to client to notify that the registration was unsuccessful.
+Send from client to server right after connecting, always in a v1 frame.
 
 Payload structure:
-    - uint8_t error_message_length (1 byte)
-    - char[error_message_length] error_message (error_message_length bytes)
+    - uint8_t max_version (1 byte)
 */
-struct RegisterFailureMessage
+struct HelloMessage : MessageCodec<HelloMessage>
 {
-    std::string error_message;
+    uint8_t max_version = Protocol::LATEST;
+
+    using Fields = Schema::Fields<
+        Schema::U8<&HelloMessage::max_version>>;
 
     MessageType getType() const
     {
-        return MessageType::REGISTER_FAILURE;
+        return MessageType::HELLO;
     }
 
-    std::vector<uint8_t> serialize() const
+    // Payload rỗng: client chỉ biết v1
+    static HelloMessage deserialize(const std::vector<uint8_t> &payload, uint8_t version = Protocol::V1)
     {
-        std::vector<uint8_t> payload;
+        HelloMessage message;
+        message.max_version = Protocol::V1;
+        decode(payload.data(), payload.size(), message, version);
+        return message;
+    }
+};
+#pragma endregion HelloMessage
 
-        payload.push_back(static_cast<uint8_t>(error_message.size()));
-        payload.insert(payload.end(), error_message.begin(), error_message.end());
+#pragma region HelloAckMessage
+/*
+Send from server to client to confirm the protocol version, always in a v1 frame.
+Both sides use the chosen version for every frame after this one.
 
-        return payload;
-    }
+Payload structure:
+    - uint8_t version (1 byte)
+*/
+struct HelloAckMessage : MessageCodec<HelloAckMessage>
+{
+    uint8_t version = Protocol::V1;
 
-    static RegisterFailureMessage deserialize(const std::vector<uint8_t> &payload)
+    using Fields = Schema::Fields<
+        Schema::U8<&HelloAckMessage::version>>;
+
+    MessageType getType() const
     {
-        RegisterFailureMessage message;
+        return MessageType::HELLO_ACK;
+    }
+};
+#pragma endregion HelloAckMessage
 
-        size_t pos = 0;
-        uint8_t error_message_length = payload[pos++];
-        message.error_message = std::string(payload.begin() + pos, payload.begin() + pos + error_message_length);
+#pragma region RegisterMessage
+// RegisterMessage
+/*
+Send from client to server to register a new user.
 
-        return message;
+Payload structure:
+    - uint8_t username_length (1 byte)
+    - char[username_length] username (username_length bytes)
+*/
+template <typename Text>
+struct BasicRegisterMessage : MessageCodec<BasicRegisterMessage<Text>>
+{
+    Text username;
+
+    using Fields = Schema::Fields<
+        Schema::String<&BasicRegisterMessage::username>>;
+
+    MessageType getType() const
+    {
+        return MessageType::REGISTER;
     }
 };
-#pragma endregion RegisterFailureMessage
 
-#pragma region LoginMessage 
+using RegisterMessage = BasicRegisterMessage<std::string>;
+#pragma endregion RegisterMessage
+
+#pragma region RegisterSuccessMessage
 /*
-Send from client to server to login.
+Send from server to client to notify that the registration was successful.
 
 Payload structure:
     - uint8_t username_length (1 byte)
     - char[username_length] username (username_length bytes)
+    - uint16_t elo (2 bytes)
 */
-struct LoginMessage
+template <typename Text>
+struct BasicRegisterSuccessMessage : MessageCodec<BasicRegisterSuccessMessage<Text>>
 {
-    std::string username;
+    Text username;
+    uint16_t elo;
+
+    using Fields = Schema::Fields<
+        Schema::String<&BasicRegisterSuccessMessage::username>,
+        Schema::U16<&BasicRegisterSuccessMessage::elo>>;
 
     MessageType getType() const
     {
-        return MessageType::LOGIN;
+        return MessageType::REGISTER_SUCCESS;
     }
+};
 
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
+using RegisterSuccessMessage = BasicRegisterSuccessMessage<std::string>;
+#pragma endregion RegisterSuccessMessage
 
-        payload.push_back(static_cast<uint8_t>(username.size()));
-        payload.insert(payload.end(), username.begin(), username.end());
+#pragma region RegisterFailureMessage
+/*
+Send from server to client to notify that the registration was unsuccessful.
 
-        return payload;
-    }
+Payload structure:
+    - uint8_t error_message_length (1 byte)
+    - char[error_message_length] error_message (error_message_length bytes)
+*/
+template <typename Text>
+struct BasicRegisterFailureMessage : MessageCodec<BasicRegisterFailureMessage<Text>>
+{
+    Text error_message;
+
+    using Fields = Schema::Fields<
+        Schema::String<&BasicRegisterFailureMessage::error_message>>;
 
-    static LoginMessage deserialize(const std::vector<uint8_t> &payload)
+    MessageType getType() const
     {
-        LoginMessage message;
+        return MessageType::REGISTER_FAILURE;
+    }
+};
 
-        size_t pos = 0;
-        uint8_t username_length = payload[pos++];
-        message.username = std::string(payload.begin() + pos, payload.begin() + pos + username_length);
+using RegisterFailureMessage = BasicRegisterFailureMessage<std::string>;
+#pragma endregion RegisterFailureMessage
 
-        return message;
+#pragma region LoginMessage
+/*
+Send from client to server to login.
+
+Payload structure:
+    - uint8_t username_length (1 byte)
+    - char[username_length] username (username_length bytes)
+*/
+template <typename Text>
+struct BasicLoginMessage : MessageCodec<BasicLoginMessage<Text>>
+{
+    Text username;
+
+    using Fields = Schema::Fields<
+        Schema::String<&BasicLoginMessage::username>>;
+
+    MessageType getType() const
+    {
+        return MessageType::LOGIN;
     }
 };
+
+using LoginMessage = BasicLoginMessage<std::string>;
 #pragma endregion LoginMessage
 
-#pragma region LoginSuccessMessage 
+#pragma region LoginSuccessMessage
 /*
 Send from server to client to notify that the login was successful.
 
@@ -186,43 +464,25 @@ Payload structure:
     - char[username_length] username (username_length bytes)
     - uint16_t elo (2 bytes)
 */
-struct LoginSuccessMessage
+template <typename Text>
+struct BasicLoginSuccessMessage : MessageCodec<BasicLoginSuccessMessage<Text>>
 {
-    std::string username;
+    Text username;
     uint16_t elo;
 
+    using Fields = Schema::Fields<
+        Schema::String<&BasicLoginSuccessMessage::username>,
+        Schema::U16<&BasicLoginSuccessMessage::elo>>;
+
     MessageType getType() const
     {
         return MessageType::LOGIN_SUCCESS;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-        payload.push_back(static_cast<uint8_t>(username.size()));
-        payload.insert(payload.end(), username.begin(), username.end());
-
-        std::vector<uint8_t> elo_bytes = to_big_endian_16(elo);
-        payload.insert(payload.end(), elo_bytes.begin(), elo_bytes.end());
-        return payload;
-    }
-
-    static LoginSuccessMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        LoginSuccessMessage message;
-
-        size_t pos = 0;
-        uint8_t username_length = payload[pos++];
-        message.username = std::string(payload.begin() + pos, payload.begin() + pos + username_length);
-
-        pos += username_length;
-        message.elo = from_big_endian_16(payload, pos);
-
-        return message;
-    }
 };
 
-#pragma region LoginFailureMessage 
+using LoginSuccessMessage = BasicLoginSuccessMessage<std::string>;
+
+#pragma region LoginFailureMessage
 /*
 Send from server to client to notify that the login was unsuccessful.
 
@@ -230,39 +490,24 @@ Payload structure:
     - uint8_t error_message_length (1 byte)
     - char[error_message_length] error_message (error_message_length bytes)
 */
-struct LoginFailureMessage
+template <typename Text>
+struct BasicLoginFailureMessage : MessageCodec<BasicLoginFailureMessage<Text>>
 {
-    std::string error_message;
+    Text error_message;
+
+    using Fields = Schema::Fields<
+        Schema::String<&BasicLoginFailureMessage::error_message>>;
 
     MessageType getType() const
     {
         return MessageType::LOGIN_FAILURE;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(error_message.size()));
-        payload.insert(payload.end(), error_message.begin(), error_message.end());
-
-        return payload;
-    }
-
-    static LoginFailureMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        LoginFailureMessage message;
-
-        size_t pos = 0;
-        uint8_t error_message_length = payload[pos++];
-        message.error_message = std::string(payload.begin() + pos, payload.begin() + pos + error_message_length);
-
-        return message;
-    }
 };
+
+using LoginFailureMessage = BasicLoginFailureMessage<std::string>;
 #pragma endregion LoginFailureMessage
 
-#pragma region GameStartMessage 
+#pragma region GameStartMessage
 /*
 Send from server to clients to notify that a new game has started.
 
@@ -277,178 +522,141 @@ Payload structure:
     - char[starting_player_username_length] starting_player_username (starting_player_username_length bytes)
     - uint8_t fen_length (1 byte)
     - char[fen_length] fen (fen_length bytes)
+    - varint game_handle (v2 only, used by MoveV2Message)
 */
-struct GameStartMessage
+template <typename Text>
+struct BasicGameStartMessage : MessageCodec<BasicGameStartMessage<Text>>
 {
-    std::string game_id;
-    std::string player1_username;
-    std::string player2_username;
-    std::string starting_player_username;
-    std::string fen;
+    Text game_id;
+    Text player1_username;
+    Text player2_username;
+    Text starting_player_username;
+    Text fen;
+    uint64_t game_handle = 0;
+
+    using Fields = Schema::Fields<
+        Schema::String<&BasicGameStartMessage::game_id>,
+        Schema::String<&BasicGameStartMessage::player1_username>,
+        Schema::String<&BasicGameStartMessage::player2_username>,
+        Schema::String<&BasicGameStartMessage::starting_player_username>,
+        Schema::String<&BasicGameStartMessage::fen>,
+        Schema::V2Only<Schema::Optional<Schema::Varint<&BasicGameStartMessage::game_handle>>>>;
 
     MessageType getType() const
     {
         return MessageType::GAME_START;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(game_id.size()));
-        payload.insert(payload.end(), game_id.begin(), game_id.end());
-
-        payload.push_back(static_cast<uint8_t>(player1_username.size()));
-        payload.insert(payload.end(), player1_username.begin(), player1_username.end());
-
-        payload.push_back(static_cast<uint8_t>(player2_username.size()));
-        payload.insert(payload.end(), player2_username.begin(), player2_username.end());
-
-        payload.push_back(static_cast<uint8_t>(starting_player_username.size()));
-        payload.insert(payload.end(), starting_player_username.begin(), starting_player_username.end());
-
-        payload.push_back(static_cast<uint8_t>(fen.size()));
-        payload.insert(payload.end(), fen.begin(), fen.end());
-
-        return payload;
-    }
-
-    static GameStartMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        GameStartMessage message;
-
-        size_t pos = 0;
-        uint8_t game_id_length = payload[pos++];
-        message.game_id = std::string(payload.begin() + pos, payload.begin() + pos + game_id_length);
-
-        pos += game_id_length;
-        uint8_t player1_username_length = payload[pos++];
-        message.player1_username = std::string(payload.begin() + pos, payload.begin() + pos + player1_username_length);
-
-        pos += player1_username_length;
-        uint8_t player2_username_length = payload[pos++];
-        message.player2_username = std::string(payload.begin() + pos, payload.begin() + pos + player2_username_length);
-
-        pos += player2_username_length;
-        uint8_t starting_player_username_length = payload[pos++];
-        message.starting_player_username = std::string(payload.begin() + pos, payload.begin() + pos + starting_player_username_length);
-
-        pos += starting_player_username_length;
-        uint8_t fen_length = payload[pos++];
-        message.fen = std::string(payload.begin() + pos, payload.begin() + pos + fen_length);
-
-        return message;
-    }
 };
+
+using GameStartMessage = BasicGameStartMessage<std::string>;
 #pragma endregion GameStartMessage
 
-#pragma region MoveMessage 
+#pragma region MoveMessage
 /*
 Send from client to server to make a move.
 
 Payload structure:
     - uint8_t game_id_length (1 byte)
     - char[game_id_length] game_id (game_id_length bytes)
+      (v2: varint game_handle instead of game_id)
     - uint8_t uci_move_length (1 byte)
     - char[uci_move_length] uci_move (uci_move_length bytes)
 */
-struct MoveMessage
+template <typename Text>
+struct BasicMoveMessage : MessageCodec<BasicMoveMessage<Text>>
 {
-    std::string game_id;
-    std::string uci_move;
+    Text game_id;
+    uint64_t game_handle = 0;
+    Text uci_move;
+
+    using Fields = Schema::Fields<
+        Schema::GameId<&BasicMoveMessage::game_id, &BasicMoveMessage::game_handle>,
+        Schema::String<&BasicMoveMessage::uci_move>>;
 
     MessageType getType() const
     {
         return MessageType::MOVE;
     }
+};
 
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(game_id.size()));
-        payload.insert(payload.end(), game_id.begin(), game_id.end());
-
-        payload.push_back(static_cast<uint8_t>(uci_move.size()));
-        payload.insert(payload.end(), uci_move.begin(), uci_move.end());
+using MoveMessage = BasicMoveMessage<std::string>;
 
-        return payload;
-    }
+/*
+Zero-copy view of MoveMessage: game_id and uci_move point into the payload and are only
+valid while the payload buffer is alive.
+*/
+using MoveMessageView = BasicMoveMessage<std::string_view>;
+#pragma endregion MoveMessage
 
-    static MoveMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        MoveMessage message;
+#pragma region MoveV2Message
+/*
+Send from client to server to make a move without any string in the payload.
+The server looks the game up by handle, rejects the move if ply is not the current ply of the
+game (stale or duplicated move) and checks the raw move against the legal move list.
+Chỉ có trường số nên thông điệp tự làm view của chính nó.
 
-        size_t pos = 0;
-        uint8_t game_id_length = payload[pos++];
-        message.game_id = std::string(payload.begin() + pos, payload.begin() + pos + game_id_length);
+Payload structure:
+    - varint game_handle (from GameStartMessage)
+    - varint ply (number of half moves played before this move, derived from the FEN)
+    - uint16_t move (chess::Move::move(): from, to, promotion piece and move type)
+*/
+struct MoveV2Message : MessageCodec<MoveV2Message>
+{
+    uint64_t game_handle = 0;
+    uint32_t ply = 0;
+    uint16_t move = 0;
 
-        pos += game_id_length;
-        uint8_t uci_move_length = payload[pos++];
-        message.uci_move = std::string(payload.begin() + pos, payload.begin() + pos + uci_move_length);
+    using Fields = Schema::Fields<
+        Schema::Varint<&MoveV2Message::game_handle>,
+        Schema::Varint<&MoveV2Message::ply>,
+        Schema::U16<&MoveV2Message::move>>;
 
-        return message;
+    MessageType getType() const
+    {
+        return MessageType::MOVE_V2;
     }
 };
-#pragma endregion MoveMessage
+#pragma endregion MoveV2Message
 
-#pragma region InvalidMoveMessage 
+#pragma region InvalidMoveMessage
 /*
 Send from server to client to notify that the move was invalid.
 
 Payload structure:
     - uint8_t game_id_length (1 byte)
     - char[game_id_length] game_id (game_id_length bytes)
+      (v2: varint game_handle instead of game_id)
     - uint8_t error_message_length (1 byte)
     - char[error_message_length] error_message (error_message_length bytes)
 */
-struct InvalidMoveMessage
+template <typename Text>
+struct BasicInvalidMoveMessage : MessageCodec<BasicInvalidMoveMessage<Text>>
 {
-    std::string game_id;
-    std::string error_message;
+    Text game_id;
+    uint64_t game_handle = 0;
+    Text error_message;
+
+    using Fields = Schema::Fields<
+        Schema::GameId<&BasicInvalidMoveMessage::game_id, &BasicInvalidMoveMessage::game_handle>,
+        Schema::String<&BasicInvalidMoveMessage::error_message>>;
 
     MessageType getType() const
     {
         return MessageType::INVALID_MOVE;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(game_id.size()));
-        payload.insert(payload.end(), game_id.begin(), game_id.end());
-
-        payload.push_back(static_cast<uint8_t>(error_message.size()));
-        payload.insert(payload.end(), error_message.begin(), error_message.end());
-
-        return payload;
-    }
-
-    static InvalidMoveMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        InvalidMoveMessage message;
-
-        size_t pos = 0;
-        uint8_t game_id_length = payload[pos++];
-        message.game_id = std::string(payload.begin() + pos, payload.begin() + pos + game_id_length);
-
-        pos += game_id_length;
-        uint8_t error_message_length = payload[pos++];
-        message.error_message = std::string(payload.begin() + pos, payload.begin() + pos + error_message_length);
-
-        return message;
-    }
 };
+
+using InvalidMoveMessage = BasicInvalidMoveMessage<std::string>;
 #pragma endregion InvalidMoveMessage
 
-#pragma region GameStatusUpdateMessage 
+#pragma region GameStatusUpdateMessage
 /*
 Send from server to clients to notify that the game status has been updated.
 
 Payload structure:
     - uint8_t game_id_length (1 byte)
     - char[game_id_length] game_id (game_id_length bytes)
+      (v2: varint game_handle instead of game_id)
 
     - uint8_t fen_length (1 byte)
     - char[fen_length] fen (fen_length bytes)
@@ -461,74 +669,128 @@ Payload structure:
     - uint8_t message_length (1 byte)
     - char[message_length] message (message_length bytes)
 */
-struct GameStatusUpdateMessage
+template <typename Text>
+struct BasicGameStatusUpdateMessage : MessageCodec<BasicGameStatusUpdateMessage<Text>>
 {
-    std::string game_id;
-    std::string fen;
-    std::string current_turn_username;
+    Text game_id;
+    uint64_t game_handle = 0;
+    Text fen;
+    Text current_turn_username;
     uint8_t is_game_over;
-    std::string message;
+    Text message;
+
+    using Fields = Schema::Fields<
+        Schema::GameId<&BasicGameStatusUpdateMessage::game_id, &BasicGameStatusUpdateMessage::game_handle>,
+        Schema::String<&BasicGameStatusUpdateMessage::fen>,
+        Schema::String<&BasicGameStatusUpdateMessage::current_turn_username>,
+        Schema::U8<&BasicGameStatusUpdateMessage::is_game_over>,
+        Schema::String<&BasicGameStatusUpdateMessage::message>>;
 
     MessageType getType() const
     {
         return MessageType::GAME_STATUS_UPDATE;
     }
+};
 
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
+using GameStatusUpdateMessage = BasicGameStatusUpdateMessage<std::string>;
+#pragma endregion GameStatusUpdateMessage
 
-        payload.push_back(static_cast<uint8_t>(game_id.size()));
-        payload.insert(payload.end(), game_id.begin(), game_id.end());
+#pragma region GameMoveDeltaMessage
+/*
+Send from server to v2 players after every move instead of GameStatusUpdateMessage.
+The client applies the move to its own chess::Board; the side to move follows from the board.
+If ply is not the client's ply + 1 the client sends ResyncRequestMessage.
 
-        payload.push_back(static_cast<uint8_t>(fen.size()));
-        payload.insert(payload.end(), fen.begin(), fen.end());
+Payload structure:
+    - varint game_handle
+    - varint ply (number of half moves played after this move)
+    - uint16_t move (chess::Move::move())
+    - uint8_t flags (GameMoveDeltaMessage::CHECK, GameMoveDeltaMessage::GAME_OVER)
+*/
+struct GameMoveDeltaMessage : MessageCodec<GameMoveDeltaMessage>
+{
+    static constexpr uint8_t CHECK = 0x01;
+    static constexpr uint8_t GAME_OVER = 0x02;
 
-        payload.push_back(static_cast<uint8_t>(current_turn_username.size()));
-        payload.insert(payload.end(), current_turn_username.begin(), current_turn_username.end());
+    uint64_t game_handle = 0;
+    uint32_t ply = 0;
+    uint16_t move = 0;
+    uint8_t flags = 0;
 
-        payload.push_back(is_game_over);
+    using Fields = Schema::Fields<
+        Schema::Varint<&GameMoveDeltaMessage::game_handle>,
+        Schema::Varint<&GameMoveDeltaMessage::ply>,
+        Schema::U16<&GameMoveDeltaMessage::move>,
+        Schema::U8<&GameMoveDeltaMessage::flags>>;
 
-        payload.push_back(static_cast<uint8_t>(message.size()));
-        payload.insert(payload.end(), message.begin(), message.end());
-        
-        return payload;
+    MessageType getType() const
+    {
+        return MessageType::GAME_MOVE_DELTA;
     }
+};
+#pragma endregion GameMoveDeltaMessage
 
-    static GameStatusUpdateMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        GameStatusUpdateMessage message;
+#pragma region GameKeyframeMessage
+/*
+Send from server to v2 players every Const::KEYFRAME_INTERVAL plies (in place of the delta)
+and in reply to ResyncRequestMessage. The board replaces the client's board entirely.
+
+Payload structure:
+    - varint game_handle
+    - varint ply (number of half moves played)
+    - uint8_t flags (same bits as GameMoveDeltaMessage)
+    - uint8_t[24] board (chess::PackedBoard from chess::Board::Compact::encode)
+*/
+struct GameKeyframeMessage : MessageCodec<GameKeyframeMessage>
+{
+    uint64_t game_handle = 0;
+    uint32_t ply = 0;
+    uint8_t flags = 0;
+    std::array<uint8_t, 24> board{};
 
-        size_t pos = 0;
-        uint8_t game_id_length = payload[pos++];
-        message.game_id = std::string(payload.begin() + pos, payload.begin() + pos + game_id_length);
+    using Fields = Schema::Fields<
+        Schema::Varint<&GameKeyframeMessage::game_handle>,
+        Schema::Varint<&GameKeyframeMessage::ply>,
+        Schema::U8<&GameKeyframeMessage::flags>,
+        Schema::Bytes<&GameKeyframeMessage::board>>;
 
-        pos += game_id_length;
-        uint8_t fen_length = payload[pos++];
-        message.fen = std::string(payload.begin() + pos, payload.begin() + pos + fen_length);
+    MessageType getType() const
+    {
+        return MessageType::GAME_KEYFRAME;
+    }
+};
+#pragma endregion GameKeyframeMessage
 
-        pos += fen_length;
-        uint8_t current_turn_username_length = payload[pos++];
-        message.current_turn_username = std::string(payload.begin() + pos, payload.begin() + pos + current_turn_username_length);
+#pragma region ResyncRequestMessage
+/*
+Send from client to server when a GameMoveDeltaMessage does not follow its current ply.
+The server answers with a GameKeyframeMessage.
 
-        pos += current_turn_username_length;
-        message.is_game_over = payload[pos++];
+Payload structure:
+    - varint game_handle
+*/
+struct ResyncRequestMessage : MessageCodec<ResyncRequestMessage>
+{
+    uint64_t game_handle = 0;
 
-        uint8_t message_length = payload[pos++];
-        message.message = std::string(payload.begin() + pos, payload.begin() + pos + message_length);
+    using Fields = Schema::Fields<
+        Schema::Varint<&ResyncRequestMessage::game_handle>>;
 
-        return message;
+    MessageType getType() const
+    {
+        return MessageType::RESYNC_REQUEST;
     }
 };
-#pragma endregion GameStatusUpdateMessage
+#pragma endregion ResyncRequestMessage
 
-#pragma region GameEndMessage 
+#pragma region GameEndMessage
 /*
 Send from server to clients to notify that the game has ended.
 
 Payload structure:
     - uint8_t game_id_length (1 byte)
     - char[game_id_length] game_id (game_id_length bytes)
+      (v2: varint game_handle instead of game_id)
 
     - uint8_t winner_username_length (1 byte)
     - char[winner_username_length] winner_username (winner_username_length bytes)
@@ -538,62 +800,31 @@ Payload structure:
 
     - uint16_t half_moves_count (2 bytes)
 */
-struct GameEndMessage
+template <typename Text>
+struct BasicGameEndMessage : MessageCodec<BasicGameEndMessage<Text>>
 {
-    std::string game_id;
-    std::string winner_username;
-    std::string reason;
+    Text game_id;
+    uint64_t game_handle = 0;
+    Text winner_username;
+    Text reason;
     uint16_t half_moves_count;
 
+    using Fields = Schema::Fields<
+        Schema::GameId<&BasicGameEndMessage::game_id, &BasicGameEndMessage::game_handle>,
+        Schema::String<&BasicGameEndMessage::winner_username>,
+        Schema::String<&BasicGameEndMessage::reason>,
+        Schema::U16<&BasicGameEndMessage::half_moves_count>>;
+
     MessageType getType() const
     {
         return MessageType::GAME_END;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(game_id.size()));
-        payload.insert(payload.end(), game_id.begin(), game_id.end());
-
-        payload.push_back(static_cast<uint8_t>(winner_username.size()));
-        payload.insert(payload.end(), winner_username.begin(), winner_username.end());
-
-        payload.push_back(static_cast<uint8_t>(reason.size()));
-        payload.insert(payload.end(), reason.begin(), reason.end());
-
-        std::vector<uint8_t> full_moves_count_bytes = to_big_endian_16(half_moves_count);
-        payload.insert(payload.end(), full_moves_count_bytes.begin(), full_moves_count_bytes.end());
-
-        return payload;
-    }
-
-    static GameEndMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        GameEndMessage message;
-
-        size_t pos = 0;
-        uint8_t game_id_length = payload[pos++];
-        message.game_id = std::string(payload.begin() + pos, payload.begin() + pos + game_id_length);
-
-        pos += game_id_length;
-        uint8_t winner_username_length = payload[pos++];
-        message.winner_username = std::string(payload.begin() + pos, payload.begin() + pos + winner_username_length);
-        
-        pos += winner_username_length;
-        uint8_t reason_length = payload[pos++];
-        message.reason = std::string(payload.begin() + pos, payload.begin() + pos + reason_length);
-
-        pos += reason_length;
-        message.half_moves_count = from_big_endian_16(payload, pos);
-        
-        return message;
-    }
 };
+
+using GameEndMessage = BasicGameEndMessage<std::string>;
 #pragma endregion GameEndMessage
 
-#pragma region AutoMatchRequestMessage 
+#pragma region AutoMatchRequestMessage
 /*
 Send from client to server to request an auto match.
 
@@ -601,39 +832,24 @@ Payload structure:
     - uint8_t username_length (1 byte)
     - char[username_length] username (username_length bytes)
 */
-struct AutoMatchRequestMessage
+template <typename Text>
+struct BasicAutoMatchRequestMessage : MessageCodec<BasicAutoMatchRequestMessage<Text>>
 {
-    std::string username;
+    Text username;
+
+    using Fields = Schema::Fields<
+        Schema::String<&BasicAutoMatchRequestMessage::username>>;
 
     MessageType getType() const
     {
         return MessageType::AUTO_MATCH_REQUEST;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(username.size()));
-        payload.insert(payload.end(), username.begin(), username.end());
-
-        return payload;
-    }
-
-    static AutoMatchRequestMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        AutoMatchRequestMessage message;
-
-        size_t pos = 0;
-        uint8_t username_length = payload[pos++];
-        message.username = std::string(payload.begin() + pos, payload.begin() + pos + username_length);
-
-        return message;
-    }
 };
+
+using AutoMatchRequestMessage = BasicAutoMatchRequestMessage<std::string>;
 #pragma endregion AutoMatchRequestMessage
 
-#pragma region AutoMatchFoundMessage 
+#pragma region AutoMatchFoundMessage
 /*
 Send from server to clients to notify that an auto match has been found.
 
@@ -643,52 +859,28 @@ Payload structure:
     - uint16_t opponent_elo (2 bytes)
     - uint8_t game_id_length (1 byte)
     - char[game_id_length] game_id (game_id_length bytes)
+      (v2: varint game_handle instead of game_id)
 */
-struct AutoMatchFoundMessage
+template <typename Text>
+struct BasicAutoMatchFoundMessage : MessageCodec<BasicAutoMatchFoundMessage<Text>>
 {
-    std::string opponent_username;
+    Text opponent_username;
     uint16_t opponent_elo;
-    std::string game_id;
+    Text game_id;
+    uint64_t game_handle = 0;
+
+    using Fields = Schema::Fields<
+        Schema::String<&BasicAutoMatchFoundMessage::opponent_username>,
+        Schema::U16<&BasicAutoMatchFoundMessage::opponent_elo>,
+        Schema::GameId<&BasicAutoMatchFoundMessage::game_id, &BasicAutoMatchFoundMessage::game_handle>>;
 
     MessageType getType() const
     {
         return MessageType::AUTO_MATCH_FOUND;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(opponent_username.size()));
-        payload.insert(payload.end(), opponent_username.begin(), opponent_username.end());
-
-        std::vector<uint8_t> elo_bytes = to_big_endian_16(opponent_elo);
-        payload.insert(payload.end(), elo_bytes.begin(), elo_bytes.end());
-
-        payload.push_back(static_cast<uint8_t>(game_id.size()));
-        payload.insert(payload.end(), game_id.begin(), game_id.end());
-
-        return payload;
-    }
-
-    static AutoMatchFoundMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        AutoMatchFoundMessage message;
-
-        size_t pos = 0;
-        uint8_t opponent_username_length = payload[pos++];
-        message.opponent_username = std::string(payload.begin() + pos, payload.begin() + pos + opponent_username_length);
-
-        pos += opponent_username_length;
-        message.opponent_elo = from_big_endian_16(payload, pos);
-
-        pos += 2;
-        uint8_t game_id_length = payload[pos++];
-        message.game_id = std::string(payload.begin() + pos, payload.begin() + pos + game_id_length);
-
-        return message;
-    }
 };
+
+using AutoMatchFoundMessage = BasicAutoMatchFoundMessage<std::string>;
 #pragma endregion AutoMatchFoundMessage
 
 #pragma region AutoMatchAcceptedMessage =
@@ -698,117 +890,78 @@ Send from client to server to accept an auto match.
 Payload structure:
     - uint8_t game_id_length (1 byte)
     - char[game_id_length] game_id (game_id_length bytes)
+      (v2: varint game_handle instead of game_id)
 */
-struct AutoMatchAcceptedMessage
+template <typename Text>
+struct BasicAutoMatchAcceptedMessage : MessageCodec<BasicAutoMatchAcceptedMessage<Text>>
 {
-    std::string game_id;
+    Text game_id;
+    uint64_t game_handle = 0;
+
+    using Fields = Schema::Fields<
+        Schema::GameId<&BasicAutoMatchAcceptedMessage::game_id, &BasicAutoMatchAcceptedMessage::game_handle>>;
 
     MessageType getType() const
     {
         return MessageType::AUTO_MATCH_ACCEPTED;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(game_id.size()));
-        payload.insert(payload.end(), game_id.begin(), game_id.end());
-
-        return payload;
-    }
-
-    static AutoMatchAcceptedMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        AutoMatchAcceptedMessage message;
-
-        size_t pos = 0;
-        uint8_t game_id_length = payload[pos++];
-        message.game_id = std::string(payload.begin() + pos, payload.begin() + pos + game_id_length);
-
-        return message;
-    }
 };
+
+using AutoMatchAcceptedMessage = BasicAutoMatchAcceptedMessage<std::string>;
 #pragma endregion AutoMatchAcceptedMessage
 
 #pragma region AutoMatchDeclinedMessage =
 /*
 Send from client to server to decline an auto match.
 
-Payload structure:
-    - uint8_t game_id_length (1 byte)
-    - char[game_id_length] game_id (game_id_length bytes)
-*/
-struct AutoMatchDeclinedMessage
-{
-    std::string game_id;
-
-    MessageType getType() const
-    {
-        return MessageType::AUTO_MATCH_DECLINED;
-    }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(game_id.size()));
-        payload.insert(payload.end(), game_id.begin(), game_id.end());
+Payload structure:
+    - uint8_t game_id_length (1 byte)
+    - char[game_id_length] game_id (game_id_length bytes)
+      (v2: varint game_handle instead of game_id)
+*/
+template <typename Text>
+struct BasicAutoMatchDeclinedMessage : MessageCodec<BasicAutoMatchDeclinedMessage<Text>>
+{
+    Text game_id;
+    uint64_t game_handle = 0;
 
-        return payload;
-    }
+    using Fields = Schema::Fields<
+        Schema::GameId<&BasicAutoMatchDeclinedMessage::game_id, &BasicAutoMatchDeclinedMessage::game_handle>>;
 
-    static AutoMatchDeclinedMessage deserialize(const std::vector<uint8_t> &payload)
+    MessageType getType() const
     {
-        AutoMatchDeclinedMessage message;
-
-        size_t pos = 0;
-        uint8_t game_id_length = payload[pos++];
-        message.game_id = std::string(payload.begin() + pos, payload.begin() + pos + game_id_length);
-
-        return message;
+        return MessageType::AUTO_MATCH_DECLINED;
     }
 };
+
+using AutoMatchDeclinedMessage = BasicAutoMatchDeclinedMessage<std::string>;
 #pragma endregion AutoMatchDeclinedMessage
 
-#pragma region MatchDeclinedNotificationMessage 
+#pragma region MatchDeclinedNotificationMessage
 /*
 Send from server to client to notify that the opponent has declined the match.
 
 Payload structure:
     - uint8_t game_id_length (1 byte)
     - char[game_id_length] game_id (game_id_length bytes)
+      (v2: varint game_handle instead of game_id)
 */
-struct MatchDeclinedNotificationMessage
+template <typename Text>
+struct BasicMatchDeclinedNotificationMessage : MessageCodec<BasicMatchDeclinedNotificationMessage<Text>>
 {
-    std::string game_id;
+    Text game_id;
+    uint64_t game_handle = 0;
+
+    using Fields = Schema::Fields<
+        Schema::GameId<&BasicMatchDeclinedNotificationMessage::game_id, &BasicMatchDeclinedNotificationMessage::game_handle>>;
 
     MessageType getType() const
     {
         return MessageType::MATCH_DECLINED_NOTIFICATION;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(game_id.size()));
-        payload.insert(payload.end(), game_id.begin(), game_id.end());
-
-        return payload;
-    }
-
-    static MatchDeclinedNotificationMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        MatchDeclinedNotificationMessage message;
-
-        size_t pos = 0;
-        uint8_t game_id_length = payload[pos++];
-        message.game_id = std::string(payload.begin() + pos, payload.begin() + pos + game_id_length);
-
-        return message;
-    }
 };
+
+using MatchDeclinedNotificationMessage = BasicMatchDeclinedNotificationMessage<std::string>;
 #pragma endregion MatchDeclinedNotificationMessage
 
 #pragma region PlayWithBotMessage
@@ -820,71 +973,64 @@ Payload structure:
     - char[username_length] username (username_length bytes)
 */
 
-struct PlayWithBotMessage
+template <typename Text>
+struct BasicPlayWithBotMessage : MessageCodec<BasicPlayWithBotMessage<Text>>
 {
-    std::string username;
+    Text username;
+
+    using Fields = Schema::Fields<
+        Schema::String<&BasicPlayWithBotMessage::username>>;
 
     MessageType getType() const
     {
         return MessageType::PLAY_WITH_BOT;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(username.size()));
-        payload.insert(payload.end(), username.begin(), username.end());
-
-        return payload;
-    }
-
-    static PlayWithBotMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        PlayWithBotMessage message;
-
-        size_t pos = 0;
-        uint8_t username_length = payload[pos++];
-        message.username = std::string(payload.begin() + pos, payload.begin() + pos + username_length);
-
-        return message;
-    }
 };
 
-#pragma region RequestPlayerListMessage 
+using PlayWithBotMessage = BasicPlayWithBotMessage<std::string>;
+
+#pragma region RequestPlayerListMessage
 /*
 Send from client to server to request the list of players.
 
 Payload structure:
-    - No payload
+    - v1: No payload
+    - v2 (có thể bỏ trống: trang đầu tiên):
+        - varint limit (0: kích thước trang mặc định; server trả tối đa Const::LIST_PAGE_ITEMS)
+        - varint cursor_length
+        - char[cursor_length] cursor (rỗng: từ đầu danh sách)
 */
-struct RequestPlayerListMessage
+template <typename Text>
+struct BasicRequestPlayerListMessage : MessageCodec<BasicRequestPlayerListMessage<Text>>
 {
-    MessageType getType() const
-    {
-        return MessageType::REQUEST_PLAYER_LIST;
-    }
+    uint32_t limit = 0;
+    Text cursor;
 
-    std::vector<uint8_t> serialize() const
-    {
-        return {}; // No payload
-    }
+    using Fields = Schema::Fields<
+        Schema::V2Only<Schema::Optional<
+            Schema::Varint<&BasicRequestPlayerListMessage::limit>,
+            Schema::String<&BasicRequestPlayerListMessage::cursor>>>>;
 
-    static RequestPlayerListMessage deserialize(const std::vector<uint8_t> &payload)
+    MessageType getType() const
     {
-        // No payload to deserialize
-        return RequestPlayerListMessage();
+        return MessageType::REQUEST_PLAYER_LIST;
     }
 };
+
+using RequestPlayerListMessage = BasicRequestPlayerListMessage<std::string>;
 #pragma endregion RequestPlayerListMessage
 
-#pragma region PlayerListMessage 
+#pragma region PlayerListMessage
 /*
 Send from server to clients to provide the list of players.
 
 Payload structure:
-    - uint8_t number_of_players (1 byte)
+    - uint8_t number_of_players (1 byte; varint in v2)
     - [Player 1][Player 2]...
+    - v2 only (server cũ không gửi: coi là trang cuối):
+        - varint next_cursor_length
+        - char[next_cursor_length] next_cursor (rỗng: đã hết danh sách; gửi lại trong yêu cầu để lấy trang tiếp theo)
+        - uint8_t final (1: trang cuối, không còn trang tiếp theo)
 
 Player structure:
     - uint8_t username_length (1 byte)
@@ -895,157 +1041,84 @@ Player structure:
         - uint8_t game_id_length (1 byte)
         - char[game_id_length] game_id (game_id_length bytes)
 */
-struct PlayerListMessage
+template <typename Text>
+struct BasicPlayerListMessage : MessageCodec<BasicPlayerListMessage<Text>>
 {
     struct Player
     {
-        std::string username;
+        Text username;
         uint16_t elo;
         bool in_game;
-        std::string game_id;
+        Text game_id;
+
+        using Fields = Schema::Fields<
+            Schema::String<&Player::username>,
+            Schema::U16<&Player::elo>,
+            Schema::U8<&Player::in_game>,
+            Schema::If<&Player::in_game, Schema::String<&Player::game_id>>>;
     };
 
     std::vector<Player> players;
+    Text next_cursor;
+    bool final = true;
+
+    using Fields = Schema::Fields<
+        Schema::List<&BasicPlayerListMessage::players>,
+        Schema::V2Only<Schema::Optional<
+            Schema::String<&BasicPlayerListMessage::next_cursor>,
+            Schema::U8<&BasicPlayerListMessage::final>>>>;
 
     MessageType getType() const
     {
         return MessageType::PLAYER_LIST;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-        payload.push_back(static_cast<uint8_t>(players.size()));
-
-        for (const auto &player : players)
-        {
-            payload.push_back(static_cast<uint8_t>(player.username.size()));
-            payload.insert(payload.end(), player.username.begin(), player.username.end());
-
-            std::vector<uint8_t> elo_bytes = to_big_endian_16(player.elo);
-            payload.insert(payload.end(), elo_bytes.begin(), elo_bytes.end());
-
-            payload.push_back(static_cast<uint8_t>(player.in_game));
-            
-            if (player.in_game) {
-                payload.push_back(static_cast<uint8_t>(player.game_id.size()));
-                payload.insert(payload.end(), player.game_id.begin(), player.game_id.end());
-            }
-        }
-
-        return payload;
-    }
-
-    static PlayerListMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        PlayerListMessage message;
-
-        size_t pos = 0;
-        uint8_t number_of_players = payload[pos++];
-
-        for (uint8_t i = 0; i < number_of_players; ++i)
-        {
-            Player player;
-            
-            uint8_t username_length = payload[pos++];
-            player.username = std::string(payload.begin() + pos, payload.begin() + pos + username_length);
-            pos += username_length;
-
-            player.elo = from_big_endian_16(payload, pos);
-            pos += 2;
-
-            player.in_game = payload[pos++];
-            
-            if (player.in_game) {
-                uint8_t game_id_length = payload[pos++];
-                player.game_id = std::string(payload.begin() + pos, payload.begin() + pos + game_id_length);
-                pos += game_id_length;
-            }
-
-            message.players.push_back(player);
-        }
-        
-        return message;
-    }
 };
+
+using PlayerListMessage = BasicPlayerListMessage<std::string>;
 #pragma endregion PlayerListMessage
 
 // Chưa xong
 #pragma region ChallengeRequestMessage
-struct ChallengeRequestMessage
+template <typename Text>
+struct BasicChallengeRequestMessage : MessageCodec<BasicChallengeRequestMessage<Text>>
 {
-    std::string to_username;
+    Text to_username;
+
+    using Fields = Schema::Fields<
+        Schema::String<&BasicChallengeRequestMessage::to_username>>;
 
     MessageType getType() const
     {
         return MessageType::CHALLENGE_REQUEST;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(to_username.size()));
-        payload.insert(payload.end(), to_username.begin(), to_username.end());
-
-        return payload;
-    }
-
-    static ChallengeRequestMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        ChallengeRequestMessage message;
-
-        size_t pos = 0;
-        uint8_t to_username_length = payload[pos++];
-        message.to_username = std::string(payload.begin() + pos, payload.begin() + pos + to_username_length);
-
-        return message;
-    }
 };
+
+using ChallengeRequestMessage = BasicChallengeRequestMessage<std::string>;
 #pragma endregion ChallengeRequestMessage
 
 #pragma region ChallengeNotificationMessage
-struct ChallengeNotificationMessage
+template <typename Text>
+struct BasicChallengeNotificationMessage : MessageCodec<BasicChallengeNotificationMessage<Text>>
 {
-    std::string from_username;
+    Text from_username;
     uint16_t elo;
 
+    using Fields = Schema::Fields<
+        Schema::String<&BasicChallengeNotificationMessage::from_username>,
+        Schema::U16<&BasicChallengeNotificationMessage::elo>>;
+
     MessageType getType() const
     {
         return MessageType::CHALLENGE_NOTIFICATION;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(from_username.size()));
-        payload.insert(payload.end(), from_username.begin(), from_username.end());
-
-        std::vector<uint8_t> elo_bytes = to_big_endian_16(elo);
-        payload.insert(payload.end(), elo_bytes.begin(), elo_bytes.end());
-
-        return payload;
-    }
-
-    static ChallengeNotificationMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        ChallengeNotificationMessage message;
-
-        size_t pos = 0;
-        uint8_t from_username_length = payload[pos++];
-        message.from_username = std::string(payload.begin() + pos, payload.begin() + pos + from_username_length);
-
-        pos += from_username_length;
-        message.elo = from_big_endian_16(payload, pos);
-
-        return message;
-    }
 };
+
+using ChallengeNotificationMessage = BasicChallengeNotificationMessage<std::string>;
 #pragma endregion ChallengeNotificationMessage
 
 #pragma region ChallengeResponseMessage
-struct ChallengeResponseMessage
+template <typename Text>
+struct BasicChallengeResponseMessage : MessageCodec<BasicChallengeResponseMessage<Text>>
 {
     enum class Response : uint8_t {
         DECLINED = 0x00,
@@ -1054,121 +1127,59 @@ struct ChallengeResponseMessage
     Response response;
 
     // caution: this username is challenger's username, not the one challenged
-    std::string from_username;
+    Text from_username;
+
+    // from_username đứng trước response trên dây
+    using Fields = Schema::Fields<
+        Schema::String<&BasicChallengeResponseMessage::from_username>,
+        Schema::U8<&BasicChallengeResponseMessage::response>>;
 
     MessageType getType() const
     {
         return MessageType::CHALLENGE_RESPONSE;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        // Serialize from_username
-        payload.push_back(static_cast<uint8_t>(from_username.size()));
-        payload.insert(payload.end(), from_username.begin(), from_username.end());
-
-        // Serialize response
-        payload.push_back(static_cast<uint8_t>(response));
-
-        return payload;
-    }
-
-    static ChallengeResponseMessage deserialize(const std::vector<uint8_t>& payload)
-    {
-        ChallengeResponseMessage message;
-        size_t pos = 0;
-
-        // Deserialize from_username
-        uint8_t from_username_length = payload[pos++];
-        message.from_username = std::string(payload.begin() + pos, payload.begin() + pos + from_username_length);
-        pos += from_username_length;
-
-        // Deserialize response
-        message.response = static_cast<Response>(payload[pos++]);
-
-        return message;
-    }
 };
+
+using ChallengeResponseMessage = BasicChallengeResponseMessage<std::string>;
 #pragma endregion ChallengeResponseMessage
 
 #pragma region ChallengeAcceptedMessage
-struct ChallengeAcceptedMessage
+template <typename Text>
+struct BasicChallengeAcceptedMessage : MessageCodec<BasicChallengeAcceptedMessage<Text>>
 {
-    std::string from_username;
-    std::string game_id;
+    Text from_username;
+    Text game_id;
+    uint64_t game_handle = 0;
+
+    using Fields = Schema::Fields<
+        Schema::String<&BasicChallengeAcceptedMessage::from_username>,
+        Schema::GameId<&BasicChallengeAcceptedMessage::game_id, &BasicChallengeAcceptedMessage::game_handle>>;
 
     MessageType getType() const
     {
         return MessageType::CHALLENGE_ACCEPTED;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        // Serialize from_username
-        payload.push_back(static_cast<uint8_t>(from_username.size()));
-        payload.insert(payload.end(), from_username.begin(), from_username.end());
-
-        // Serialize game_id
-        payload.push_back(static_cast<uint8_t>(game_id.size()));
-        payload.insert(payload.end(), game_id.begin(), game_id.end());
-
-        return payload;
-    }
-
-    static ChallengeAcceptedMessage deserialize(const std::vector<uint8_t>& payload)
-    {
-        ChallengeAcceptedMessage message;
-        size_t pos = 0;
-
-        // Deserialize from_username
-        uint8_t from_username_length = payload[pos++];
-        message.from_username = std::string(payload.begin() + pos, payload.begin() + pos + from_username_length);
-        pos += from_username_length;
-
-        // Deserialize game_id
-        uint8_t game_id_length = payload[pos++];
-        message.game_id = std::string(payload.begin() + pos, payload.begin() + pos + game_id_length);
-
-        return message;
-    }
 };
+
+using ChallengeAcceptedMessage = BasicChallengeAcceptedMessage<std::string>;
 #pragma endregion ChallengeAcceptedMessage
 
 #pragma region ChallengeDeclinedMessage
-struct ChallengeDeclinedMessage
+template <typename Text>
+struct BasicChallengeDeclinedMessage : MessageCodec<BasicChallengeDeclinedMessage<Text>>
 {
-    std::string from_username;
+    Text from_username;
+
+    using Fields = Schema::Fields<
+        Schema::String<&BasicChallengeDeclinedMessage::from_username>>;
 
     MessageType getType() const
     {
         return MessageType::CHALLENGE_DECLINED;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(from_username.size()));
-        payload.insert(payload.end(), from_username.begin(), from_username.end());
-
-        return payload;
-    }
-
-    static ChallengeDeclinedMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        ChallengeDeclinedMessage message;
-
-        size_t pos = 0;
-        uint8_t from_username_length = payload[pos++];
-        message.from_username = std::string(payload.begin() + pos, payload.begin() + pos + from_username_length);
-
-        return message;
-    }
 };
+
+using ChallengeDeclinedMessage = BasicChallengeDeclinedMessage<std::string>;
 #pragma endregion ChallengeDeclinedMessage
 
 #pragma region RequestSpectateMessage
@@ -1179,88 +1190,55 @@ Payload structure:
     - uint8_t username_length (1 byte)
     - char[username_length] username (username_length bytes)
 */
-struct RequestSpectateMessage
+template <typename Text>
+struct BasicRequestSpectateMessage : MessageCodec<BasicRequestSpectateMessage<Text>>
 {
-    std::string username;
+    Text username;
+
+    using Fields = Schema::Fields<
+        Schema::String<&BasicRequestSpectateMessage::username>>;
 
     MessageType getType() const
     {
         return MessageType::REQUEST_SPECTATE;
     }
+};
 
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(username.size()));
-        payload.insert(payload.end(), username.begin(), username.end());
-
-        return payload;
-    }
-
-    static RequestSpectateMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        RequestSpectateMessage message;
-
-        size_t pos = 0;
-        uint8_t username_length = payload[pos++];
-        message.username = std::string(payload.begin() + pos, payload.begin() + pos + username_length);
+using RequestSpectateMessage = BasicRequestSpectateMessage<std::string>;
 
-        return message;
-    }
-};
+// Zero-copy view of RequestSpectateMessage
+using RequestSpectateMessageView = BasicRequestSpectateMessage<std::string_view>;
 #pragma endregion RequestSpectateMessage
 
 #pragma region SpectateSuccessMessage
-struct SpectateSuccessMessage
+template <typename Text>
+struct BasicSpectateSuccessMessage : MessageCodec<BasicSpectateSuccessMessage<Text>>
 {
-    std::string game_id;
+    Text game_id;
+    uint64_t game_handle = 0;
+
+    using Fields = Schema::Fields<
+        Schema::GameId<&BasicSpectateSuccessMessage::game_id, &BasicSpectateSuccessMessage::game_handle>>;
 
     MessageType getType() const
     {
         return MessageType::SPECTATE_SUCCESS;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(game_id.size()));
-        payload.insert(payload.end(), game_id.begin(), game_id.end());
-
-        return payload;
-    }
-
-    static SpectateSuccessMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        SpectateSuccessMessage message;
-        size_t pos = 0;
-
-        uint8_t game_id_length = payload[pos++];
-        message.game_id = std::string(payload.begin() + pos, payload.begin() + pos + game_id_length);
-
-        return message;
-    }
 };
+
+using SpectateSuccessMessage = BasicSpectateSuccessMessage<std::string>;
 #pragma endregion SpectateSuccessMessage
 
 #pragma region SpectateFailureMessage
-struct SpectateFailureMessage
+struct SpectateFailureMessage : MessageCodec<SpectateFailureMessage>
 {
+    // No payload
+    using Fields = Schema::Fields<>;
+
     MessageType getType() const
     {
         return MessageType::SPECTATE_FAILURE;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        return {}; // No payload
-    }
-
-    static SpectateFailureMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        return SpectateFailureMessage(); // No payload to deserialize
-    }
 };
 #pragma endregion SpectateFailureMessage
 
@@ -1275,69 +1253,37 @@ Payload structure:
     - char[current_turn_username_length] current_turn_username (current_turn_username_length bytes)
     - uint8_t is_white (1 byte)
 */
-struct SpectateMoveMessage
+template <typename Text>
+struct BasicSpectateMoveMessage : MessageCodec<BasicSpectateMoveMessage<Text>>
 {
-    std::string fen;
-    std::string current_turn_username;
+    Text fen;
+    Text current_turn_username;
     bool is_white;
 
+    using Fields = Schema::Fields<
+        Schema::String<&BasicSpectateMoveMessage::fen>,
+        Schema::String<&BasicSpectateMoveMessage::current_turn_username>,
+        Schema::U8<&BasicSpectateMoveMessage::is_white>>;
+
     MessageType getType() const
     {
         return MessageType::SPECTATE_MOVE;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(fen.size()));
-        payload.insert(payload.end(), fen.begin(), fen.end());
-
-        payload.push_back(static_cast<uint8_t>(current_turn_username.size()));
-        payload.insert(payload.end(), current_turn_username.begin(), current_turn_username.end());
-
-        payload.push_back(static_cast<uint8_t>(is_white));
-
-        return payload;
-    }
-
-    static SpectateMoveMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        SpectateMoveMessage message;
-        size_t pos = 0;
-
-        uint8_t fen_length = payload[pos++];
-        message.fen = std::string(payload.begin() + pos, payload.begin() + pos + fen_length);
-        pos += fen_length;
-
-        uint8_t username_length = payload[pos++];
-        message.current_turn_username = std::string(payload.begin() + pos, payload.begin() + pos + username_length);
-        pos += username_length;
-
-        message.is_white = payload[pos] != 0;
-
-        return message;
-    }
 };
+
+using SpectateMoveMessage = BasicSpectateMoveMessage<std::string>;
 #pragma endregion SpectateMoveMessage
 
 #pragma region SpectateEndMessage
-struct SpectateEndMessage
+struct SpectateEndMessage : MessageCodec<SpectateEndMessage>
 {
+    // No payload
+    using Fields = Schema::Fields<>;
+
     MessageType getType() const
     {
         return MessageType::SPECTATE_END;
     }
-
-    std::vector<uint8_t> serialize() const
-    {
-        return {}; // No payload
-    }
-
-    static SpectateEndMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        return SpectateEndMessage(); // No payload to deserialize
-    }
 };
 #pragma endregion SpectateEndMessage
 
@@ -1348,37 +1294,27 @@ Send from client to server to exit spectating a game.
 Payload structure:
     - uint8_t game_id_length (1 byte)
     - char[game_id_length] game_id (game_id_length bytes)
+      (v2: varint game_handle instead of game_id)
 */
-struct SpectateExitMessage
+template <typename Text>
+struct BasicSpectateExitMessage : MessageCodec<BasicSpectateExitMessage<Text>>
 {
-    std::string game_id;
+    Text game_id;
+    uint64_t game_handle = 0;
+
+    using Fields = Schema::Fields<
+        Schema::GameId<&BasicSpectateExitMessage::game_id, &BasicSpectateExitMessage::game_handle>>;
 
     MessageType getType() const
     {
         return MessageType::SPECTATE_EXIT;
     }
+};
 
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(game_id.size()));
-        payload.insert(payload.end(), game_id.begin(), game_id.end());
-
-        return payload;
-    }
-
-    static SpectateExitMessage deserialize(const std::vector<uint8_t> &payload)
-    {
-        SpectateExitMessage message;
-
-        size_t pos = 0;
-        uint8_t game_id_length = payload[pos++];
-        message.game_id = std::string(payload.begin() + pos, payload.begin() + pos + game_id_length);
+using SpectateExitMessage = BasicSpectateExitMessage<std::string>;
 
-        return message;
-    }
-};
+// Zero-copy view of SpectateExitMessage
+using SpectateExitMessageView = BasicSpectateExitMessage<std::string_view>;
 #pragma endregion SpectateExitMessage
 #pragma region SurrenderMessage
 /*
@@ -1387,45 +1323,29 @@ Send from client to server to surrender the game.
 Payload structure:
     - uint8_t game_id_length (1 byte)
     - char[game_id_length] game_id (game_id_length bytes)
+      (v2: varint game_handle instead of game_id)
 */
-struct SurrenderMessage
+template <typename Text>
+struct BasicSurrenderMessage : MessageCodec<BasicSurrenderMessage<Text>>
 {
-    std::string game_id;
-    std::string from_username;
+    Text game_id;
+    uint64_t game_handle = 0;
+    Text from_username;
+
+    using Fields = Schema::Fields<
+        Schema::GameId<&BasicSurrenderMessage::game_id, &BasicSurrenderMessage::game_handle>,
+        Schema::String<&BasicSurrenderMessage::from_username>>;
 
     MessageType getType() const
     {
         return MessageType::SURRENDER;
     }
+};
 
-    std::vector<uint8_t> serialize() const
-    {
-        std::vector<uint8_t> payload;
-
-        payload.push_back(static_cast<uint8_t>(game_id.size()));
-        payload.insert(payload.end(), game_id.begin(), game_id.end());
-
-        payload.push_back(static_cast<uint8_t>(from_username.size()));
-        payload.insert(payload.end(), from_username.begin(), from_username.end());
-
-        return payload;
-    }
-
-    static SurrenderMessage deserialize(const std::vector<uint8_t>& payload)
-    {
-        SurrenderMessage message;
-
-        size_t pos = 0;
-        uint8_t game_id_length = payload[pos++];
-        message.game_id = std::string(payload.begin() + pos, payload.begin() + pos + game_id_length);
-        pos += game_id_length;
-
-        uint8_t from_username_length = payload[pos++];
-        message.from_username = std::string(payload.begin() + pos, payload.begin() + pos + from_username_length);
+using SurrenderMessage = BasicSurrenderMessage<std::string>;
 
-        return message;
-    }
-};
+// Zero-copy view of SurrenderMessage
+using SurrenderMessageView = BasicSurrenderMessage<std::string_view>;
 #pragma endregion SurrenderMessage
 
 #pragma region RequestMatchHistoryMessage
@@ -1433,23 +1353,28 @@ struct SurrenderMessage
 Send from client to server to request the match history of the player.
 
 Payload structure:
-    - No payload
+    - v1: No payload
+    - v2 (có thể bỏ trống: trang đầu tiên, từ trận mới nhất):
+        - varint limit (0: kích thước trang mặc định; server trả tối đa Const::LIST_PAGE_ITEMS)
+        - varint cursor_length
+        - char[cursor_length] cursor (rỗng: từ trận mới nhất)
 */
-struct RequestMatchHistoryMessage {
-    MessageType getType() const {
-        return MessageType::REQUEST_MATCH_HISTORY;
-    }
+template <typename Text>
+struct BasicRequestMatchHistoryMessage : MessageCodec<BasicRequestMatchHistoryMessage<Text>> {
+    uint32_t limit = 0;
+    Text cursor;
 
-    std::vector<uint8_t> serialize() const {
-        // No payload
-        return {};
-    }
+    using Fields = Schema::Fields<
+        Schema::V2Only<Schema::Optional<
+            Schema::Varint<&BasicRequestMatchHistoryMessage::limit>,
+            Schema::String<&BasicRequestMatchHistoryMessage::cursor>>>>;
 
-    static RequestMatchHistoryMessage deserialize(const std::vector<uint8_t>& payload) {
-        // No payload to deserialize
-        return RequestMatchHistoryMessage();
+    MessageType getType() const {
+        return MessageType::REQUEST_MATCH_HISTORY;
     }
 };
+
+using RequestMatchHistoryMessage = BasicRequestMatchHistoryMessage<std::string>;
 #pragma endregion RequestMatchHistoryMessage
 
 #pragma region MatchHistoryMessage
@@ -1457,8 +1382,9 @@ struct RequestMatchHistoryMessage {
 Send from server to client to provide the match history of a player.
 
 Payload structure:
-    - uint8_t number_of_matches (1 byte)
+    - uint8_t number_of_matches (1 byte; varint in v2)
     - [Match 1][Match 2]...
+    - v2 only: next_cursor và final, giống PlayerListMessage
 
 Match structure:
     - uint8_t game_id_length (1 byte)
@@ -1469,69 +1395,74 @@ Match structure:
     - uint8_t date_length (1 byte)
     - char[date_length] date (date_length bytes)
 */
-struct  MatchHistoryMessage {
+template <typename Text>
+struct BasicMatchHistoryMessage : MessageCodec<BasicMatchHistoryMessage<Text>> {
     struct Match {
-        std::string game_id;
-        std::string opponent_username;
+        Text game_id;
+        Text opponent_username;
         bool won;
-        std::string date;
+        Text date;
+
+        using Fields = Schema::Fields<
+            Schema::String<&Match::game_id>,
+            Schema::String<&Match::opponent_username>,
+            Schema::U8<&Match::won>,
+            Schema::String<&Match::date>>;
     };
 
     std::vector<Match> matches;
+    Text next_cursor;
+    bool final = true;
+
+    using Fields = Schema::Fields<
+        Schema::List<&BasicMatchHistoryMessage::matches>,
+        Schema::V2Only<Schema::Optional<
+            Schema::String<&BasicMatchHistoryMessage::next_cursor>,
+            Schema::U8<&BasicMatchHistoryMessage::final>>>>;
 
     MessageType getType() const {
         return MessageType::MATCH_HISTORY;
     }
+};
 
-    std::vector<uint8_t> serialize() const {
-        std::vector<uint8_t> payload;
-        payload.push_back(static_cast<uint8_t>(matches.size()));
-
-        for (const auto& match : matches) {
-            payload.push_back(static_cast<uint8_t>(match.game_id.size()));
-            payload.insert(payload.end(), match.game_id.begin(), match.game_id.end());
-
-            payload.push_back(static_cast<uint8_t>(match.opponent_username.size()));
-            payload.insert(payload.end(), match.opponent_username.begin(), match.opponent_username.end());
-
-            payload.push_back(static_cast<uint8_t>(match.won));
-
-            payload.push_back(static_cast<uint8_t>(match.date.size()));
-            payload.insert(payload.end(), match.date.begin(), match.date.end());
-        }
-
-        return payload;
-    }
-
-    static MatchHistoryMessage deserialize(const std::vector<uint8_t>& payload) {
-        MatchHistoryMessage message;
-
-        size_t pos = 0;
-        uint8_t number_of_matches = payload[pos++];
-
-        for (uint8_t i = 0; i < number_of_matches; ++i) {
-            Match match;
-
-            uint8_t game_id_length = payload[pos++];
-            match.game_id = std::string(payload.begin() + pos, payload.begin() + pos + game_id_length);
-            pos += game_id_length;
-
-            uint8_t opponent_username_length = payload[pos++];
-            match.opponent_username = std::string(payload.begin() + pos, payload.begin() + pos + opponent_username_length);
-            pos += opponent_username_length;
+using MatchHistoryMessage = BasicMatchHistoryMessage<std::string>;
+#pragma endregion MatchHistoryMessage
 
-            match.won = payload[pos++];
+// Bản view không sao chép của thông điệp: BasicX<std::string_view>; thông điệp chỉ có số là view của chính nó
+template <typename Message>
+struct MessageViewOf
+{
+    using type = Message;
+};
 
-            uint8_t date_length = payload[pos++];
-            match.date = std::string(payload.begin() + pos, payload.begin() + pos + date_length);
-            pos += date_length;
+template <template <typename> class BasicMessage>
+struct MessageViewOf<BasicMessage<std::string>>
+{
+    using type = BasicMessage<std::string_view>;
+};
 
-            message.matches.push_back(match);
-        }
+template <typename Message>
+using MessageView = typename MessageViewOf<Message>::type;
 
-        return message;
-    }
+// Mọi thông điệp có payload riêng, theo thứ tự MessageType (dùng bởi bench và fuzz)
+template <typename... Message>
+struct MessageList
+{
+    static constexpr size_t size = sizeof...(Message);
 };
-#pragma endregion MatchHistoryMessage
+
+using AllMessages = MessageList<
+    HelloMessage, HelloAckMessage,
+    RegisterMessage, RegisterSuccessMessage, RegisterFailureMessage,
+    LoginMessage, LoginSuccessMessage, LoginFailureMessage,
+    RequestPlayerListMessage, PlayerListMessage, RequestMatchHistoryMessage, MatchHistoryMessage,
+    GameStartMessage, MoveMessage, InvalidMoveMessage, GameStatusUpdateMessage, GameEndMessage,
+    SurrenderMessage, MoveV2Message, GameMoveDeltaMessage, GameKeyframeMessage, ResyncRequestMessage,
+    ChallengeRequestMessage, ChallengeNotificationMessage, ChallengeResponseMessage,
+    ChallengeAcceptedMessage, ChallengeDeclinedMessage,
+    AutoMatchRequestMessage, AutoMatchFoundMessage, AutoMatchAcceptedMessage, AutoMatchDeclinedMessage,
+    MatchDeclinedNotificationMessage, PlayWithBotMessage,
+    RequestSpectateMessage, SpectateSuccessMessage, SpectateFailureMessage, SpectateMoveMessage,
+    SpectateEndMessage, SpectateExitMessage>;
 
 #endif // MESSAGE_HPP
\ No newline at end of file
@@ -0,0 +1,313 @@
+#ifndef MESSAGE_SCHEMA_HPP
+#define MESSAGE_SCHEMA_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "protocol.hpp"
+
+// Số phần tử tối đa của một danh sách trong một frame (v1 chỉ có 1 byte đếm)
+inline size_t max_list_size(uint8_t version)
+{
+    return version >= Protocol::V2 ? Protocol::MAX_PAYLOAD_SIZE : 0xFF;
+}
+
+// Độ dài tối đa của một chuỗi (v1 chỉ có 1 byte độ dài, phần thừa bị cắt)
+inline size_t max_string_size(uint8_t version)
+{
+    return version >= Protocol::V2 ? Protocol::MAX_PAYLOAD_SIZE : 0xFF;
+}
+
+/**
+ * @brief Mô tả các trường của thông điệp tại thời điểm biên dịch.
+ *
+ * Mỗi thông điệp khai báo một lần `using Fields = Schema::Fields<...>` với con trỏ tới các
+ * thành viên của nó. Từ khai báo đó sinh ra:
+ *   - write(message, writer): dùng với PayloadSizer để đếm đúng số byte và với PayloadWriter để ghi;
+ *   - read(message, reader): giải mã có kiểm tra giới hạn qua PayloadReader, trả về false khi
+ *     payload bị cắt cụt hoặc sai.
+ * Trường chuỗi đọc vào std::string (sao chép) hoặc std::string_view (trỏ thẳng vào payload),
+ * nên cùng một khai báo cho cả bộ giải mã sở hữu dữ liệu lẫn bộ giải mã dạng view.
+ * Các hàm đều inline và được trải phẳng bằng fold expression, không có vòng lặp trên bảng mô tả.
+ */
+namespace Schema
+{
+    namespace detail
+    {
+        template <typename Message, auto Member>
+        using MemberType = std::remove_cv_t<std::remove_reference_t<decltype(std::declval<Message &>().*Member)>>;
+
+        template <typename Text>
+        void assignText(Text &target, std::string_view value)
+        {
+            if constexpr (std::is_same_v<Text, std::string>)
+            {
+                target.assign(value.data(), value.size());
+            }
+            else
+            {
+                target = value;
+            }
+        }
+    }
+
+    // Số nguyên 1 byte: uint8_t, bool hoặc enum 1 byte
+    template <auto Member>
+    struct U8
+    {
+        template <typename Message, typename Writer>
+        static void write(const Message &message, Writer &writer)
+        {
+            writer.writeU8(static_cast<uint8_t>(message.*Member));
+        }
+
+        template <typename Message, typename Reader>
+        static bool read(Message &message, Reader &reader)
+        {
+            using Type = detail::MemberType<Message, Member>;
+            uint8_t value;
+            if (!reader.readU8(value))
+            {
+                return false;
+            }
+            if constexpr (std::is_same_v<Type, bool>)
+            {
+                message.*Member = value != 0;
+            }
+            else
+            {
+                message.*Member = static_cast<Type>(value);
+            }
+            return true;
+        }
+    };
+
+    // Số nguyên 2 byte big-endian
+    template <auto Member>
+    struct U16
+    {
+        template <typename Message, typename Writer>
+        static void write(const Message &message, Writer &writer)
+        {
+            writer.writeU16(message.*Member);
+        }
+
+        template <typename Message, typename Reader>
+        static bool read(Message &message, Reader &reader)
+        {
+            return reader.readU16(message.*Member);
+        }
+    };
+
+    // Số nguyên varint; giá trị vượt kiểu của thành viên bị coi là payload sai
+    template <auto Member>
+    struct Varint
+    {
+        template <typename Message, typename Writer>
+        static void write(const Message &message, Writer &writer)
+        {
+            writer.writeVarint(message.*Member);
+        }
+
+        template <typename Message, typename Reader>
+        static bool read(Message &message, Reader &reader)
+        {
+            using Type = detail::MemberType<Message, Member>;
+            uint64_t value;
+            if (!reader.readVarint(value) || value > std::numeric_limits<Type>::max())
+            {
+                return false;
+            }
+            message.*Member = static_cast<Type>(value);
+            return true;
+        }
+    };
+
+    // Chuỗi có độ dài phía trước (1 byte ở v1, varint ở v2)
+    template <auto Member>
+    struct String
+    {
+        template <typename Message, typename Writer>
+        static void write(const Message &message, Writer &writer)
+        {
+            writer.writeString(message.*Member);
+        }
+
+        template <typename Message, typename Reader>
+        static bool read(Message &message, Reader &reader)
+        {
+            std::string_view value;
+            if (!reader.readString(value))
+            {
+                return false;
+            }
+            detail::assignText(message.*Member, value);
+            return true;
+        }
+    };
+
+    // Mảng byte cố định (std::array<uint8_t, N>)
+    template <auto Member>
+    struct Bytes
+    {
+        template <typename Message, typename Writer>
+        static void write(const Message &message, Writer &writer)
+        {
+            writer.writeBytes((message.*Member).data(), (message.*Member).size());
+        }
+
+        template <typename Message, typename Reader>
+        static bool read(Message &message, Reader &reader)
+        {
+            return reader.readBytes((message.*Member).data(), (message.*Member).size());
+        }
+    };
+
+    // Định danh ván cờ: chuỗi game_id ở v1, handle varint ở v2
+    template <auto IdMember, auto HandleMember>
+    struct GameId
+    {
+        template <typename Message, typename Writer>
+        static void write(const Message &message, Writer &writer)
+        {
+            writer.writeGameId(message.*IdMember, message.*HandleMember);
+        }
+
+        template <typename Message, typename Reader>
+        static bool read(Message &message, Reader &reader)
+        {
+            std::string_view game_id;
+            if (!reader.readGameId(game_id, message.*HandleMember))
+            {
+                return false;
+            }
+            detail::assignText(message.*IdMember, game_id);
+            return true;
+        }
+    };
+
+    // Nhóm trường chỉ có ở v2
+    template <typename... Field>
+    struct V2Only
+    {
+        template <typename Message, typename Writer>
+        static void write(const Message &message, Writer &writer)
+        {
+            if (writer.version() >= Protocol::V2)
+            {
+                (Field::write(message, writer), ...);
+            }
+        }
+
+        template <typename Message, typename Reader>
+        static bool read(Message &message, Reader &reader)
+        {
+            return reader.version() < Protocol::V2 || (Field::read(message, reader) && ...);
+        }
+    };
+
+    // Nhóm trường ở cuối payload mà bên gửi cũ có thể bỏ qua: hết payload thì giữ giá trị mặc định
+    template <typename... Field>
+    struct Optional
+    {
+        template <typename Message, typename Writer>
+        static void write(const Message &message, Writer &writer)
+        {
+            (Field::write(message, writer), ...);
+        }
+
+        template <typename Message, typename Reader>
+        static bool read(Message &message, Reader &reader)
+        {
+            return reader.atEnd() || (Field::read(message, reader) && ...);
+        }
+    };
+
+    // Nhóm trường chỉ có mặt khi cờ Flag (đã đọc trước đó) bật
+    template <auto Flag, typename... Field>
+    struct If
+    {
+        template <typename Message, typename Writer>
+        static void write(const Message &message, Writer &writer)
+        {
+            if (message.*Flag)
+            {
+                (Field::write(message, writer), ...);
+            }
+        }
+
+        template <typename Message, typename Reader>
+        static bool read(Message &message, Reader &reader)
+        {
+            return !(message.*Flag) || (Field::read(message, reader) && ...);
+        }
+    };
+
+    // Danh sách phần tử (std::vector<Item>, Item tự khai báo Item::Fields), số phần tử ghi phía trước
+    template <auto Member>
+    struct List
+    {
+        template <typename Message, typename Writer>
+        static void write(const Message &message, Writer &writer)
+        {
+            using Item = typename detail::MemberType<Message, Member>::value_type;
+            const auto &items = message.*Member;
+            size_t count = std::min(items.size(), max_list_size(writer.version()));
+            writer.writeLength(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                Item::Fields::write(items[i], writer);
+            }
+        }
+
+        template <typename Message, typename Reader>
+        static bool read(Message &message, Reader &reader)
+        {
+            using Item = typename detail::MemberType<Message, Member>::value_type;
+            auto &items = message.*Member;
+            items.clear();
+
+            // readLength đã giới hạn số phần tử theo số byte còn lại, reserve không thể quá lớn
+            size_t count;
+            if (!reader.readLength(count))
+            {
+                return false;
+            }
+            items.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                items.emplace_back();
+                if (!Item::Fields::read(items.back(), reader))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    // Toàn bộ payload: các trường theo đúng thứ tự trên dây
+    template <typename... Field>
+    struct Fields
+    {
+        template <typename Message, typename Writer>
+        static void write([[maybe_unused]] const Message &message, [[maybe_unused]] Writer &writer)
+        {
+            (Field::write(message, writer), ...);
+        }
+
+        template <typename Message, typename Reader>
+        static bool read([[maybe_unused]] Message &message, [[maybe_unused]] Reader &reader)
+        {
+            return (Field::read(message, reader) && ...);
+        }
+    };
+}
+
+#endif // MESSAGE_SCHEMA_HPP
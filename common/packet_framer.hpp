@@ -0,0 +1,373 @@
+// common/packet_framer.hpp
+#ifndef PACKET_FRAMER_HPP
+#define PACKET_FRAMER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <arpa/inet.h>
+
+#include "protocol.hpp"
+#include "lz_codec.hpp"
+#include "const.hpp"
+
+/**
+ * @brief Bộ tách gói tin dùng buffer vòng cho mỗi kết nối.
+ *
+ * Dữ liệu được recv thẳng vào vùng trống của buffer vòng (writableSpan/commit),
+ * sau đó next() hoặc drain() trả về các PacketView trỏ vào buffer, không sao chép
+ * payload và không xóa dữ liệu ở đầu buffer. Gói tin chưa nhận đủ được giữ lại
+ * cho lần đọc sau. Chỉ gói tin nằm vắt qua cuối buffer mới được ghép vào vùng tạm.
+ *
+ * Header được đọc theo phiên bản giao thức của kết nối (setVersion): v1 có độ dài 2 byte,
+ * v2 có độ dài varint. Frame v2 hỏng hoặc lớn hơn Protocol::MAX_PAYLOAD_SIZE làm failed()
+ * trả về true; kết nối nên bị đóng.
+ *
+ * Ở v2, frame BATCH được tách ngay trong next(): người gọi nhận lần lượt các gói tin con
+ * như thể chúng đến thành từng frame riêng. Frame COMPRESSED (kể cả trong batch) được
+ * giải nén vào buffer riêng và trả về với type và payload gốc.
+ *
+ * @note PacketView chỉ hợp lệ cho đến lần gọi writableSpan() tiếp theo; payload đã giải nén
+ *       chỉ hợp lệ cho đến lần gọi next() tiếp theo.
+ * @note Không thread-safe: mỗi kết nối sở hữu một PacketFramer riêng.
+ */
+class PacketFramer
+{
+public:
+    static constexpr size_t HEADER_SIZE = 3;     // Header v1
+    static constexpr size_t MAX_HEADER_SIZE = 10; // Header v2: type + request ID 4 byte + varint 32 bit (tối đa 5 byte)
+
+    explicit PacketFramer(size_t capacity = Const::FRAMER_CAPACITY)
+        : buffer(roundUpPowerOfTwo(capacity)),
+          head(0),
+          tail(0),
+          version(Protocol::V1),
+          corrupt(false)
+    {
+    }
+
+    // Đổi phiên bản header cho các frame tiếp theo (sau handshake HELLO)
+    void setVersion(uint8_t protocol_version)
+    {
+        version = protocol_version;
+    }
+
+    uint8_t getVersion() const
+    {
+        return version;
+    }
+
+    // Cho phép hoặc từ chối frame COMPRESSED (máy chủ không nhận dữ liệu nén từ client)
+    void setAcceptCompressed(bool accept)
+    {
+        accept_compressed = accept;
+    }
+
+    // true nếu đã gặp frame không hợp lệ; không tách thêm gói tin nào nữa
+    bool failed() const
+    {
+        return corrupt;
+    }
+
+    /**
+     * @brief Lấy vùng nhớ liên tục còn trống để recv trực tiếp vào.
+     *
+     * Buffer được nới rộng nếu đã đầy hoặc gói tin đang chờ lớn hơn dung lượng hiện tại.
+     *
+     * @param size Tham chiếu nhận kích thước vùng trống.
+     * @return Con trỏ tới đầu vùng trống.
+     */
+    uint8_t *writableSpan(size_t &size)
+    {
+        size_t needed = pendingFrameSize();
+        if (needed > buffer.size() || used() == buffer.size())
+        {
+            grow(needed > buffer.size() ? needed : buffer.size() * 2);
+        }
+
+        size_t write_pos = tail & mask();
+        size_t free_total = buffer.size() - used();
+        size_t until_end = buffer.size() - write_pos;
+        size = free_total < until_end ? free_total : until_end;
+        return buffer.data() + write_pos;
+    }
+
+    // Xác nhận đã ghi bytes byte vào vùng trả về bởi writableSpan()
+    void commit(size_t bytes)
+    {
+        tail += bytes;
+    }
+
+    // Sao chép dữ liệu vào buffer (dùng khi không recv trực tiếp được)
+    void append(const uint8_t *data, size_t size)
+    {
+        while (size > 0)
+        {
+            size_t span_size;
+            uint8_t *span = writableSpan(span_size);
+            size_t chunk = size < span_size ? size : span_size;
+            std::memcpy(span, data, chunk);
+            commit(chunk);
+            data += chunk;
+            size -= chunk;
+        }
+    }
+
+    /**
+     * @brief Tách gói tin hoàn chỉnh tiếp theo.
+     *
+     * @param view Tham chiếu nhận gói tin.
+     * @return true nếu có gói tin hoàn chỉnh, false nếu cần thêm dữ liệu.
+     */
+    bool next(PacketView &view)
+    {
+        while (true)
+        {
+            if (batch_left > 0)
+            {
+                return nextInBatch(view);
+            }
+
+            size_t header_size;
+            uint32_t length;
+            if (!parseHeader(view.type, view.request_id, header_size, length) || used() < header_size + length)
+            {
+                return false;
+            }
+
+            view.length = length;
+            view.payload = contiguous(header_size, length);
+
+            head += header_size + length;
+            if (head == tail)
+            {
+                // Buffer rỗng: quay về đầu để lần recv sau có vùng liên tục lớn nhất
+                head = tail = 0;
+            }
+
+            if (view.type != MessageType::BATCH || version < Protocol::V2)
+            {
+                return inflate(view);
+            }
+
+            // Payload của batch vẫn nằm trong buffer (hoặc scratch) cho đến writableSpan() tiếp theo
+            batch_pos = view.payload;
+            batch_left = length;
+        }
+    }
+
+    /**
+     * @brief Tách mọi gói tin hoàn chỉnh đang có trong buffer.
+     *
+     * @param on_packet Hàm được gọi với từng PacketView.
+     * @return Số gói tin đã tách.
+     */
+    template <typename Callback>
+    size_t drain(Callback &&on_packet)
+    {
+        size_t count = 0;
+        PacketView view;
+        while (next(view))
+        {
+            on_packet(view);
+            ++count;
+        }
+        return count;
+    }
+
+    size_t used() const
+    {
+        return tail - head;
+    }
+
+    size_t capacity() const
+    {
+        return buffer.size();
+    }
+
+private:
+    std::vector<uint8_t> buffer;
+    std::vector<uint8_t> scratch; // Ghép payload vắt qua cuối buffer vòng
+    std::vector<uint8_t> inflated; // Payload của frame COMPRESSED sau khi giải nén
+    size_t head;                  // Vị trí đọc (tăng dần)
+    size_t tail;                  // Vị trí ghi (tăng dần)
+    uint8_t version;              // Phiên bản header của kết nối
+    bool corrupt;                 // Đã gặp frame không hợp lệ
+    bool accept_compressed = true; // false: frame COMPRESSED bị coi là không hợp lệ
+    const uint8_t *batch_pos = nullptr; // Gói tin con tiếp theo của frame BATCH đang tách
+    size_t batch_left = 0;              // Số byte chưa tách của frame BATCH
+
+    static size_t roundUpPowerOfTwo(size_t value)
+    {
+        size_t result = 1;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    size_t mask() const
+    {
+        return buffer.size() - 1;
+    }
+
+    uint8_t at(size_t offset) const
+    {
+        return buffer[(head + offset) & mask()];
+    }
+
+    /**
+     * @brief Đọc header của frame đầu buffer.
+     *
+     * v1 giữ nguyên cách mã hóa độ dài của Packet::serialize (htons rồi ghi byte cao trước).
+     *
+     * @return false nếu header chưa đủ dữ liệu hoặc không hợp lệ (khi đó corrupt = true).
+     */
+    bool parseHeader(MessageType &type, uint32_t &request_id, size_t &header_size, uint32_t &length)
+    {
+        if (corrupt)
+        {
+            return false;
+        }
+
+        if (version < Protocol::V2)
+        {
+            if (used() < HEADER_SIZE)
+            {
+                return false;
+            }
+            uint16_t raw = (static_cast<uint16_t>(at(1)) << 8) |
+                           static_cast<uint16_t>(at(2));
+            type = static_cast<MessageType>(at(0));
+            request_id = Protocol::NO_REQUEST_ID;
+            header_size = HEADER_SIZE;
+            length = ntohs(raw);
+            return true;
+        }
+
+        uint8_t header[MAX_HEADER_SIZE];
+        size_t available = used() < MAX_HEADER_SIZE ? used() : MAX_HEADER_SIZE;
+        for (size_t i = 0; i < available; ++i)
+        {
+            header[i] = at(i);
+        }
+
+        int status = parseFrameHeaderV2(header, available, type, request_id, header_size, length);
+        corrupt = status < 0;
+        return status > 0;
+    }
+
+    /**
+     * @brief Tách gói tin con tiếp theo của frame BATCH đang mở.
+     *
+     * Gói tin con luôn có header v2 (có thể kèm request ID) và không được là BATCH lồng nhau.
+     */
+    bool nextInBatch(PacketView &view)
+    {
+        size_t header_size;
+        uint32_t length;
+        if (parseFrameHeaderV2(batch_pos, batch_left, view.type, view.request_id, header_size, length) <= 0 ||
+            length > batch_left - header_size ||
+            view.type == MessageType::BATCH)
+        {
+            corrupt = true;
+            batch_left = 0;
+            return false;
+        }
+
+        view.length = length;
+        view.payload = batch_pos + header_size;
+
+        batch_pos += header_size + length;
+        batch_left -= header_size + length;
+        return inflate(view);
+    }
+
+    /**
+     * @brief Giải nén frame COMPRESSED (v2) tại chỗ: view nhận type và payload gốc.
+     *
+     * Độ dài gốc khai báo không được vượt quá mức giãn tối đa của bộ nén cho khối nén đi kèm,
+     * để một frame nhỏ không buộc framer cấp phát tới Protocol::MAX_PAYLOAD_SIZE.
+     *
+     * @return false nếu khối nén hỏng hoặc COMPRESSED bị từ chối (khi đó corrupt = true);
+     * frame khác được giữ nguyên.
+     */
+    bool inflate(PacketView &view)
+    {
+        if (view.type != MessageType::COMPRESSED || version < Protocol::V2)
+        {
+            return true;
+        }
+
+        size_t pos = 1;
+        uint64_t raw_length;
+        MessageType inner = view.length > 0 ? static_cast<MessageType>(view.payload[0]) : MessageType::COMPRESSED;
+        if (!accept_compressed || inner == MessageType::COMPRESSED || inner == MessageType::BATCH ||
+            !read_varint(view.payload, view.length, pos, raw_length, 5) ||
+            raw_length > Protocol::MAX_PAYLOAD_SIZE ||
+            raw_length > Lz::decompressBound(view.length - pos))
+        {
+            corrupt = true;
+            batch_left = 0;
+            return false;
+        }
+
+        inflated.resize(raw_length);
+        if (!Lz::decompress(view.payload + pos, view.length - pos, inflated.data(), inflated.size()))
+        {
+            corrupt = true;
+            batch_left = 0;
+            return false;
+        }
+
+        view.type = inner;
+        view.length = static_cast<uint32_t>(raw_length);
+        view.payload = inflated.data();
+        return true;
+    }
+
+    size_t pendingFrameSize()
+    {
+        MessageType type;
+        uint32_t request_id;
+        size_t header_size;
+        uint32_t length;
+        if (!parseHeader(type, request_id, header_size, length))
+        {
+            return MAX_HEADER_SIZE;
+        }
+        return header_size + length;
+    }
+
+    const uint8_t *contiguous(size_t offset, size_t size)
+    {
+        size_t start = (head + offset) & mask();
+        if (start + size <= buffer.size())
+        {
+            return buffer.data() + start;
+        }
+
+        size_t first = buffer.size() - start;
+        scratch.resize(size);
+        std::memcpy(scratch.data(), buffer.data() + start, first);
+        std::memcpy(scratch.data() + first, buffer.data(), size - first);
+        return scratch.data();
+    }
+
+    void grow(size_t min_capacity)
+    {
+        std::vector<uint8_t> larger(roundUpPowerOfTwo(min_capacity));
+        size_t size = used();
+        for (size_t i = 0; i < size; ++i)
+        {
+            larger[i] = at(i);
+        }
+        buffer.swap(larger);
+        head = 0;
+        tail = size;
+    }
+};
+
+#endif // PACKET_FRAMER_HPP
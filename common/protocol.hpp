@@ -1,12 +1,32 @@
 #ifndef PROTOCOL_HPP
 #define PROTOCOL_HPP
 
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 #include <string>
+#include <arpa/inet.h>
 
 #include "utils.hpp"
 
+// Phiên bản giao thức
+namespace Protocol
+{
+    // v1: [type 1 byte][length 2 byte][payload], chuỗi và số phần tử dùng độ dài 1 byte
+    const uint8_t V1 = 1;
+    // v2: [type 1 byte][length varint][payload], chuỗi và số phần tử dùng varint
+    const uint8_t V2 = 2;
+    const uint8_t LATEST = V2;
+
+    // Payload lớn nhất chấp nhận ở v2; frame lớn hơn bị coi là lỗi giao thức
+    const uint32_t MAX_PAYLOAD_SIZE = 16 * 1024 * 1024;
+
+    // v2: bit cao của byte type báo header có request ID 32 bit (big-endian) ngay sau type
+    const uint8_t REQUEST_ID_FLAG = 0x80;
+    // Request ID 0 nghĩa là không có; server chỉ gắn request ID vào câu trả lời cho đúng client đã hỏi
+    const uint32_t NO_REQUEST_ID = 0;
+}
+
 // Enum cho các loại thông điệp
 enum class MessageType : uint8_t
 {
@@ -14,6 +34,14 @@ enum class MessageType : uint8_t
     TEST = 0x00,
     RESPONSE = 0x01,
 
+    // Handshake: luôn gửi bằng frame v1, sau HELLO_ACK hai bên chuyển sang phiên bản đã chọn
+    HELLO = 0x02,
+    HELLO_ACK = 0x03,
+    // v2: nhiều frame con [type][length varint][payload] nối liền trong một frame
+    BATCH = 0x04,
+    // v2: payload nén LZ của một thông điệp: [type gốc][độ dài gốc varint][khối Lz]
+    COMPRESSED = 0x05,
+
     // Register
     REGISTER = 0x10,
     REGISTER_SUCCESS = 0x11,
@@ -39,6 +67,10 @@ enum class MessageType : uint8_t
     GAME_STATUS_UPDATE = 0x43,
     GAME_END = 0x44,
     SURRENDER = 0x45,
+    MOVE_V2 = 0x46, // Nước đi dạng nhị phân: handle + ply + chess::Move 16 bit
+    GAME_MOVE_DELTA = 0x47, // v2: chỉ gửi nước đi vừa áp dụng thay cho GAME_STATUS_UPDATE
+    GAME_KEYFRAME = 0x48,   // v2: toàn bộ bàn cờ dạng chess::PackedBoard (24 byte)
+    RESYNC_REQUEST = 0x49,  // v2: client xin keyframe khi lệch trạng thái
 
     // Challenge
     CHALLENGE_REQUEST = 0x50,
@@ -68,8 +100,9 @@ enum class MessageType : uint8_t
 struct Packet
 {
     MessageType type;
-    uint16_t length;
+    uint32_t length;
     std::vector<uint8_t> payload;
+    uint32_t request_id = Protocol::NO_REQUEST_ID; // Chỉ có ở v2
 
     std::vector<uint8_t> serialize() const
     {
@@ -82,4 +115,110 @@ struct Packet
     }
 };
 
+// Kích thước header của frame chứa payload_size byte payload
+inline size_t frameHeaderSize(size_t payload_size, uint8_t version, uint32_t request_id = Protocol::NO_REQUEST_ID)
+{
+    if (version >= Protocol::V2)
+    {
+        return 1 + (request_id != Protocol::NO_REQUEST_ID ? 4 : 0) + varint_size(payload_size);
+    }
+    return 3;
+}
+
+/**
+ * @brief Ghi header của frame vào out (đủ chỗ cho frameHeaderSize byte).
+ *
+ * v1 giữ nguyên cách mã hóa của Packet::serialize (htons rồi ghi byte cao trước);
+ * v2 ghi request ID (nếu có) rồi độ dài thật dạng varint. v1 không mang request ID.
+ *
+ * @return Con trỏ ngay sau header, nơi bắt đầu payload.
+ */
+inline uint8_t *storeFrameHeader(uint8_t *out, MessageType type, size_t payload_size, uint8_t version,
+                                 uint32_t request_id = Protocol::NO_REQUEST_ID)
+{
+    *out++ = static_cast<uint8_t>(type);
+    if (version >= Protocol::V2)
+    {
+        if (request_id != Protocol::NO_REQUEST_ID)
+        {
+            out[-1] |= Protocol::REQUEST_ID_FLAG;
+            out = store_big_endian_32(out, request_id);
+        }
+        return store_varint(out, payload_size);
+    }
+    uint16_t length = htons(static_cast<uint16_t>(payload_size));
+    *out++ = static_cast<uint8_t>((length >> 8) & 0xFF);
+    *out++ = static_cast<uint8_t>(length & 0xFF);
+    return out;
+}
+
+// Đóng gói header và payload theo phiên bản giao thức
+inline std::vector<uint8_t> encodeFrame(MessageType type, const std::vector<uint8_t> &payload, uint8_t version,
+                                        uint32_t request_id = Protocol::NO_REQUEST_ID)
+{
+    std::vector<uint8_t> frame(frameHeaderSize(payload.size(), version, request_id) + payload.size());
+    uint8_t *body = storeFrameHeader(frame.data(), type, payload.size(), version, request_id);
+    std::copy(payload.begin(), payload.end(), body);
+    return frame;
+}
+
+/**
+ * @brief Đọc header v2 từ vùng nhớ liên tục.
+ *
+ * @return 1 nếu đọc xong, 0 nếu chưa đủ dữ liệu, -1 nếu header không hợp lệ
+ * (độ dài varint quá 5 byte hoặc payload lớn hơn Protocol::MAX_PAYLOAD_SIZE).
+ */
+inline int parseFrameHeaderV2(const uint8_t *data, size_t size, MessageType &type, uint32_t &request_id,
+                              size_t &header_size, uint32_t &length)
+{
+    if (size < 1)
+    {
+        return 0;
+    }
+
+    size_t pos = 1;
+    request_id = Protocol::NO_REQUEST_ID;
+    if (data[0] & Protocol::REQUEST_ID_FLAG)
+    {
+        if (size < 5)
+        {
+            return 0;
+        }
+        request_id = load_big_endian_32(data + 1);
+        pos = 5;
+    }
+
+    uint64_t value;
+    size_t length_start = pos;
+    if (!read_varint(data, size, pos, value, 5))
+    {
+        // Đủ 5 byte mà vẫn không kết thúc varint: frame hỏng
+        return size - length_start >= 5 ? -1 : 0;
+    }
+    if (value > Protocol::MAX_PAYLOAD_SIZE)
+    {
+        return -1;
+    }
+
+    type = static_cast<MessageType>(data[0] & ~Protocol::REQUEST_ID_FLAG);
+    header_size = pos;
+    length = static_cast<uint32_t>(value);
+    return 1;
+}
+
+// Gói tin tham chiếu trực tiếp vào buffer nhận (không sao chép payload).
+// Con trỏ payload chỉ hợp lệ đến lần đọc socket tiếp theo.
+struct PacketView
+{
+    MessageType type;
+    uint32_t length;
+    const uint8_t *payload;
+    uint32_t request_id = Protocol::NO_REQUEST_ID;
+
+    Packet toPacket() const
+    {
+        return Packet{type, length, std::vector<uint8_t>(payload, payload + length), request_id};
+    }
+};
+
 #endif // PROTOCOL_HPP
\ No newline at end of file
@@ -38,4 +38,82 @@ inline uint32_t from_big_endian_32(const std::vector<uint8_t>& bytes, size_t sta
            static_cast<uint32_t>(bytes[start + 3]);
 }
 
+// Ghi giá trị 2 byte dạng big-endian vào out, trả về con trỏ ngay sau phần đã ghi
+inline uint8_t* store_big_endian_16(uint8_t* out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value >> 8);
+    out[1] = static_cast<uint8_t>(value);
+    return out + 2;
+}
+
+// Ghi giá trị 4 byte dạng big-endian vào out, trả về con trỏ ngay sau phần đã ghi
+inline uint8_t* store_big_endian_32(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+    return out + 4;
+}
+
+// Đọc giá trị 2 byte big-endian từ con trỏ (không cần vector)
+inline uint16_t load_big_endian_16(const uint8_t* in) {
+    return static_cast<uint16_t>((static_cast<uint16_t>(in[0]) << 8) | in[1]);
+}
+
+// Đọc giá trị 4 byte big-endian từ con trỏ (không cần vector)
+inline uint32_t load_big_endian_32(const uint8_t* in) {
+    return (static_cast<uint32_t>(in[0]) << 24) |
+           (static_cast<uint32_t>(in[1]) << 16) |
+           (static_cast<uint32_t>(in[2]) << 8) |
+           static_cast<uint32_t>(in[3]);
+}
+
+// Số byte cần để ghi value dưới dạng varint
+inline size_t varint_size(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+// Ghi số nguyên không dấu dạng varint (LEB128: 7 bit mỗi byte, nhóm thấp trước,
+// bit cao = 1 nếu còn byte tiếp theo). Giá trị nhỏ hơn 128 chỉ chiếm 1 byte.
+inline void append_varint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Ghi varint vào out (đủ chỗ cho varint_size(value) byte), trả về con trỏ ngay sau phần đã ghi
+inline uint8_t* store_varint(uint8_t* out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<uint8_t>(value);
+    return out;
+}
+
+// Đọc varint bắt đầu tại pos, tối đa max_bytes byte.
+// Trả về false nếu thiếu dữ liệu hoặc varint dài quá max_bytes; pos chỉ tiến khi thành công.
+inline bool read_varint(const uint8_t* data, size_t size, size_t& pos, uint64_t& value, size_t max_bytes = 10) {
+    uint64_t result = 0;
+    for (size_t i = 0; i < max_bytes; ++i) {
+        if (pos + i >= size) {
+            return false;
+        }
+        uint8_t byte = data[pos + i];
+        result |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+        if ((byte & 0x80) == 0) {
+            value = result;
+            pos += i + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
 #endif // UTILS_HPP
\ No newline at end of file
@@ -0,0 +1,119 @@
+// Chạy một harness libFuzzer khi trình biên dịch không có -fsanitize=fuzzer (g++).
+//
+// Mỗi tệp (hoặc mọi tệp trong thư mục) ở đối số được chạy nguyên vẹn, sau đó -runs=N đầu vào
+// đột biến ngẫu nhiên từ chính các tệp đó (lật bit, ghi đè, chèn, xóa, cắt cụt, lặp đoạn).
+// Hạt giống cố định (-seed=S) nên một lần chạy hỏng luôn lặp lại được.
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+using Input = std::vector<uint8_t>;
+
+static Input readFile(const std::filesystem::path &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return Input(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void mutate(Input &input, std::mt19937 &random)
+{
+    int count = 1 + random() % 4;
+    for (int i = 0; i < count; ++i)
+    {
+        size_t pos = input.empty() ? 0 : random() % input.size();
+        switch (random() % 6)
+        {
+        case 0:
+            if (!input.empty())
+                input[pos] ^= static_cast<uint8_t>(1u << (random() % 8));
+            break;
+        case 1:
+            if (!input.empty())
+                input[pos] = static_cast<uint8_t>(random());
+            break;
+        case 2:
+            input.insert(input.begin() + pos, static_cast<uint8_t>(random()));
+            break;
+        case 3:
+            if (!input.empty())
+                input.erase(input.begin() + pos);
+            break;
+        case 4:
+            input.resize(pos);
+            break;
+        default:
+            if (!input.empty())
+            {
+                size_t length = 1 + random() % (input.size() - pos);
+                Input chunk(input.begin() + pos, input.begin() + pos + length);
+                input.insert(input.begin() + random() % (input.size() + 1), chunk.begin(), chunk.end());
+            }
+            break;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t runs = 100000;
+    unsigned seed = 1;
+    std::vector<Input> corpus;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("-runs=", 0) == 0)
+        {
+            runs = std::strtoul(arg.c_str() + 6, nullptr, 10);
+        }
+        else if (arg.rfind("-seed=", 0) == 0)
+        {
+            seed = static_cast<unsigned>(std::strtoul(arg.c_str() + 6, nullptr, 10));
+        }
+        else if (std::filesystem::is_directory(arg))
+        {
+            for (const auto &entry : std::filesystem::directory_iterator(arg))
+            {
+                corpus.push_back(readFile(entry.path()));
+            }
+        }
+        else
+        {
+            corpus.push_back(readFile(arg));
+        }
+    }
+
+    for (const Input &input : corpus)
+    {
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+
+    std::mt19937 random(seed);
+    for (size_t run = 0; run < runs; ++run)
+    {
+        Input input;
+        if (!corpus.empty())
+        {
+            input = corpus[random() % corpus.size()];
+        }
+        else
+        {
+            input.resize(random() % 64);
+            for (uint8_t &byte : input)
+                byte = static_cast<uint8_t>(random());
+        }
+        mutate(input, random);
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+
+    std::cout << "Executed " << corpus.size() << " corpus inputs and " << runs << " mutated inputs" << std::endl;
+    return 0;
+}
@@ -0,0 +1,68 @@
+// Harness libFuzzer cho mọi deserialize() / decode() trong common/message.hpp.
+//
+// Đầu vào: [chỉ số thông điệp trong AllMessages][bit thấp: v1/v2][payload].
+// Kiểm tra:
+//   - deserialize() và decode() không đọc ngoài payload (ASan) với payload bất kỳ;
+//   - bản sở hữu dữ liệu và bản view cùng chấp nhận / từ chối và mã hóa lại ra cùng byte;
+//   - payload đã chấp nhận mã hóa lại ổn định: decode(serialize(m)) mã hóa ra đúng serialize(m).
+// Build: make fuzz (clang, -fsanitize=fuzzer) hoặc make fuzz_check (g++, fuzz/driver/standalone_main.cpp).
+#include <cstdlib>
+#include <vector>
+
+#include "../common/message.hpp"
+
+namespace
+{
+    template <typename Message>
+    void fuzzMessage(const uint8_t *data, size_t size, uint8_t version)
+    {
+        using View = MessageView<Message>;
+
+        // Bản sao đúng kích thước để ASan bắt mọi lần đọc quá payload
+        std::vector<uint8_t> payload(data, data + size);
+        Message owned = Message::deserialize(payload, version);
+        owned.serialize(version);
+
+        Message decoded{};
+        View view{};
+        bool accepted = Message::decode(payload.data(), payload.size(), decoded, version);
+        if (accepted != View::decode(payload.data(), payload.size(), view, version))
+        {
+            std::abort();
+        }
+        if (!accepted)
+        {
+            return;
+        }
+
+        std::vector<uint8_t> encoded = decoded.serialize(version);
+        if (view.serialize(version) != encoded || encodedSize(decoded, version) < encoded.size())
+        {
+            std::abort();
+        }
+
+        Message again{};
+        if (!Message::decode(encoded.data(), encoded.size(), again, version) || again.serialize(version) != encoded)
+        {
+            std::abort();
+        }
+    }
+
+    template <typename... Message>
+    void dispatch(size_t index, const uint8_t *data, size_t size, uint8_t version, MessageList<Message...>)
+    {
+        size_t current = 0;
+        ((current++ == index ? fuzzMessage<Message>(data, size, version) : void()), ...);
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size < 2)
+    {
+        return 0;
+    }
+    uint8_t version = (data[1] & 1) ? Protocol::V2 : Protocol::V1;
+    dispatch(data[0] % AllMessages::size, data + 2, size - 2, version, AllMessages{});
+    return 0;
+}
@@ -0,0 +1,39 @@
+// Harness libFuzzer cho PacketFramer: header v1/v2, request ID, frame BATCH và COMPRESSED.
+//
+// Đầu vào: [bit thấp: v1/v2][kích thước mỗi lần append][luồng byte nhận từ socket].
+// Buffer framer nhỏ để đi qua cả nhánh vòng ring và nhánh scratch cho frame lớn.
+#include <cstdlib>
+
+#include "../common/packet_framer.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size < 2)
+    {
+        return 0;
+    }
+
+    PacketFramer framer(64);
+    framer.setVersion((data[0] & 1) ? Protocol::V2 : Protocol::V1);
+    size_t chunk = data[1] % 96 + 1;
+    data += 2;
+    size -= 2;
+
+    volatile uint8_t sink = 0;
+    while (size > 0 && !framer.failed())
+    {
+        size_t length = size < chunk ? size : chunk;
+        framer.append(data, length);
+        data += length;
+        size -= length;
+
+        framer.drain([&sink](const PacketView &view)
+                     {
+            // Đọc hết payload để ASan kiểm tra con trỏ view (kể cả payload đã giải nén)
+            for (uint32_t i = 0; i < view.length; ++i)
+            {
+                sink = sink + view.payload[i];
+            } });
+    }
+    return 0;
+}
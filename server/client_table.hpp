@@ -0,0 +1,300 @@
+#ifndef CLIENT_TABLE_HPP
+#define CLIENT_TABLE_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../common/packet_framer.hpp"
+#include "../common/const.hpp"
+
+// Gói tin đã đóng gói, bất biến và dùng chung: một lần broadcast chỉ đóng gói một lần
+// rồi xếp cùng một buffer vào hàng đợi của mọi người nhận
+using OutboundFrame = std::shared_ptr<const std::vector<uint8_t>>;
+
+struct ClientInfo
+{
+    PacketFramer framer;
+    std::mutex mutex;
+    std::string username = "";
+    std::atomic<uint8_t> protocol_version{Protocol::V1}; // Phiên bản đã thỏa thuận qua HELLO
+
+    // Hàng đợi gửi: các gói tin đã đóng gói, được xả bằng writev
+    std::mutex write_mutex;
+    std::deque<OutboundFrame> outbound;
+    size_t outbound_offset = 0; // Số byte của gói đầu hàng đợi đã gửi
+    size_t outbound_bytes = 0;  // Tổng kích thước các gói chưa gửi xong (kể cả đang gửi bất đồng bộ)
+    std::chrono::steady_clock::time_point over_limit_since; // Mốc bắt đầu vượt giới hạn, rỗng nếu không vượt
+    bool send_in_flight = false; // Backend bất đồng bộ (io_uring) đang gửi một chuỗi gói tin
+    std::vector<OutboundFrame> batch_frames; // Frame gửi trong SendBatch đang mở, xếp vào outbound khi batch kết thúc
+    bool closed = false;
+
+    ClientInfo()
+    {
+        // Client không gửi frame COMPRESSED; từ chối để không phải giải nén dữ liệu không tin cậy
+        framer.setAcceptCompressed(false);
+    }
+};
+
+/**
+ * @brief Bảng các client đang kết nối, chia thành nhiều shard khóa độc lập.
+ *
+ * Bảng fd -> ClientInfo được chia theo fd, chỉ mục username -> fd được chia theo
+ * hash của username. Mỗi shard dùng std::shared_mutex: các thao tác tra cứu (chiếm
+ * đa số: gửi gói tin, getUsername, getClientFD) chỉ cần khóa đọc, còn thêm/xóa client
+ * và đổi username mới cần khóa ghi, và chỉ trên shard liên quan.
+ *
+ * Ngoài ra các username đang đăng nhập được giữ trong một tập có thứ tự để liệt kê theo
+ * trang (usernamesAfter) với chi phí tỉ lệ với kích thước trang.
+ *
+ * @tparam SHARD_COUNT Số shard (lũy thừa của 2).
+ */
+template <size_t SHARD_COUNT>
+class BasicClientTable
+{
+    static_assert(SHARD_COUNT > 0 && (SHARD_COUNT & (SHARD_COUNT - 1)) == 0,
+                  "SHARD_COUNT phải là lũy thừa của 2");
+
+public:
+    std::shared_ptr<ClientInfo> find(int client_fd) const
+    {
+        const ClientShard &shard = clientShard(client_fd);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.clients.find(client_fd);
+        if (it == shard.clients.end())
+        {
+            return nullptr;
+        }
+        return it->second;
+    }
+
+    std::shared_ptr<ClientInfo> findOrCreate(int client_fd)
+    {
+        std::shared_ptr<ClientInfo> client = find(client_fd);
+        if (client)
+        {
+            return client;
+        }
+
+        ClientShard &shard = clientShard(client_fd);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        std::shared_ptr<ClientInfo> &slot = shard.clients[client_fd];
+        if (!slot)
+        {
+            slot = std::make_shared<ClientInfo>();
+        }
+        return slot;
+    }
+
+    /**
+     * @brief Xóa client khỏi bảng và khỏi chỉ mục username.
+     *
+     * @return ClientInfo đã xóa, hoặc nullptr nếu fd không tồn tại.
+     */
+    std::shared_ptr<ClientInfo> erase(int client_fd)
+    {
+        std::shared_ptr<ClientInfo> client;
+        std::string username;
+        {
+            ClientShard &shard = clientShard(client_fd);
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.clients.find(client_fd);
+            if (it == shard.clients.end())
+            {
+                return nullptr;
+            }
+            client = it->second;
+            username = client->username;
+            shard.clients.erase(it);
+        }
+
+        unindexUsername(username, client_fd);
+        return client;
+    }
+
+    void setUsername(int client_fd, const std::string &username)
+    {
+        std::string previous;
+        {
+            ClientShard &shard = clientShard(client_fd);
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.clients.find(client_fd);
+            if (it == shard.clients.end())
+            {
+                return;
+            }
+            previous = it->second->username;
+            it->second->username = username;
+        }
+
+        if (previous != username)
+        {
+            unindexUsername(previous, client_fd);
+        }
+        if (!username.empty())
+        {
+            // Khóa shard trước rồi mới khóa online_mutex, cùng thứ tự với unindexUsername
+            UserShard &shard = userShard(username);
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            shard.fds[username] = client_fd;
+            std::unique_lock<std::shared_mutex> online_lock(online_mutex);
+            online.insert(username);
+        }
+    }
+
+    /**
+     * @brief Lấy tối đa limit username đang đăng nhập đứng sau cursor theo thứ tự từ điển.
+     *
+     * @param cursor Username cuối cùng của trang trước (rỗng: từ đầu).
+     */
+    std::vector<std::string> usernamesAfter(const std::string &cursor, size_t limit) const
+    {
+        std::vector<std::string> page;
+        std::shared_lock<std::shared_mutex> lock(online_mutex);
+        for (auto it = online.upper_bound(cursor); it != online.end() && page.size() < limit; ++it)
+        {
+            page.push_back(*it);
+        }
+        return page;
+    }
+
+    std::string getUsername(int client_fd) const
+    {
+        const ClientShard &shard = clientShard(client_fd);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.clients.find(client_fd);
+        if (it == shard.clients.end())
+        {
+            return "";
+        }
+        return it->second->username;
+    }
+
+    int getClientFD(const std::string &username) const
+    {
+        const UserShard &shard = userShard(username);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.fds.find(username);
+        if (it == shard.fds.end())
+        {
+            return -1;
+        }
+        return it->second;
+    }
+
+    /**
+     * @brief Gọi hàm cho từng client, khóa đọc lần lượt từng shard.
+     */
+    void forEach(const std::function<void(int, const std::shared_ptr<ClientInfo> &)> &visit) const
+    {
+        for (const ClientShard &shard : client_shards)
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            for (const auto &pair : shard.clients)
+            {
+                visit(pair.first, pair.second);
+            }
+        }
+    }
+
+    // Xóa toàn bộ bảng, trả về các client đã xóa
+    std::vector<std::pair<int, std::shared_ptr<ClientInfo>>> clear()
+    {
+        std::vector<std::pair<int, std::shared_ptr<ClientInfo>>> removed;
+        for (ClientShard &shard : client_shards)
+        {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            removed.insert(removed.end(), shard.clients.begin(), shard.clients.end());
+            shard.clients.clear();
+        }
+        for (UserShard &shard : user_shards)
+        {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            shard.fds.clear();
+        }
+        {
+            std::unique_lock<std::shared_mutex> lock(online_mutex);
+            online.clear();
+        }
+        return removed;
+    }
+
+private:
+    struct ClientShard
+    {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<int, std::shared_ptr<ClientInfo>> clients;
+    };
+
+    struct UserShard
+    {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, int> fds;
+    };
+
+    // Mỗi shard nằm trên cache line riêng để tránh false sharing giữa các khóa
+    struct alignas(64) PaddedClientShard : ClientShard
+    {
+    };
+    struct alignas(64) PaddedUserShard : UserShard
+    {
+    };
+
+    std::array<PaddedClientShard, SHARD_COUNT> client_shards;
+    std::array<PaddedUserShard, SHARD_COUNT> user_shards;
+
+    // Username đang đăng nhập, có thứ tự; chỉ đổi khi đăng nhập/đăng xuất
+    mutable std::shared_mutex online_mutex;
+    std::set<std::string> online;
+
+    ClientShard &clientShard(int client_fd)
+    {
+        return client_shards[static_cast<size_t>(client_fd) & (SHARD_COUNT - 1)];
+    }
+
+    const ClientShard &clientShard(int client_fd) const
+    {
+        return client_shards[static_cast<size_t>(client_fd) & (SHARD_COUNT - 1)];
+    }
+
+    UserShard &userShard(const std::string &username)
+    {
+        return user_shards[std::hash<std::string>{}(username) & (SHARD_COUNT - 1)];
+    }
+
+    const UserShard &userShard(const std::string &username) const
+    {
+        return user_shards[std::hash<std::string>{}(username) & (SHARD_COUNT - 1)];
+    }
+
+    // Chỉ xóa khỏi chỉ mục nếu username vẫn trỏ tới đúng fd này
+    void unindexUsername(const std::string &username, int client_fd)
+    {
+        if (username.empty())
+        {
+            return;
+        }
+        UserShard &shard = userShard(username);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.fds.find(username);
+        if (it != shard.fds.end() && it->second == client_fd)
+        {
+            shard.fds.erase(it);
+            std::unique_lock<std::shared_mutex> online_lock(online_mutex);
+            online.erase(username);
+        }
+    }
+};
+
+using ClientTable = BasicClientTable<Const::CLIENT_TABLE_SHARDS>;
+
+#endif // CLIENT_TABLE_HPP
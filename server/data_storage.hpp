@@ -5,6 +5,8 @@
 #include <unordered_map>
 #include <mutex>
 #include <chrono>
+#include <algorithm>
+#include <cstdint>
 #include <unistd.h>
 #include <limits.h>
 
@@ -12,6 +14,8 @@
 #include "../common/json_handler.hpp"
 #include "../common/const.hpp"
 
+#include "game_handle.hpp"
+
 using json = nlohmann::json;
 
 struct UserModel
@@ -106,6 +110,18 @@ struct MatchModel
     }
 };
 
+/**
+ * @brief Thông tin tóm tắt của một trận đấu dùng cho danh sách lịch sử (không kèm nước đi).
+ */
+struct MatchSummary
+{
+    std::string game_id;
+    std::string white_username;
+    std::string black_username;
+    std::string result;
+    std::chrono::time_point<std::chrono::system_clock> start_time;
+};
+
 /**
  * @brief Lớp DataStorage là một Singleton quản lý dữ liệu người dùng trong ứng dụng TCP_Chess.
  *
@@ -218,22 +234,29 @@ public:
     /**
      * @brief Đăng ký một trận đấu mới.
      *
-     * @param game_id ID của trận đấu.
+     * @param handle Handle của ván cờ, khóa của trận đấu trong bộ nhớ.
+     * @param game_id ID dễ đọc của trận đấu, được lưu vào matches.json.
      * @param white_username Tên người chơi cầm quân trắng.
      * @param black_username Tên người chơi cầm quân đen.
      * @param start_fen Vị trí FEN khởi đầu.
      * @return true nếu đăng ký thành công, false nếu trận đấu đã tồn tại.
      */
-    bool registerMatch(const std::string &game_id, const std::string &white_username, const std::string &black_username, const std::string &start_fen)
+    bool registerMatch(GameHandle handle, const std::string &game_id, const std::string &white_username, const std::string &black_username, const std::string &start_fen)
     {
         std::lock_guard<std::mutex> lock(matches_mutex);
 
-        if (matches.find(game_id) != matches.end())
+        if (matches.find(handle) != matches.end() || match_handles.find(game_id) != match_handles.end())
         {
             return false; // Trận đấu đã tồn tại
         }
 
-        matches[game_id] = MatchModel{
+        match_handles[game_id] = handle;
+        user_matches[white_username].push_back(handle);
+        if (black_username != white_username)
+        {
+            user_matches[black_username].push_back(handle);
+        }
+        matches[handle] = MatchModel{
             game_id,
             white_username,
             black_username,
@@ -251,16 +274,16 @@ public:
     /**
      * @brief Cập nhật kết quả của một trận đấu.
      *
-     * @param game_id ID của trận đấu.
+     * @param handle Handle của trận đấu.
      * @param result Kết quả trận đấu.
      * @param reason Lý do kết quả.
      * @return true nếu cập nhật thành công, false nếu không tìm thấy trận đấu.
      */
-    bool updateMatchResult(const std::string &game_id, const std::string &result, const std::string &reason)
+    bool updateMatchResult(GameHandle handle, const std::string &result, const std::string &reason)
     {
         std::lock_guard<std::mutex> lock(matches_mutex);
 
-        auto it = matches.find(game_id);
+        auto it = matches.find(handle);
         if (it != matches.end())
         {
             it->second.result = result;
@@ -281,10 +304,10 @@ public:
     {
         std::lock_guard<std::mutex> lock(matches_mutex);
 
-        auto it = matches.find(game_id);
-        if (it != matches.end())
+        auto handle_it = match_handles.find(game_id);
+        if (handle_it != match_handles.end())
         {
-            return it->second;
+            return matches.at(handle_it->second);
         }
         throw std::runtime_error("Match not found.");
     }
@@ -292,15 +315,15 @@ public:
     /**
      * @brief Thêm một nước đi vào trận đấu.
      *
-     * @param game_id ID của trận đấu.
+     * @param handle Handle của trận đấu.
      * @param move Nước đi cần thêm.
      * @return true nếu thành công, false nếu không tìm thấy trận đấu.
      */
-    bool addMove(const std::string &game_id, const std::string &uci_move, const std::string &fen)
+    bool addMove(GameHandle handle, const std::string &uci_move, const std::string &fen)
     {
         std::lock_guard<std::mutex> lock(matches_mutex);
 
-        auto it = matches.find(game_id);
+        auto it = matches.find(handle);
         if (it != matches.end())
         {
             MatchModel::Move move;
@@ -318,28 +341,68 @@ public:
      * @brief Lấy lịch sử trận đấu của một người chơi.
      *
      * @param username Tên người chơi cần lấy lịch sử.
-     * @return std::vector<MatchModel> chứa lịch sử trận đấu của người chơi.
+     * @return std::vector<MatchModel> chứa lịch sử trận đấu của người chơi, trận mới nhất trước.
      */
     std::vector<MatchModel> getMatchHistory(const std::string &username)
     {
         std::lock_guard<std::mutex> lock(matches_mutex);
 
         std::vector<MatchModel> match_history;
-        for (const auto &[game_id, match] : matches)
+        auto it = user_matches.find(username);
+        if (it != user_matches.end())
         {
-            if (match.white_username == username || match.black_username == username)
+            for (auto handle = it->second.rbegin(); handle != it->second.rend(); ++handle)
             {
-                match_history.push_back(match);
+                match_history.push_back(matches.at(*handle));
             }
         }
         return match_history;
     }
 
+    /**
+     * @brief Lấy một trang lịch sử trận đấu của người chơi, trận mới nhất trước.
+     *
+     * Lịch sử của mỗi người chơi được đánh chỉ mục theo thứ tự bắt đầu trận, nên chi phí
+     * tỉ lệ với kích thước trang chứ không với tổng số trận đấu. Chỉ trả về MatchSummary
+     * để không phải sao chép danh sách nước đi khi đang giữ matches_mutex.
+     *
+     * @param username Tên người chơi.
+     * @param before Chỉ lấy các trận có vị trí nhỏ hơn before trong lịch sử (SIZE_MAX: từ trận mới nhất).
+     * @param limit Số trận tối đa.
+     * @param next_before Nhận giá trị before cho trang tiếp theo, 0 nếu đã hết.
+     */
+    std::vector<MatchSummary> getMatchHistoryPage(const std::string &username, size_t before, size_t limit, size_t &next_before)
+    {
+        std::lock_guard<std::mutex> lock(matches_mutex);
+
+        std::vector<MatchSummary> match_history;
+        next_before = 0;
+        auto it = user_matches.find(username);
+        if (it == user_matches.end())
+        {
+            return match_history;
+        }
+
+        const std::vector<GameHandle> &handles = it->second;
+        size_t position = std::min(before, handles.size());
+        match_history.reserve(std::min(position, limit));
+        while (position > 0 && match_history.size() < limit)
+        {
+            --position;
+            const MatchModel &match = matches.at(handles[position]);
+            match_history.push_back({match.game_id, match.white_username, match.black_username, match.result, match.start_time});
+        }
+        next_before = position;
+        return match_history;
+    }
+
 private:
     std::unordered_map<std::string, UserModel> users; // mapping username -> User
     std::mutex users_mutex;
 
-    std::unordered_map<std::string, MatchModel> matches; // mapping game_id -> Match
+    std::unordered_map<GameHandle, MatchModel> matches;        // mapping handle -> Match
+    std::unordered_map<std::string, GameHandle> match_handles; // mapping game_id -> handle (chỉ dùng cho tra cứu theo chuỗi)
+    std::unordered_map<std::string, std::vector<GameHandle>> user_matches; // mapping username -> các trận theo thứ tự bắt đầu
     std::mutex matches_mutex;
 
     ~DataStorage() = default;
@@ -380,7 +443,23 @@ private:
         for (auto it = matches_j.begin(); it != matches_j.end(); ++it)
         {
             std::string game_id = it.key();
-            matches[game_id] = MatchModel::deserialize(game_id, it.value());
+            GameHandle handle = nextGameHandle();
+            match_handles[game_id] = handle;
+            matches[handle] = MatchModel::deserialize(game_id, it.value());
+
+            const MatchModel &match = matches[handle];
+            user_matches[match.white_username].push_back(handle);
+            if (match.black_username != match.white_username)
+            {
+                user_matches[match.black_username].push_back(handle);
+            }
+        }
+
+        // matches.json được sắp theo game_id; chỉ mục lịch sử cần theo thời gian bắt đầu
+        for (auto &[username, handles] : user_matches)
+        {
+            std::sort(handles.begin(), handles.end(), [this](GameHandle a, GameHandle b)
+                      { return matches[a].start_time < matches[b].start_time; });
         }
     }
 
@@ -399,9 +478,9 @@ private:
     bool saveMatchesData()
     {
         json j;
-        for (const auto &[game_id, match] : matches)
+        for (const auto &[handle, match] : matches)
         {
-            j[game_id] = match.serialize();
+            j[match.game_id] = match.serialize();
         }
         std::string dataPath = getDataPath();
         JSONHandler::writeJSON(dataPath + "matches.json", j);
@@ -0,0 +1,241 @@
+#ifndef EPOLL_REACTOR_HPP
+#define EPOLL_REACTOR_HPP
+
+#include <functional>
+#include <vector>
+#include <atomic>
+#include <iostream>
+#include <cstring>
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "../common/protocol.hpp"
+
+#include "network_server.hpp"
+
+/**
+ * @brief Vòng lặp sự kiện epoll (edge-triggered) quản lý toàn bộ kết nối của server.
+ *
+ * Một luồng duy nhất chạy run(): chấp nhận kết nối mới trên socket lắng nghe,
+ * đọc hết dữ liệu của mọi client đang sẵn sàng (socket non-blocking) và chuyển
+ * từng gói tin hoàn chỉnh cho callback xử lý. Số luồng không phụ thuộc vào số kết nối.
+ * Khi socket của client đầy, hàng đợi gửi được xả tiếp lúc nhận EPOLLOUT.
+ *
+ * Có thể chạy nhiều reactor song song: mỗi reactor có socket lắng nghe SO_REUSEPORT
+ * riêng (NetworkServer::openListener), tập epoll riêng và có thể được ghim vào một CPU.
+ * Kết nối thuộc về reactor đã accept nó trong suốt vòng đời.
+ */
+class EpollReactor
+{
+public:
+    // Gói tin được chuyển quyền sở hữu cho callback (có thể đưa thẳng vào hàng đợi worker)
+    using PacketCallback = std::function<void(int client_fd, Packet packet)>;
+    // Callback chịu trách nhiệm gọi NetworkServer::closeConnection (có thể sau đó, trên luồng khác)
+    using DisconnectCallback = std::function<void(int client_fd)>;
+
+    /**
+     * @param on_packet Hàm xử lý từng gói tin hoàn chỉnh.
+     * @param on_disconnect Hàm được gọi khi client ngắt kết nối.
+     * @param listen_fd Socket lắng nghe của reactor, -1 để dùng socket chính của server.
+     * @param cpu CPU để ghim luồng chạy run(), -1 nếu không ghim.
+     */
+    EpollReactor(PacketCallback on_packet, DisconnectCallback on_disconnect, int listen_fd = -1, int cpu = -1)
+        : epoll_fd(-1),
+          listen_fd(listen_fd),
+          cpu(cpu),
+          running(false),
+          on_packet(std::move(on_packet)),
+          on_disconnect(std::move(on_disconnect))
+    {
+    }
+
+    // Delete copy constructor and assignment operator
+    EpollReactor(const EpollReactor &) = delete;
+    EpollReactor &operator=(const EpollReactor &) = delete;
+
+    ~EpollReactor()
+    {
+        if (epoll_fd != -1)
+        {
+            close(epoll_fd);
+        }
+    }
+
+    /**
+     * @brief Chạy vòng lặp sự kiện trên luồng hiện tại cho đến khi stop() được gọi.
+     *
+     * @return false nếu không thể khởi tạo epoll, true khi vòng lặp kết thúc bình thường.
+     */
+    bool run()
+    {
+        NetworkServer &network_server = NetworkServer::getInstance();
+        if (listen_fd == -1)
+        {
+            listen_fd = network_server.getServerFD();
+        }
+
+        if (cpu >= 0)
+        {
+            pinToCpu(cpu);
+        }
+
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd == -1)
+        {
+            perror("epoll_create1 failed");
+            return false;
+        }
+
+        if (!setNonBlocking(listen_fd) || !addFd(listen_fd, EPOLLIN | EPOLLET))
+        {
+            return false;
+        }
+
+        running = true;
+        std::vector<epoll_event> events(MAX_EVENTS);
+
+        while (running)
+        {
+            int ready = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), WAIT_TIMEOUT_MS);
+            if (ready < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                perror("epoll_wait failed");
+                break;
+            }
+
+            // Mọi gói tin sinh ra trong lượt này được xả chung một lần writev cho mỗi client
+            NetworkServer::SendBatch batch;
+
+            for (int i = 0; i < ready; ++i)
+            {
+                int fd = events[i].data.fd;
+                uint32_t flags = events[i].events;
+
+                if (fd == listen_fd)
+                {
+                    acceptAll();
+                    continue;
+                }
+
+                if (flags & (EPOLLERR | EPOLLHUP))
+                {
+                    dropClient(fd);
+                    continue;
+                }
+
+                if (flags & EPOLLOUT)
+                {
+                    // Socket ghi được trở lại sau EAGAIN: gửi tiếp hàng đợi
+                    network_server.flushPending(fd);
+                }
+
+                if (flags & (EPOLLIN | EPOLLRDHUP))
+                {
+                    handleReadable(fd);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    void stop()
+    {
+        running = false;
+    }
+
+private:
+    static constexpr int MAX_EVENTS = 256;
+    static constexpr int WAIT_TIMEOUT_MS = 500;
+
+    int epoll_fd;
+    int listen_fd;
+    int cpu;
+    std::atomic<bool> running;
+
+    PacketCallback on_packet;
+    DisconnectCallback on_disconnect;
+
+    static bool setNonBlocking(int fd)
+    {
+        int flags = fcntl(fd, F_GETFL, 0);
+        if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1)
+        {
+            perror("fcntl O_NONBLOCK failed");
+            return false;
+        }
+        return true;
+    }
+
+    static void pinToCpu(int cpu)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (error != 0)
+        {
+            std::cerr << "Không thể ghim reactor vào CPU " << cpu << ": " << strerror(error) << std::endl;
+        }
+    }
+
+    bool addFd(int fd, uint32_t events)
+    {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1)
+        {
+            perror("epoll_ctl ADD failed");
+            return false;
+        }
+        return true;
+    }
+
+    // Edge-triggered: phải accept cho đến khi gặp EAGAIN
+    void acceptAll()
+    {
+        NetworkServer &network_server = NetworkServer::getInstance();
+        while (true)
+        {
+            int client_fd = network_server.acceptConnection(listen_fd, true);
+            if (client_fd == -1)
+                break;
+
+            // EPOLLOUT edge-triggered chỉ báo khi socket từ đầy chuyển sang ghi được
+            if (!addFd(client_fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET))
+            {
+                network_server.closeConnection(client_fd);
+            }
+        }
+    }
+
+    // Edge-triggered: đọc đến khi gặp EAGAIN, xử lý gói tin ngay sau mỗi lần đọc
+    void handleReadable(int client_fd)
+    {
+        bool alive = NetworkServer::getInstance().readFromClient(
+            client_fd,
+            [this, client_fd](const PacketView &view)
+            { on_packet(client_fd, view.toPacket()); });
+
+        if (!alive)
+        {
+            dropClient(client_fd);
+        }
+    }
+
+    // Gỡ fd khỏi epoll ngay để không nhận thêm sự kiện trong lúc chờ on_disconnect đóng kết nối
+    void dropClient(int client_fd)
+    {
+        std::cout << "Client " << client_fd << " ngắt kết nối." << std::endl;
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client_fd, nullptr);
+        on_disconnect(client_fd);
+    }
+};
+
+#endif // EPOLL_REACTOR_HPP
@@ -0,0 +1,28 @@
+#ifndef GAME_HANDLE_HPP
+#define GAME_HANDLE_HPP
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Định danh số 64 bit của một ván cờ.
+ *
+ * Handle là khóa của mọi map trong bộ nhớ (ván cờ, ván chờ, khán giả, trận đấu trong
+ * DataStorage) và được gửi thay cho chuỗi game_id ở giao thức v2. Chuỗi game_id dễ đọc
+ * chỉ còn là metadata được lưu vào matches.json và gửi cho client v1.
+ *
+ * Handle không được lưu xuống đĩa: các trận đấu đọc từ matches.json nhận handle mới
+ * mỗi lần server khởi động.
+ */
+using GameHandle = uint64_t;
+
+const GameHandle INVALID_GAME_HANDLE = 0;
+
+// Cấp handle mới, không khóa; an toàn khi gọi từ nhiều luồng
+inline GameHandle nextGameHandle()
+{
+    static std::atomic<GameHandle> counter{1};
+    return counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+#endif // GAME_HANDLE_HPP
@@ -3,11 +3,12 @@
 
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <mutex>
 #include <memory>
-#include <queue>
 #include <condition_variable>
 #include <thread>
+#include <atomic>
 
 #include "../chess_engine/chess.hpp"
 #include "../common/const.hpp"
@@ -15,7 +16,10 @@
 #include "../chess_engine/chess_bot.hpp"
 
 #include "data_storage.hpp"
+#include "game_handle.hpp"
+#include "matchmaking_pool.hpp"
 #include "network_server.hpp"
+#include "worker_pool.hpp"
 
 /**
  * @class Game
@@ -24,15 +28,20 @@
  * Lớp này bao gồm các thông tin về người chơi, trạng thái bàn cờ,
  * lượt chơi hiện tại, và các phương thức để thực hiện nước đi,
  * kiểm tra trạng thái kết thúc của trò chơi, và các thông tin liên quan khác.
+ *
+ * Ván cờ không có khóa riêng: mọi thao tác đọc/ghi bàn cờ và lượt chơi chạy trên strand của
+ * ván (GameManager::runOnGame). Tên người chơi, game_id và handle không đổi sau khi tạo.
  */
 class Game
 {
 public:
-    std::string game_id;
+    std::string game_id;                     // Chuỗi dễ đọc, chỉ để lưu trữ và gửi cho client v1
+    GameHandle handle = INVALID_GAME_HANDLE; // Khóa của ván cờ trong mọi map và trên giao thức v2
     std::string player_white_name;
     std::string player_black_name;
     std::string current_turn;
     bool is_game_with_bot = false;
+    std::shared_ptr<WorkerPool::Strand> strand; // Hộp thư tuần tự của ván
 
     std::string winner;
 
@@ -51,13 +60,20 @@ public:
         current_turn = isWhiteTurn ? player_white_name : player_black_name;
     }
 
-    bool makeMove(const std::string &uci_move)
+    bool makeMove(std::string_view uci_move)
+    {
+        // Nước đi UCI tối đa 5 ký tự nên chuỗi tạm nằm gọn trong bộ đệm SSO, không cấp phát
+        return makeMove(chess::uci::uciToMove(board, std::string(uci_move)));
+    }
+
+    // Nước đi đã mã hóa 16 bit: chỉ so với danh sách nước đi hợp lệ, không phân tích chuỗi
+    bool makeMove(chess::Move move)
     {
-        chess::Move move = chess::uci::uciToMove(board, uci_move);
         if (!isValidMove(board, move))
             return false;
 
         board.makeMove(move);
+        last_move = move;
         half_moves_count++;
 
         // Kiểm tra kết quả trò chơi
@@ -98,6 +114,12 @@ public:
         return is_over;
     }
 
+    // Kết thúc ván ngoài bàn cờ (đầu hàng, ngắt kết nối): các nước đi còn trong hộp thư bị từ chối
+    void markOver()
+    {
+        is_over = true;
+    }
+
     std::string getFen()
     {
         return board.getFen();
@@ -140,6 +162,33 @@ public:
         return half_moves_count;
     }
 
+    // Số nửa nước đã đi tính từ FEN, client tính được giống hệt từ FEN nó đang giữ
+    uint32_t getPly() const
+    {
+        return (board.fullMoveNumber() - 1) * 2 + (board.sideToMove() == chess::Color::BLACK ? 1 : 0);
+    }
+
+    chess::Move getLastMove() const
+    {
+        return last_move;
+    }
+
+    chess::PackedBoard getPackedBoard() const
+    {
+        return chess::Board::Compact::encode(board);
+    }
+
+    // Cờ trạng thái dùng chung cho GameMoveDeltaMessage và GameKeyframeMessage
+    uint8_t getUpdateFlags()
+    {
+        uint8_t flags = 0;
+        if (isInCheck())
+            flags |= GameMoveDeltaMessage::CHECK;
+        if (is_over)
+            flags |= GameMoveDeltaMessage::GAME_OVER;
+        return flags;
+    }
+
 private:
     bool is_over;
 
@@ -147,6 +196,7 @@ private:
     chess::GameResult result = chess::GameResult::NONE;
     chess::GameResultReason reason = chess::GameResultReason::NONE;
     int half_moves_count = 0;
+    chess::Move last_move = chess::Move::NO_MOVE;
 
     bool isValidMove(const chess::Board &board, const chess::Move &move)
     {
@@ -173,7 +223,7 @@ private:
 
 struct PendingGame
 {
-    std::string game_id;
+    std::shared_ptr<Game> game;
     int player1_fd;
     int player2_fd;
     bool player1_accepted;
@@ -181,12 +231,12 @@ struct PendingGame
 
     // Default constructor
     PendingGame()
-        : game_id(""), player1_fd(-1), player2_fd(-1),
+        : game(nullptr), player1_fd(-1), player2_fd(-1),
           player1_accepted(false), player2_accepted(false) {}
 
     // Parameterized constructor
-    PendingGame(const std::string &id, int fd1, int fd2)
-        : game_id(id), player1_fd(fd1), player2_fd(fd2),
+    PendingGame(const std::shared_ptr<Game> &game, int fd1, int fd2)
+        : game(game), player1_fd(fd1), player2_fd(fd2),
           player1_accepted(false), player2_accepted(false) {}
 };
 
@@ -214,136 +264,212 @@ struct PendingGame
 class GameManager
 {
 private:
-    std::unordered_map<std::string, std::shared_ptr<Game>> games;
-    std::unordered_map<std::string, PendingGame> pending_games;
+    std::unordered_map<GameHandle, std::shared_ptr<Game>> games;
+    std::unordered_map<std::string, GameHandle> game_handles; // game_id -> handle, chỉ cho thông điệp v1
+    std::unordered_map<std::string, GameHandle> user_games;   // username -> ván đang chơi, cập nhật cùng games
+    std::unordered_map<GameHandle, PendingGame> pending_games;
     std::mutex games_mutex;
 
-    // game_id -> vector of spectator client_fds
-    std::unordered_map<std::string, std::vector<int>> game_spectators;
+    // handle -> vector of spectator client_fds
+    std::unordered_map<GameHandle, std::vector<int>> game_spectators;
 
-    std::queue<int> matchmaking_queue; // Queue of client_fds
+    MatchmakingPool matchmaking_pool; // client_fd đang chờ ghép trận, sắp theo ELO
     std::condition_variable cv;
     bool stop_matching;
     std::thread matchmaking_thread;
 
     std::mutex matchmaking_mutex;
 
-    // Private constructor for Singleton
-    GameManager() : stop_matching(false), matchmaking_thread(&GameManager::matchmakingLoop, this) {}
+    // Pool chạy strand của các ván; nullptr thì công việc của ván chạy ngay trên luồng gọi
+    std::atomic<WorkerPool *> worker_pool{nullptr};
 
     /**
-     * @brief Vòng lặp quản lý tìm kiếm trận đấu.
-     *
-     * Hàm này liên tục kiểm tra hàng đợi tìm kiếm để ghép cặp người chơi.
-     *
-     * - Chờ đợi đến khi có ít nhất 2 người chơi trong hàng đợi hoặc khi nhận được tín hiệu dừng.
-     *
-     * - Nếu nhận được tín hiệu dừng, dừng vòng lặp.
+     * @brief Khóa tra cứu map từ std::string_view mà không cấp phát.
      *
-     * - Khi có đủ hai người chơi, lấy hai người từ hàng đợi và kiểm tra sự khác biệt ELO.
-     *
-     *   - 1. Nếu sự khác biệt ELO nhỏ hơn hoặc bằng ngưỡng cho phép, tạo trận đấu mới và gửi thông báo cho cả hai người chơi.
-     *
-     *   - 2. Nếu không, đưa lại hai người chơi vào hàng đợi.
+     * C++17 chưa có tra cứu dị kiểu cho unordered_map, nên chuỗi được chép vào một buffer
+     * của luồng hiện tại; sau vài lần đầu buffer đủ lớn và không cần cấp phát lại.
+     * Kết quả chỉ hợp lệ đến lần gọi tiếp theo trên cùng luồng.
+     */
+    static const std::string &lookupKey(std::string_view key)
+    {
+        static thread_local std::string buffer;
+        buffer.assign(key.data(), key.size());
+        return buffer;
+    }
+
+    // Chuỗi game_id dễ đọc (chỉ để lưu trữ), dựng từ tên người chơi và thời điểm tạo
+    static std::string makeGameId(const std::string &players)
+    {
+        using namespace std::chrono;
+        auto now = system_clock::now();
+        auto ms = duration_cast<milliseconds>(now.time_since_epoch()) % 1000;
+        auto in_time_t = system_clock::to_time_t(now);
+        std::tm tm;
+        localtime_r(&in_time_t, &tm);
+        std::ostringstream oss;
+        char buffer[30];
+        std::strftime(buffer, sizeof(buffer), "%Y%m%d%H%M%S", &tm);
+        oss << "game_" << players << "_" << buffer << "_" << ms.count();
+        return oss.str();
+    }
+
+    // Những người chơi thật của ván (bỏ qua "bot" trong ván với máy)
+    template <typename Fn>
+    static void forEachPlayer(const Game &game, Fn &&fn)
+    {
+        for (const std::string *username : {&game.player_white_name, &game.player_black_name})
+        {
+            if (!(game.is_game_with_bot && *username == "bot"))
+                fn(*username);
+        }
+    }
+
+    void addGame(const std::shared_ptr<Game> &game)
+    {
+        game->strand = std::make_shared<WorkerPool::Strand>(worker_pool.load(), game->handle);
+
+        std::lock_guard<std::mutex> lock(games_mutex);
+        games[game->handle] = game;
+        game_handles[game->game_id] = game->handle;
+        forEachPlayer(*game, [&](const std::string &username)
+                      { user_games[username] = game->handle; });
+    }
+
+    // Ván đang chơi của người dùng; games_mutex phải được giữ
+    std::shared_ptr<Game> findUserGameLocked(std::string_view username)
+    {
+        auto it = user_games.find(lookupKey(username));
+        if (it == user_games.end())
+            return nullptr;
+
+        auto game = games.find(it->second);
+        return game != games.end() ? game->second : nullptr;
+    }
+
+    // Private constructor for Singleton
+    GameManager() : matchmaking_pool(Const::ELO_THRESHOLD, Const::ELO_THRESHOLD_MAX, Const::ELO_WINDOW_GROWTH),
+                    stop_matching(false),
+                    matchmaking_thread(&GameManager::matchmakingLoop, this) {}
+
+    /**
+     * @brief Luồng nới cửa sổ ELO của những người đang chờ.
      *
-     * - Sleep 1 giây trước khi lặp lại vòng lặp.
+     * Người chơi mới được ghép ngay trong addPlayerToQueue(). Luồng này chỉ thức dậy khi một cặp
+     * đang chờ vừa đủ điều kiện nhờ cửa sổ nới rộng (MatchmakingPool::nextCheck()), khi thời điểm
+     * đó thay đổi, hoặc khi nhận tín hiệu dừng; không ngủ theo chu kỳ cố định.
      *
-     * @note Hàm này chạy trong một luồng riêng và sử dụng mutex cùng điều kiện biến để quản lý truy cập vào hàng đợi tìm kiếm.
+     * @note Các ván được tạo sau khi đã nhả matchmaking_mutex.
      */
     void matchmakingLoop()
     {
-        int count = 0;
         while (true)
         {
-            std::unique_lock<std::mutex> lock(matchmaking_mutex);
-            cv.wait(lock, [this]
-                    { return matchmaking_queue.size() >= 2 || stop_matching; });
-
-            if (count % 10 == 0)
+            std::vector<MatchmakingPool::Match> matches;
             {
-                std::cout << "\nMatchmaking loop " << count++
-                          << ", queue size: " << matchmaking_queue.size() << std::endl;
-            }
+                std::unique_lock<std::mutex> lock(matchmaking_mutex);
 
-            if (stop_matching)
-            {
-                std::cout << "Stopping matchmaking loop." << std::endl;
-                break;
+                // Chờ lại sau mỗi lần được báo: nextCheck() có thể đã đổi
+                while (!stop_matching && MatchmakingPool::Clock::now() < matchmaking_pool.nextCheck())
+                {
+                    if (matchmaking_pool.nextCheck() == MatchmakingPool::Clock::time_point::max())
+                        cv.wait(lock);
+                    else
+                        cv.wait_until(lock, matchmaking_pool.nextCheck());
+                }
+
+                if (stop_matching)
+                {
+                    std::cout << "Stopping matchmaking loop." << std::endl;
+                    break;
+                }
+
+                matches = matchmaking_pool.matchWaiting(MatchmakingPool::Clock::now());
             }
 
-            if (matchmaking_queue.size() >= 2)
+            for (const MatchmakingPool::Match &match : matches)
             {
-                int client1_fd = matchmaking_queue.front();
-                matchmaking_queue.pop();
-                int client2_fd = matchmaking_queue.front();
-                matchmaking_queue.pop();
+                startAutoMatch(match);
+            }
+        }
+    }
 
-                NetworkServer &network_server = NetworkServer::getInstance();
-                DataStorage &data_storage = DataStorage::getInstance();
+    /**
+     * @brief Tạo ván chờ xác nhận cho một cặp vừa ghép và gửi AutoMatchFound cho cả hai.
+     *
+     * Người chơi fd1 (chờ lâu hơn) cầm quân trắng.
+     */
+    void startAutoMatch(const MatchmakingPool::Match &match)
+    {
+        NetworkServer &network_server = NetworkServer::getInstance();
 
-                // Retrieve usernames and ELOs
-                std::string username1 = network_server.getUsername(client1_fd);
-                std::string username2 = network_server.getUsername(client2_fd);
+        // Retrieve usernames
+        std::string username1 = network_server.getUsername(match.fd1);
+        std::string username2 = network_server.getUsername(match.fd2);
 
-                uint16_t elo1 = data_storage.getUserELO(username1);
-                uint16_t elo2 = data_storage.getUserELO(username2);
+        std::cout << "[MATCHMAKING] " << username1 << " (" << match.elo1 << ") vs "
+                  << username2 << " (" << match.elo2 << ")" << std::endl;
 
-                if (abs(static_cast<int>(elo1) - static_cast<int>(elo2)) <= Const::ELO_THRESHOLD)
-                {
-                    // Create new game
-                    std::string game_id = createGame(username1, username2);
-
-                    // Add to pending_games
-                    pending_games[game_id] = PendingGame(game_id, client1_fd, client2_fd);
-
-                    // Send AutoMatchFoundMessage to both clients
-                    AutoMatchFoundMessage auto_match_found_msg_1;
-                    auto_match_found_msg_1.opponent_username = username2;
-                    auto_match_found_msg_1.opponent_elo = elo2;
-                    auto_match_found_msg_1.game_id = game_id;
-                    std::vector<uint8_t> serialized_1 = auto_match_found_msg_1.serialize();
-                    network_server.sendPacket(client1_fd, MessageType::AUTO_MATCH_FOUND, serialized_1);
-
-                    AutoMatchFoundMessage auto_match_found_msg_2;
-                    auto_match_found_msg_2.opponent_username = username1;
-                    auto_match_found_msg_2.opponent_elo = elo1;
-                    auto_match_found_msg_2.game_id = game_id;
-                    std::vector<uint8_t> serialized_2 = auto_match_found_msg_2.serialize();
-                    network_server.sendPacket(client2_fd, MessageType::AUTO_MATCH_FOUND, serialized_2);
-                }
-                else
-                {
-                    // ELO difference too high, re-add to queue
-                    matchmaking_queue.push(client1_fd);
-                    matchmaking_queue.push(client2_fd);
-                }
-            }
+        // Create new game
+        std::shared_ptr<Game> game = createGame(username1, username2);
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        // Add to pending_games
+        {
+            std::lock_guard<std::mutex> games_lock(games_mutex);
+            pending_games[game->handle] = PendingGame(game, match.fd1, match.fd2);
         }
+
+        // Send AutoMatchFoundMessage to both clients
+        AutoMatchFoundMessage auto_match_found_msg_1;
+        auto_match_found_msg_1.opponent_username = username2;
+        auto_match_found_msg_1.opponent_elo = match.elo2;
+        auto_match_found_msg_1.game_id = game->game_id;
+        auto_match_found_msg_1.game_handle = game->handle;
+        network_server.sendMessage(match.fd1, auto_match_found_msg_1);
+
+        AutoMatchFoundMessage auto_match_found_msg_2;
+        auto_match_found_msg_2.opponent_username = username1;
+        auto_match_found_msg_2.opponent_elo = match.elo1;
+        auto_match_found_msg_2.game_id = game->game_id;
+        auto_match_found_msg_2.game_handle = game->handle;
+        network_server.sendMessage(match.fd2, auto_match_found_msg_2);
     }
 
-    bool makeMove(const std::string &game_id, const std::string &uci_move)
+    /**
+     * @brief Chạy fn(game) trên strand của ván.
+     *
+     * Công việc của cùng một ván chạy tuần tự theo thứ tự gửi, không cần games_mutex; các ván
+     * khác nhau chạy song song. Gói tin gửi trong fn được gộp như một lượt xử lý của worker và
+     * câu trả lời cho client_fd mang request ID của gói tin đang xử lý trên luồng gọi.
+     */
+    template <typename Fn>
+    void runOnGame(const std::shared_ptr<Game> &game, int client_fd, Fn &&fn)
     {
-        auto game = getGame(game_id);
-        if (game && !game->isGameOver())
-            return game->makeMove(uci_move);
-        return false;
+        uint32_t request_id = NetworkServer::currentRequestId(client_fd);
+        game->strand->post([game, client_fd, request_id, fn = std::forward<Fn>(fn)]() mutable
+                           {
+            NetworkServer::SendBatch batch;
+            NetworkServer::RequestScope request(client_fd, request_id);
+            fn(game); });
+    }
+
+    void sendInvalidMove(int client_fd, const std::string &game_id, GameHandle game_handle, const std::string &error_message)
+    {
+        InvalidMoveMessage invalid_move_msg;
+        invalid_move_msg.game_id = game_id;
+        invalid_move_msg.game_handle = game_handle;
+        invalid_move_msg.error_message = error_message;
+        NetworkServer::getInstance().sendMessage(client_fd, invalid_move_msg);
     }
 
+    // fd -> username qua chỉ mục của NetworkServer, rồi username -> ván qua user_games
     std::shared_ptr<Game> getGameByClientFd(int client_fd)
     {
         std::string username = NetworkServer::getInstance().getUsername(client_fd);
+        if (username.empty())
+            return nullptr;
 
-        for (const auto &game_pair : games)
-        {
-            std::shared_ptr<Game> game = game_pair.second;
-            if (game->player_white_name == username || game->player_black_name == username)
-            {
-                return game;
-            }
-        }
-        return nullptr;
+        std::lock_guard<std::mutex> lock(games_mutex);
+        return findUserGameLocked(username);
     }
 
 public:
@@ -357,76 +483,81 @@ public:
         return instance;
     }
 
+    // Gọi một lần lúc khởi động, trước khi có ván cờ nào được tạo
+    void setWorkerPool(WorkerPool *pool)
+    {
+        worker_pool = pool;
+    }
+
     /**
      * Tạo trận đấu mới với tên người chơi trắng và đen, và chuỗi FEN ban đầu.
      *
+     * Handle được cấp không khóa và chuỗi game_id được dựng trước khi lấy games_mutex;
+     * khóa chỉ giữ trong lúc thêm ván cờ vào các map.
+     *
      * @param player_white_name Tên người chơi trắng.
      * @param player_black_name Tên người chơi đen.
      * @param initial_fen State ban đầu của ván cờ (mặc định: STARTPOS).
-     * @return Mã định danh của trận đấu được tạo.
+     * @return Ván cờ vừa tạo (handle và game_id nằm trong đối tượng).
      */
-    std::string createGame(const std::string &player_white_name, const std::string &player_black_name, const std::string &initial_fen = chess::constants::STARTPOS)
+    std::shared_ptr<Game> createGame(const std::string &player_white_name, const std::string &player_black_name, const std::string &initial_fen = chess::constants::STARTPOS)
     {
-        std::lock_guard<std::mutex> lock(games_mutex);
+        std::string game_id = makeGameId(player_white_name + "_" + player_black_name);
 
-        // Generate game_id based on player names and current time with higher precision
-        using namespace std::chrono;
-        auto now = system_clock::now();
-        auto ms = duration_cast<milliseconds>(now.time_since_epoch()) % 1000;
-        auto in_time_t = system_clock::to_time_t(now);
-        std::tm tm = *std::localtime(&in_time_t);
-        std::ostringstream oss;
-        char buffer[30];
-        std::strftime(buffer, sizeof(buffer), "%Y%m%d%H%M%S", &tm);
-        oss << "game_" << player_white_name << "_" << player_black_name << "_" << buffer << "_" << ms.count();
-        std::string game_id = oss.str();
-
-        games[game_id] = std::make_shared<Game>(game_id, player_white_name, player_black_name, initial_fen);
+        auto game = std::make_shared<Game>(game_id, player_white_name, player_black_name, initial_fen);
+        game->handle = nextGameHandle();
+        addGame(game);
 
         DataStorage &datastorage = DataStorage::getInstance();
-        datastorage.registerMatch(game_id, player_white_name, player_black_name, initial_fen);
+        datastorage.registerMatch(game->handle, game_id, player_white_name, player_black_name, initial_fen);
         datastorage.addMatchToUserHistory(player_white_name, game_id);
         datastorage.addMatchToUserHistory(player_black_name, game_id);
-        return game_id;
+        return game;
     }
 
-    std::string createGameWithBot(const std::string &player_name, const std::string &initial_fen = chess::constants::STARTPOS)
+    std::shared_ptr<Game> createGameWithBot(const std::string &player_name, const std::string &initial_fen = chess::constants::STARTPOS)
     {
-        std::lock_guard<std::mutex> lock(games_mutex);
+        std::string game_id = makeGameId(player_name + "_bot");
 
-        // Generate game_id based on player name and current time with higher precision
-        using namespace std::chrono;
-        auto now = system_clock::now();
-        auto ms = duration_cast<milliseconds>(now.time_since_epoch()) % 1000;
-        auto in_time_t = system_clock::to_time_t(now);
-        std::tm tm = *std::localtime(&in_time_t);
-        std::ostringstream oss;
-        char buffer[30];
-        std::strftime(buffer, sizeof(buffer), "%Y%m%d%H%M%S", &tm);
-        oss << "game_" << player_name << "_bot_" << buffer << "_" << ms.count();
-        std::string game_id = oss.str();
-
-        Game *game = new Game(game_id, player_name, "bot", initial_fen);
+        auto game = std::make_shared<Game>(game_id, player_name, "bot", initial_fen);
         game->is_game_with_bot = true;
-
-        games[game_id] = std::shared_ptr<Game>(game);
+        game->handle = nextGameHandle();
+        addGame(game);
 
         DataStorage &datastorage = DataStorage::getInstance();
-        datastorage.registerMatch(game_id, player_name, "bot", initial_fen);
+        datastorage.registerMatch(game->handle, game_id, player_name, "bot", initial_fen);
         datastorage.addMatchToUserHistory(player_name, game_id);
-        return game_id;
+        return game;
     }
 
-    std::shared_ptr<Game> getGame(const std::string &game_id)
+    std::shared_ptr<Game> getGame(GameHandle handle)
     {
         std::lock_guard<std::mutex> lock(games_mutex);
 
-        auto it = games.find(game_id);
+        auto it = games.find(handle);
         if (it != games.end())
             return it->second;
         return nullptr;
     }
 
+    /**
+     * @brief Đổi định danh ván cờ trong thông điệp về handle.
+     *
+     * Client v2 gửi handle; client v1 gửi chuỗi game_id và được tra qua game_handles.
+     *
+     * @return Handle của ván cờ, INVALID_GAME_HANDLE nếu không tìm thấy.
+     */
+    GameHandle resolveHandle(std::string_view game_id, GameHandle game_handle)
+    {
+        if (game_handle != INVALID_GAME_HANDLE)
+            return game_handle;
+
+        std::lock_guard<std::mutex> lock(games_mutex);
+
+        auto it = game_handles.find(lookupKey(game_id));
+        return it != game_handles.end() ? it->second : INVALID_GAME_HANDLE;
+    }
+
     std::vector<std::shared_ptr<Game>> getAllGames()
     {
         std::lock_guard<std::mutex> lock(games_mutex);
@@ -438,11 +569,24 @@ public:
         return allGames;
     }
 
-    bool removeGame(const std::string &id)
+    bool removeGame(GameHandle handle)
     {
         std::lock_guard<std::mutex> lock(games_mutex);
 
-        return games.erase(id) > 0;
+        auto it = games.find(handle);
+        if (it == games.end())
+            return false;
+
+        // Chỉ xóa chỉ mục nếu nó còn trỏ về ván này (người chơi có thể đã sang ván mới)
+        forEachPlayer(*it->second, [&](const std::string &username)
+                      {
+            auto user_it = user_games.find(username);
+            if (user_it != user_games.end() && user_it->second == handle)
+                user_games.erase(user_it); });
+
+        game_handles.erase(it->second->game_id);
+        games.erase(it);
+        return true;
     }
 
     /**
@@ -458,56 +602,102 @@ public:
      *
      *  - Nếu chơi với bot, xử lý nước đi của bot.
      *
+     * game_id và uci_move có thể trỏ thẳng vào buffer nhận: chúng được dùng để tìm ván (một lần
+     * lấy games_mutex) rồi nước đi được chép sang strand của ván, nơi nó được kiểm tra và áp dụng.
+     *
      * @param client_fd ID kết nối của khách hàng.
-     * @param game_id ID của trò chơi.
+     * @param game_id_view ID của trò chơi (client v1).
+     * @param game_handle Handle của trò chơi (client v2).
      * @param uci_move Nước đi theo định dạng UCI.
      */
-    void handleMove(int client_fd, const std::string &game_id, const std::string &uci_move)
+    void handleMove(int client_fd, std::string_view game_id_view, GameHandle game_handle, std::string_view uci_move)
     {
-        if (makeMove(game_id, uci_move))
+        std::shared_ptr<Game> game = getGame(resolveHandle(game_id_view, game_handle));
+        if (!game)
         {
-            // Retrieve game information
-            std::shared_ptr<Game> game = getGame(game_id);
-            std::string player_white_name = game->player_white_name;
-            std::string player_black_name = game->player_black_name;
-            bool is_game_with_bot = game->is_game_with_bot;
+            sendInvalidMove(client_fd, std::string(game_id_view), game_handle, "Invalid move: " + std::string(uci_move));
+            return;
+        }
 
-            // Save the player's move to the database
-            DataStorage &data_storage = DataStorage::getInstance();
-            data_storage.addMove(game_id, uci_move, getGameFen(game_id));
+        runOnGame(game, client_fd, [this, client_fd, game_handle, move = std::string(uci_move)](const std::shared_ptr<Game> &game)
+                  {
+            if (!game->isGameOver() && game->makeMove(move))
+                afterPlayerMove(game, move);
+            else
+                sendInvalidMove(client_fd, game->game_id, game_handle, "Invalid move: " + move); });
+    }
 
-            // Notify players and spectators about the move
-            notifyPlayersAndSpectators(game_id, game);
+    /**
+     * @brief Xử lý nước đi nhị phân (MoveV2Message).
+     *
+     * Ván cờ được tra theo handle; người gửi phải là người đang đến lượt, ply phải bằng ply
+     * hiện tại của ván (loại nước đi cũ hoặc gửi lặp), và nước đi 16 bit được so trực tiếp
+     * với danh sách nước đi hợp lệ.
+     * Chuỗi UCI chỉ được tạo sau khi nước đi đã hợp lệ, để lưu vào lịch sử trận đấu.
+     *
+     * @param client_fd ID kết nối của khách hàng.
+     * @param message Nước đi đã giải mã.
+     */
+    void handleMoveV2(int client_fd, const MoveV2Message &message)
+    {
+        std::shared_ptr<Game> game = getGame(message.game_handle);
+        chess::Move move(message.move);
+        if (!game)
+        {
+            sendInvalidMove(client_fd, "", message.game_handle, "Invalid move: " + chess::uci::moveToUci(move));
+            return;
+        }
 
-            // Check if the game is over
-            bool is_game_over = isGameOver(game_id);
+        runOnGame(game, client_fd, [this, client_fd, message, move](const std::shared_ptr<Game> &game)
+                  {
+            // Đọc lượt đi trên strand: chỉ người chơi đang đến lượt mới được đi
+            if (NetworkServer::getInstance().getUsername(client_fd) != game->current_turn)
+                sendInvalidMove(client_fd, game->game_id, message.game_handle, "Not your turn");
+            else if (!game->isGameOver() && message.ply == game->getPly() && game->makeMove(move))
+                afterPlayerMove(game, chess::uci::moveToUci(move));
+            else if (message.ply != game->getPly())
+                sendInvalidMove(client_fd, game->game_id, message.game_handle,
+                                "Stale move: expected ply " + std::to_string(game->getPly()) +
+                                    ", got " + std::to_string(message.ply));
+            else
+                sendInvalidMove(client_fd, game->game_id, message.game_handle,
+                                "Invalid move: " + chess::uci::moveToUci(move)); });
+    }
 
-            if (is_game_over)
-            {
-                endGame(game_id, game);
-                return;
-            }
+    /**
+     * @brief Phần chung sau khi nước đi của người chơi đã được áp dụng.
+     *
+     * Lưu nước đi, thông báo cho người chơi và khán giả, kết thúc ván nếu cần
+     * và cho bot đi tiếp nếu đến lượt bot. Chạy trên strand của ván nên đọc thẳng từ game.
+     */
+    void afterPlayerMove(const std::shared_ptr<Game> &game, const std::string &uci_move)
+    {
+        // Retrieve game information
+        GameHandle handle = game->handle;
+        bool is_game_with_bot = game->is_game_with_bot;
 
-            // If the game is against a bot and it's bot's turn, handle bot's move
-            if (is_game_with_bot && getGameCurrentTurn(game_id) == "bot")
-            {
-                handleBotMove(game_id, game);
-            }
+        // Save the player's move to the database
+        DataStorage &data_storage = DataStorage::getInstance();
+        data_storage.addMove(handle, uci_move, game->getFen());
+
+        // Notify players and spectators about the move
+        notifyPlayersAndSpectators(handle, game);
+
+        // Check if the game is over
+        if (game->isGameOver())
+        {
+            endGame(handle, game);
+            return;
         }
-        else
+
+        // If the game is against a bot and it's bot's turn, handle bot's move
+        if (is_game_with_bot && game->current_turn == "bot")
         {
-            // Invalid move
-            NetworkServer &network_server = NetworkServer::getInstance();
-            InvalidMoveMessage invalid_move_msg;
-            invalid_move_msg.game_id = game_id;
-            invalid_move_msg.error_message = "Invalid move: " + uci_move;
-
-            std::vector<uint8_t> serialized = invalid_move_msg.serialize();
-            network_server.sendPacket(client_fd, MessageType::INVALID_MOVE, serialized);
+            handleBotMove(handle, game);
         }
     }
 
-    void notifyPlayersAndSpectators(const std::string &game_id, const std::shared_ptr<Game> &game)
+    void notifyPlayersAndSpectators(GameHandle handle, const std::shared_ptr<Game> &game)
     {
         std::string player_white_name = game->player_white_name;
         std::string player_black_name = game->player_black_name;
@@ -519,10 +709,11 @@ public:
 
         // Prepare GameStatusUpdateMessage
         GameStatusUpdateMessage game_status_update_msg;
-        game_status_update_msg.game_id = game_id;
-        game_status_update_msg.fen = getGameFen(game_id);
-        game_status_update_msg.current_turn_username = getGameCurrentTurn(game_id);
-        game_status_update_msg.is_game_over = isGameOver(game_id);
+        game_status_update_msg.game_id = game->game_id;
+        game_status_update_msg.game_handle = handle;
+        game_status_update_msg.fen = game->getFen();
+        game_status_update_msg.current_turn_username = game->current_turn;
+        game_status_update_msg.is_game_over = game->isGameOver();
 
         if (game->isInCheck())
         {
@@ -533,24 +724,39 @@ public:
             game_status_update_msg.message = "";
         }
 
-        if (!is_game_with_bot)
+        // Serialize once and send the update to both players (only the non-bot player in bot games).
+        // v1 players get the full status, v2 players only the move (or a keyframe every N plies)
+        std::vector<int> player_fds;
+        std::vector<int> delta_fds;
+        for (const std::string &player_name : {player_white_name, player_black_name})
         {
-            // Serialize and send the update to both players
-            std::vector<uint8_t> serialized = game_status_update_msg.serialize();
-            network_server.sendPacketToUsername(player_white_name, MessageType::GAME_STATUS_UPDATE, serialized);
-            network_server.sendPacketToUsername(player_black_name, MessageType::GAME_STATUS_UPDATE, serialized);
+            if (is_game_with_bot && player_name == "bot")
+                continue;
+            int player_fd = network_server.getClientFD(player_name);
+            if (player_fd == -1)
+                continue;
+            if (network_server.getProtocolVersion(player_fd) >= Protocol::V2)
+                delta_fds.push_back(player_fd);
+            else
+                player_fds.push_back(player_fd);
         }
-        else
+        network_server.broadcastMessage(player_fds, game_status_update_msg);
+
+        if (!delta_fds.empty())
         {
-            // Serialize and send the update only to the non-bot player
-            std::vector<uint8_t> serialized = game_status_update_msg.serialize();
-            if (player_white_name != "bot")
+            uint32_t ply = game->getPly();
+            if (ply % Const::KEYFRAME_INTERVAL == 0)
             {
-                network_server.sendPacketToUsername(player_white_name, MessageType::GAME_STATUS_UPDATE, serialized);
+                network_server.broadcastMessage(delta_fds, makeKeyframe(game));
             }
-            if (player_black_name != "bot")
+            else
             {
-                network_server.sendPacketToUsername(player_black_name, MessageType::GAME_STATUS_UPDATE, serialized);
+                GameMoveDeltaMessage delta_msg;
+                delta_msg.game_handle = game->handle;
+                delta_msg.ply = ply;
+                delta_msg.move = game->getLastMove().move();
+                delta_msg.flags = game->getUpdateFlags();
+                network_server.broadcastMessage(delta_fds, delta_msg);
             }
         }
 
@@ -560,20 +766,51 @@ public:
         spectate_move_msg.current_turn_username = game_status_update_msg.current_turn_username;
         spectate_move_msg.is_white = (game_status_update_msg.current_turn_username == player_white_name);
 
-        // Send the update to all spectators
-        for (int spectator_fd : game_spectators[game_id])
-        {
-            network_server.sendPacket(spectator_fd, spectate_move_msg.getType(), spectate_move_msg.serialize());
-        }
+        // Send the update to all spectators: one frame shared by every spectator queue
+        network_server.broadcastMessage(getSpectators(handle), spectate_move_msg);
     }
 
-    void handleBotMove(const std::string &game_id, const std::shared_ptr<Game> &game)
+    GameKeyframeMessage makeKeyframe(const std::shared_ptr<Game> &game)
+    {
+        GameKeyframeMessage keyframe_msg;
+        keyframe_msg.game_handle = game->handle;
+        keyframe_msg.ply = game->getPly();
+        keyframe_msg.flags = game->getUpdateFlags();
+        keyframe_msg.board = game->getPackedBoard();
+        return keyframe_msg;
+    }
+
+    /**
+     * @brief Gửi keyframe cho người chơi xin đồng bộ lại bàn cờ.
+     *
+     * Chỉ hai người chơi của ván mới được nhận keyframe; yêu cầu cho ván không tồn tại bị bỏ qua.
+     *
+     * @param client_fd ID kết nối của khách hàng.
+     * @param game_handle Handle của ván cờ.
+     */
+    void handleResyncRequest(int client_fd, uint64_t game_handle)
+    {
+        std::shared_ptr<Game> game = getGame(game_handle);
+        if (!game)
+            return;
+
+        NetworkServer &network_server = NetworkServer::getInstance();
+        std::string username = network_server.getUsername(client_fd);
+        if (username != game->player_white_name && username != game->player_black_name)
+            return;
+
+        // Bàn cờ chỉ được đọc trên strand, sau mọi nước đi đã xếp trước yêu cầu này
+        runOnGame(game, client_fd, [this, client_fd](const std::shared_ptr<Game> &game)
+                  { NetworkServer::getInstance().sendMessage(client_fd, makeKeyframe(game)); });
+    }
+
+    void handleBotMove(GameHandle handle, const std::shared_ptr<Game> &game)
     {
         DataStorage &data_storage = DataStorage::getInstance();
         NetworkServer &network_server = NetworkServer::getInstance();
 
         // Get current FEN and determine bot's color
-        std::string current_fen = getGameFen(game_id);
+        std::string current_fen = game->getFen();
         chess::Color aiColor = (game->player_white_name == "bot") ? chess::Color::WHITE : chess::Color::BLACK;
 
         // Get bot's move
@@ -583,75 +820,71 @@ public:
         if (move.empty())
         {
             // Failed to get bot's move, possibly due to an error
-            std::cerr << "[ChessBot] Failed to generate a move for game_id: " << game_id << std::endl;
+            std::cerr << "[ChessBot] Failed to generate a move for game_id: " << game->game_id << std::endl;
             return;
         }
 
         // Apply bot's move
-        if (makeMove(game_id, move))
+        if (!game->isGameOver() && game->makeMove(bot_move))
         {
             // Save bot's move to the database
-            data_storage.addMove(game_id, move, getGameFen(game_id));
+            data_storage.addMove(handle, move, game->getFen());
 
             // Notify players and spectators about bot's move
-            notifyPlayersAndSpectators(game_id, game);
+            notifyPlayersAndSpectators(handle, game);
 
             // Check if the game is over after bot's move
-            bool is_game_over = isGameOver(game_id);
-            if (is_game_over)
+            if (game->isGameOver())
             {
-                endGame(game_id, game);
+                endGame(handle, game);
                 return;
             }
         }
         else
         {
             // Invalid bot move, which should not happen
-            std::cerr << "[ChessBot] Invalid move detected for game_id: " << game_id << " Move: " << bot_move << std::endl;
+            std::cerr << "[ChessBot] Invalid move detected for game_id: " << game->game_id << " Move: " << bot_move << std::endl;
         }
     }
 
     /**
      * Kết thúc trò chơi, cập nhật kết quả và thông báo cho người chơi cũng như khán giả.
      *
-     * @param game_id ID của trò chơi.
+     * @param handle Handle của trò chơi.
      * @param game Con trỏ thông minh tới đối tượng trò chơi.
      */
-    void endGame(const std::string &game_id, const std::shared_ptr<Game> &game)
+    void endGame(GameHandle handle, const std::shared_ptr<Game> &game)
     {
         std::string player_white_name = game->player_white_name;
         std::string player_black_name = game->player_black_name;
 
-        // Wait briefly before ending the game
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        // Không chờ trước khi gửi GameEnd: hàm chạy trên worker dùng chung. Cập nhật nước đi cuối
+        // được xếp trước trong cùng hàng đợi gửi, và client giao quyền xử lý theo thứ tự gói tin
+        // đến (MessageHandler::pushMessage), nên GameEnd luôn xử lý sau cập nhật cuối.
 
         // Determine the winner and reason
-        std::string winner = getGameWinner(game_id);
-        std::string reason = getGameResultReason(game_id);
-        uint16_t half_moves_count = getGameHalfMovesCount(game_id);
+        std::string winner = game->winner;
+        std::string reason = game->getResultReason();
+        uint16_t half_moves_count = game->getHalfMovesCount();
 
         DataStorage &data_storage = DataStorage::getInstance();
-        data_storage.updateMatchResult(game_id, winner, reason);
+        data_storage.updateMatchResult(handle, winner, reason);
 
         // Prepare and send GameEndMessage to both players
         GameEndMessage game_end_msg;
-        game_end_msg.game_id = game_id;
+        game_end_msg.game_id = game->game_id;
+        game_end_msg.game_handle = handle;
         game_end_msg.winner_username = winner;
         game_end_msg.reason = reason;
         game_end_msg.half_moves_count = half_moves_count;
 
-        std::vector<uint8_t> serialized_end = game_end_msg.serialize();
         NetworkServer &network_server = NetworkServer::getInstance();
-        network_server.sendPacketToUsername(player_white_name, MessageType::GAME_END, serialized_end);
-        network_server.sendPacketToUsername(player_black_name, MessageType::GAME_END, serialized_end);
+        network_server.sendMessageToUsername(player_white_name, game_end_msg);
+        network_server.sendMessageToUsername(player_black_name, game_end_msg);
 
         // Prepare and send SpectateEndMessage to all spectators
         SpectateEndMessage spectate_end_msg;
-        for (int spectator_fd : game_spectators[game_id])
-        {
-            network_server.sendPacket(spectator_fd, spectate_end_msg.getType(), spectate_end_msg.serialize());
-            removeSpectator(game_id, spectator_fd);
-        }
+        network_server.broadcastMessage(takeSpectators(handle), spectate_end_msg);
 
         // Update ELO ratings if the game is not against a bot
         if (!game->is_game_with_bot)
@@ -683,7 +916,7 @@ public:
         }
 
         // Remove the game from active games
-        removeGame(game_id);
+        removeGame(handle);
     }
 
     /**
@@ -695,6 +928,8 @@ public:
      * 
      * - Nếu client đó đang trong hàng đợi ghép trận, loại bỏ khỏi hàng đợi.
      * 
+     * Phần kết thúc ván chạy trên strand của ván, sau các nước đi đã xếp trước đó; username
+     * được lấy ngay vì kết nối bị đóng trước khi strand chạy tới.
      *
      * @param client_fd File descriptor của client.
      */
@@ -706,136 +941,152 @@ public:
 
         if (game != nullptr)
         {
-            std::string game_id = game->game_id;
-            std::string opponent_name;
-
-            if (game->player_white_name == username)
-            {
-                opponent_name = game->player_black_name;
-            }
-            else if (game->player_black_name == username)
-            {
-                opponent_name = game->player_white_name;
-            }
+            runOnGame(game, client_fd, [this, username](const std::shared_ptr<Game> &game)
+                      { endGameForDisconnect(game, username); });
+        }
 
-            // Send GameResultMessage to the opponent
-            GameEndMessage game_end_msg;
-            game_end_msg.game_id = game_id;
-            game_end_msg.winner_username = opponent_name;
-            game_end_msg.reason = "Opponent disconnected";
-            game_end_msg.half_moves_count = game->getHalfMovesCount();
-            network_server.sendPacketToUsername(opponent_name, MessageType::GAME_END, game_end_msg.serialize());
-
-            // Also send the end message to all spectators and remove them
-            SpectateEndMessage spectate_end_msg;
-            for (int spectator_fd : game_spectators[game_id])
-            {
-                network_server.sendPacket(spectator_fd, spectate_end_msg.getType(), spectate_end_msg.serialize());
-                removeSpectator(game_id, spectator_fd);
-            }
-            // End sending to spectators
+        // Remove the client from the matchmaking queue
+        removePlayerFromQueue(client_fd);
+    }
 
-            // Update ELO ratings
-            DataStorage &data_storage = DataStorage::getInstance();
-            int current_elo = data_storage.getUserELO(username);
-            int current_opponent_elo = data_storage.getUserELO(opponent_name);
-            int new_elo = current_elo - 10;
-            int new_opponent_elo = current_opponent_elo + 10;
+    // Người chơi username rời đi: đối thủ thắng. Bỏ qua nếu ván đã kết thúc trước đó.
+    void endGameForDisconnect(const std::shared_ptr<Game> &game, const std::string &username)
+    {
+        if (game->isGameOver())
+            return;
+        game->markOver();
 
-            data_storage.updateUserELO(username, new_elo);
-            data_storage.updateUserELO(opponent_name, new_opponent_elo);
+        NetworkServer &network_server = NetworkServer::getInstance();
+        GameHandle handle = game->handle;
+        std::string opponent_name;
 
-            // Remove the game from the system
-            removeGame(game_id);
+        if (game->player_white_name == username)
+        {
+            opponent_name = game->player_black_name;
+        }
+        else if (game->player_black_name == username)
+        {
+            opponent_name = game->player_white_name;
         }
 
-        // Remove the client from the matchmaking queue
-        removePlayerFromQueue(client_fd);
+        // Send GameResultMessage to the opponent
+        GameEndMessage game_end_msg;
+        game_end_msg.game_id = game->game_id;
+        game_end_msg.game_handle = handle;
+        game_end_msg.winner_username = opponent_name;
+        game_end_msg.reason = "Opponent disconnected";
+        game_end_msg.half_moves_count = game->getHalfMovesCount();
+        network_server.sendMessageToUsername(opponent_name, game_end_msg);
+
+        // Also send the end message to all spectators and remove them
+        SpectateEndMessage spectate_end_msg;
+        network_server.broadcastMessage(takeSpectators(handle), spectate_end_msg);
+        // End sending to spectators
+
+        // Update ELO ratings
+        DataStorage &data_storage = DataStorage::getInstance();
+        int current_elo = data_storage.getUserELO(username);
+        int current_opponent_elo = data_storage.getUserELO(opponent_name);
+        int new_elo = current_elo - 10;
+        int new_opponent_elo = current_opponent_elo + 10;
+
+        data_storage.updateUserELO(username, new_elo);
+        data_storage.updateUserELO(opponent_name, new_opponent_elo);
+
+        // Remove the game from the system
+        removeGame(handle);
     }
 
-    bool isGameOver(const std::string &game_id)
+    bool isGameOver(GameHandle handle)
     {
-        auto game = getGame(game_id);
+        auto game = getGame(handle);
         if (game)
             return game->isGameOver();
         return false;
     }
 
-    std::string getGameFen(const std::string &game_id)
+    std::string getGameFen(GameHandle handle)
     {
-        auto game = getGame(game_id);
+        auto game = getGame(handle);
         if (game)
             return game->getFen();
         return "";
     }
 
-    std::string getGameCurrentTurn(const std::string &game_id)
+    std::string getGameCurrentTurn(GameHandle handle)
     {
-        auto game = getGame(game_id);
+        auto game = getGame(handle);
         if (game)
             return game->current_turn;
         return "";
     }
 
-    std::string getGameWinner(const std::string &game_id)
+    std::string getGameWinner(GameHandle handle)
     {
-        auto game = getGame(game_id);
+        auto game = getGame(handle);
         if (game)
             return game->winner;
         return "";
     }
 
-    std::string getGameResultReason(const std::string &game_id)
+    std::string getGameResultReason(GameHandle handle)
     {
-        auto game = getGame(game_id);
+        auto game = getGame(handle);
         if (game)
             return game->getResultReason();
         return "";
     }
 
-    uint16_t getGameHalfMovesCount(const std::string &game_id)
+    uint16_t getGameHalfMovesCount(GameHandle handle)
     {
-        auto game = getGame(game_id);
+        auto game = getGame(handle);
         if (game)
             return game->getHalfMovesCount();
         return 0;
     }
 
+    /**
+     * @brief Đưa người chơi vào hàng đợi ghép trận và ghép ngay với đối thủ gần ELO nhất nếu có.
+     *
+     * Không tìm được đối thủ thì người chơi chờ trong hàng đợi; luồng ghép trận được báo để
+     * thức dậy đúng lúc cửa sổ ELO đủ rộng. Yêu cầu lặp lại của người đang chờ bị bỏ qua.
+     */
     void addPlayerToQueue(int client_fd)
     {
+        std::string username = NetworkServer::getInstance().getUsername(client_fd);
+        uint16_t elo = DataStorage::getInstance().getUserELO(username);
+
+        std::optional<MatchmakingPool::Match> match;
         {
             std::lock_guard<std::mutex> lock(matchmaking_mutex);
-            matchmaking_queue.push(client_fd);
+            auto now = MatchmakingPool::Clock::now();
+            if (!matchmaking_pool.add(client_fd, elo, now))
+                return;
+            match = matchmaking_pool.matchArrival(client_fd, now);
         }
-        cv.notify_one();
+
+        if (match)
+            startAutoMatch(*match);
+        else
+            cv.notify_one(); // nextCheck() có thể đã sớm hơn
     }
 
     void removePlayerFromQueue(int client_fd)
     {
         std::lock_guard<std::mutex> lock(matchmaking_mutex);
-        std::queue<int> new_queue;
-        while (!matchmaking_queue.empty())
-        {
-            int front = matchmaking_queue.front();
-            matchmaking_queue.pop();
-            if (front != client_fd)
-            {
-                new_queue.push(front);
-            }
-        }
-        matchmaking_queue = new_queue;
+        matchmaking_pool.remove(client_fd);
     }
 
     /**
-     * Xử lý sự chấp nhận trận đấu từ client cho trò chơi được xác định bởi game_id.
+     * Xử lý sự chấp nhận trận đấu từ client cho trò chơi được xác định bởi handle.
      *
      * @param client_fd Định danh của khách hàng.
-     * @param game_id ID của trò chơi đang chờ.
+     * @param handle Handle của trò chơi đang chờ.
      */
-    void handleAutoMatchAccepted(int client_fd, const std::string &game_id)
+    void handleAutoMatchAccepted(int client_fd, GameHandle handle)
     {
         std::lock_guard<std::mutex> lock(games_mutex);
-        auto it = pending_games.find(game_id);
+        auto it = pending_games.find(handle);
         if (it != pending_games.end())
         {
             PendingGame &pending = it->second;
@@ -852,16 +1103,14 @@ public:
 
                 // Notify both players about the game start
                 GameStartMessage game_start_msg;
-                game_start_msg.game_id = game_id;
+                game_start_msg.game_id = pending.game->game_id;
+                game_start_msg.game_handle = handle;
                 game_start_msg.player1_username = network_server.getUsername(pending.player1_fd);
                 game_start_msg.player2_username = network_server.getUsername(pending.player2_fd);
                 game_start_msg.starting_player_username = game_start_msg.player1_username; // Player 1 starts
                 game_start_msg.fen = chess::constants::STARTPOS;
 
-                std::vector<uint8_t> serialized = game_start_msg.serialize();
-
-                network_server.sendPacket(pending.player1_fd, MessageType::GAME_START, serialized);
-                network_server.sendPacket(pending.player2_fd, MessageType::GAME_START, serialized);
+                network_server.broadcastMessage({pending.player1_fd, pending.player2_fd}, game_start_msg);
 
                 // Remove from pending_games
                 pending_games.erase(it);
@@ -873,96 +1122,81 @@ public:
      * @brief Xử lý từ chối ghép trận tự động của người chơi.
      *
      * @param client_fd Mã định danh kết nối của khách hàng đã từ chối.
-     * @param game_id ID của trận đấu bị từ chối.
+     * @param handle Handle của trận đấu bị từ chối.
      */
-    void handleAutoMatchDeclined(int client_fd, const std::string &game_id)
+    void handleAutoMatchDeclined(int client_fd, GameHandle handle)
     {
-        std::lock_guard<std::mutex> lock(games_mutex);
-        auto it = pending_games.find(game_id);
-        if (it != pending_games.end())
+        PendingGame pending;
         {
-            PendingGame pending = it->second;
+            std::lock_guard<std::mutex> lock(games_mutex);
+            auto it = pending_games.find(handle);
+            if (it == pending_games.end())
+                return;
+            pending = it->second;
             pending_games.erase(it);
+        }
 
-            NetworkServer &network_server = NetworkServer::getInstance();
+        NetworkServer &network_server = NetworkServer::getInstance();
 
-            // Notify the other player about the declination
-            int other_fd = (client_fd == pending.player1_fd) ? pending.player2_fd : pending.player1_fd;
-            MatchDeclinedNotificationMessage decline_msg;
-            decline_msg.game_id = game_id;
-            std::vector<uint8_t> serialized = decline_msg.serialize();
-            network_server.sendPacket(other_fd, decline_msg.getType(), serialized);
+        // Notify the other player about the declination
+        int other_fd = (client_fd == pending.player1_fd) ? pending.player2_fd : pending.player1_fd;
+        MatchDeclinedNotificationMessage decline_msg;
+        decline_msg.game_id = pending.game->game_id;
+        decline_msg.game_handle = handle;
+        network_server.sendMessage(other_fd, decline_msg);
 
-            // Requeue the other player
-            matchmaking_queue.push(other_fd);
-            cv.notify_one();
-        }
+        // Requeue the other player (ngoài games_mutex: có thể tạo ván mới ngay)
+        addPlayerToQueue(other_fd);
     }
 
-    bool isUserInGame(const std::string &username)
+    bool isUserInGame(std::string_view username)
     {
         std::lock_guard<std::mutex> lock(games_mutex);
-        for (const auto &game_pair : games)
-        {
-            std::shared_ptr<Game> game = game_pair.second;
-            if (game->player_white_name == username ||
-                game->player_black_name == username)
-            {
-                return true;
-            }
-        }
-        return false;
+        return findUserGameLocked(username) != nullptr;
     }
 
-    std::string getUserGameId(const std::string &username)
+    std::string getUserGameId(std::string_view username)
     {
-        if (!isUserInGame(username))
-        {
-            return "";
-        }
+        std::shared_ptr<Game> game = getUserGame(username);
+        return game ? game->game_id : "";
+    }
 
+    // Tra cứu O(1) qua user_games, không duyệt games
+    std::shared_ptr<Game> getUserGame(std::string_view username)
+    {
         std::lock_guard<std::mutex> lock(games_mutex);
-        for (const auto &game_pair : games)
-        {
-            std::shared_ptr<Game> game = game_pair.second;
-            if (game->player_white_name == username ||
-                game->player_black_name == username)
-            {
-                return game_pair.first;
-            }
-        }
-        return "";
+        return findUserGameLocked(username);
     }
 
-    void addSpectator(const std::string &game_id, int client_fd)
+    void addSpectator(GameHandle handle, int client_fd)
     {
         std::lock_guard<std::mutex> lock(games_mutex);
 
         // Check if game exists
-        if (games.find(game_id) == games.end())
+        if (games.find(handle) == games.end())
         {
             return;
         }
 
         // Add spectator to the game's spectator list
-        if (game_spectators.find(game_id) == game_spectators.end())
+        if (game_spectators.find(handle) == game_spectators.end())
         {
-            game_spectators[game_id] = std::vector<int>();
+            game_spectators[handle] = std::vector<int>();
         }
 
         // Only add if not already spectating
-        auto &spectators = game_spectators[game_id];
+        auto &spectators = game_spectators[handle];
         if (std::find(spectators.begin(), spectators.end(), client_fd) == spectators.end())
         {
             spectators.push_back(client_fd);
         }
     }
 
-    void removeSpectator(const std::string &game_id, int client_fd)
+    void removeSpectator(GameHandle handle, int client_fd)
     {
         std::lock_guard<std::mutex> lock(games_mutex);
 
-        auto it = game_spectators.find(game_id);
+        auto it = game_spectators.find(handle);
         if (it != game_spectators.end())
         {
             auto &spectators = it->second;
@@ -972,6 +1206,34 @@ public:
         }
     }
 
+    // Copy of the game's spectator list, taken under the lock
+    std::vector<int> getSpectators(GameHandle handle)
+    {
+        std::lock_guard<std::mutex> lock(games_mutex);
+
+        auto it = game_spectators.find(handle);
+        if (it == game_spectators.end())
+        {
+            return {};
+        }
+        return it->second;
+    }
+
+    // Remove and return every spectator of the game (used when the game ends)
+    std::vector<int> takeSpectators(GameHandle handle)
+    {
+        std::lock_guard<std::mutex> lock(games_mutex);
+
+        auto it = game_spectators.find(handle);
+        if (it == game_spectators.end())
+        {
+            return {};
+        }
+        std::vector<int> spectators = std::move(it->second);
+        game_spectators.erase(it);
+        return spectators;
+    }
+
     // Remove the client_fd from all games' spectator lists
     // (assume we don't know which games the client is spectating)
     void removeSpectatorFromAllGames(int client_fd)
@@ -987,9 +1249,11 @@ public:
                 spectators.end());
         }
     }
-    std::string getOpponent(const std::string &game_id, const std::string &player)
+    std::string getOpponent(GameHandle handle, std::string_view player)
     {
-        auto game = games.find(game_id);
+        std::lock_guard<std::mutex> lock(games_mutex);
+
+        auto game = games.find(handle);
         if (game == games.end())
             return "";
 
@@ -1001,10 +1265,58 @@ public:
         return "";
     }
 
-    void endGameForSurrender(const std::string &game_id, const std::string &surrendering_player)
+    /**
+     * @brief Xử lý yêu cầu đầu hàng trên strand của ván.
+     *
+     * Gửi GameEnd cho người đầu hàng và đối thủ rồi kết thúc ván. Yêu cầu cho ván không tồn tại,
+     * đã kết thúc, hoặc từ người không chơi ván đó bị bỏ qua.
+     *
+     * @param client_fd Kết nối gửi yêu cầu.
+     * @param handle Handle của ván cờ.
+     * @param from_username Tên người đầu hàng ghi trong thông điệp.
+     */
+    void handleSurrender(int client_fd, GameHandle handle, const std::string &from_username)
+    {
+        NetworkServer &server = NetworkServer::getInstance();
+        std::shared_ptr<Game> game = getGame(handle);
+        std::string surrendering_player = server.getUsername(client_fd);
+        std::string opponent_username = game ? getOpponent(handle, surrendering_player) : "";
+
+        if (opponent_username.empty())
+        {
+            std::cerr << "Error: Could not find opponent for game_handle: " << handle << std::endl;
+            return;
+        }
+
+        runOnGame(game, client_fd, [this, client_fd, surrendering_player, opponent_username, from_username](const std::shared_ptr<Game> &game)
+                  {
+            if (game->isGameOver())
+                return;
+
+            // Thông báo kết thúc trò chơi (lấy số nửa nước trước khi ván cờ bị xóa)
+            GameEndMessage end_message;
+            end_message.game_id = game->game_id;
+            end_message.game_handle = game->handle;
+            end_message.winner_username = opponent_username;
+            end_message.reason = surrendering_player + " has surrendered.";
+            end_message.half_moves_count = game->getHalfMovesCount();
+
+            // Dừng trận đấu
+            endGameForSurrender(game, from_username);
+
+            NetworkServer &server = NetworkServer::getInstance();
+            server.sendMessage(client_fd, end_message); // Người đầu hàng
+            int opponent_fd = server.getClientFD(opponent_username);
+            server.sendMessage(opponent_fd, end_message); // Đối thủ
+        });
+    }
+
+    // Chạy trên strand của ván
+    void endGameForSurrender(const std::shared_ptr<Game> &game, const std::string &surrendering_player)
     {
         DataStorage &datastorage = DataStorage::getInstance();
-        Game *game = getGame(game_id).get();
+        GameHandle handle = game->handle;
+        game->markOver();
 
         std::string player_white_name = game->player_white_name;
         std::string player_black_name = game->player_black_name;
@@ -1013,7 +1325,7 @@ public:
         std::string reason = "Player surrendered";
 
         // Gọi hàm updateMatchResult để cập nhật kết quả trận đấu
-        datastorage.updateMatchResult(game_id, winner, reason);
+        datastorage.updateMatchResult(handle, winner, reason);
 
         uint16_t white_elo = datastorage.getUserELO(player_white_name);
         uint16_t black_elo = datastorage.getUserELO(player_black_name);
@@ -1040,14 +1352,10 @@ public:
 
         // Prepare and send SpectateEndMessage to all spectators
         SpectateEndMessage spectate_end_msg;
-        for (int spectator_fd : game_spectators[game_id])
-        {
-            NetworkServer::getInstance().sendPacket(spectator_fd, spectate_end_msg.getType(), spectate_end_msg.serialize());
-            removeSpectator(game_id, spectator_fd);
-        }
+        NetworkServer::getInstance().broadcastMessage(takeSpectators(handle), spectate_end_msg);
 
         // Remove game
-        removeGame(game_id);
+        removeGame(handle);
     }
 };
 
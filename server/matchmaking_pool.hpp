@@ -0,0 +1,253 @@
+#ifndef MATCHMAKING_POOL_HPP
+#define MATCHMAKING_POOL_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Hàng đợi ghép trận sắp theo ELO, cửa sổ chênh lệch ELO nới rộng theo thời gian chờ.
+ *
+ * Người chơi nằm trong một cây cân bằng (std::set) sắp theo (ELO, thứ tự vào hàng đợi), kèm
+ * chỉ mục fd -> vị trí trong cây. Đối thủ gần nhất luôn là phần tử kề trước hoặc kề sau, nên:
+ *   - add(), remove(), matchArrival(): O(log n);
+ *   - matchWaiting(): duyệt các cặp kề nhau một lượt, O(n), chỉ chạy khi cửa sổ của ai đó
+ *     vừa đủ rộng (thời điểm nextCheck()), không chạy theo chu kỳ cố định.
+ *
+ * Cửa sổ của một người chơi là base_window + growth_per_second * số giây đã chờ, tối đa
+ * max_window. Hai người ghép được khi chênh lệch ELO không vượt cửa sổ của người chờ lâu hơn.
+ *
+ * Lớp không tự khóa; người gọi giữ mutex của mình.
+ */
+class MatchmakingPool
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Match
+    {
+        int fd1;
+        uint16_t elo1;
+        int fd2;
+        uint16_t elo2;
+    };
+
+    MatchmakingPool(uint32_t base_window, uint32_t max_window, uint32_t growth_per_second)
+        : base_window(base_window),
+          max_window(std::max(base_window, max_window)),
+          growth_per_second(growth_per_second)
+    {
+    }
+
+    /**
+     * @brief Thêm người chơi vào hàng đợi.
+     *
+     * @return false nếu fd đã nằm trong hàng đợi (yêu cầu ghép trận gửi lặp).
+     */
+    bool add(int fd, uint16_t elo, Clock::time_point now)
+    {
+        if (index.count(fd))
+        {
+            return false;
+        }
+        auto it = entries.insert(Entry{elo, next_sequence++, fd, now}).first;
+        index[fd] = it;
+        return true;
+    }
+
+    // Bỏ người chơi khỏi hàng đợi (ngắt kết nối); false nếu không có
+    bool remove(int fd)
+    {
+        auto found = index.find(fd);
+        if (found == index.end())
+        {
+            return false;
+        }
+        erase(found->second);
+        return true;
+    }
+
+    /**
+     * @brief Ghép người chơi vừa vào hàng đợi với đối thủ gần ELO nhất đủ điều kiện.
+     *
+     * Chỉ xét hai phần tử kề bên trong cây. Không ghép được thì người chơi ở lại hàng đợi và
+     * nextCheck() được cập nhật theo thời điểm cặp kề bên sớm nhất trở nên đủ điều kiện.
+     */
+    std::optional<Match> matchArrival(int fd, Clock::time_point now)
+    {
+        auto found = index.find(fd);
+        if (found == index.end())
+        {
+            return std::nullopt;
+        }
+        Iterator it = found->second;
+
+        std::optional<Iterator> best;
+        if (it != entries.begin())
+        {
+            Iterator prev = std::prev(it);
+            if (eligible(*prev, *it, now))
+                best = prev;
+        }
+        Iterator next = std::next(it);
+        if (next != entries.end() && eligible(*it, *next, now) &&
+            (!best || gap(*next, *it) < gap(**best, *it)))
+        {
+            best = next;
+        }
+
+        if (!best)
+        {
+            if (it != entries.begin())
+                noteDeadline(*std::prev(it), *it);
+            if (next != entries.end())
+                noteDeadline(*it, *next);
+            return std::nullopt;
+        }
+        return take(it, *best);
+    }
+
+    /**
+     * @brief Ghép mọi cặp kề nhau đã đủ điều kiện theo cửa sổ tại thời điểm now.
+     *
+     * Đồng thời tính lại nextCheck() từ các cặp còn lại.
+     */
+    std::vector<Match> matchWaiting(Clock::time_point now)
+    {
+        std::vector<Match> matches;
+        next_check = Clock::time_point::max();
+
+        Iterator it = entries.begin();
+        while (it != entries.end())
+        {
+            Iterator next = std::next(it);
+            if (next == entries.end())
+            {
+                break;
+            }
+            if (eligible(*it, *next, now))
+            {
+                Iterator after = std::next(next);
+                matches.push_back(take(it, next));
+                it = after;
+            }
+            else
+            {
+                noteDeadline(*it, *next);
+                it = next;
+            }
+        }
+        return matches;
+    }
+
+    // Thời điểm sớm nhất cần gọi matchWaiting(); time_point::max() nếu không có cặp nào sẽ đủ điều kiện
+    Clock::time_point nextCheck() const
+    {
+        return next_check;
+    }
+
+    bool contains(int fd) const
+    {
+        return index.count(fd) != 0;
+    }
+
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+    // Cửa sổ chênh lệch ELO của người đã chờ từ enqueued_at
+    uint32_t window(Clock::time_point enqueued_at, Clock::time_point now) const
+    {
+        auto waited_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - enqueued_at).count();
+        uint64_t grown = base_window + static_cast<uint64_t>(std::max<int64_t>(0, waited_ms)) * growth_per_second / 1000;
+        return static_cast<uint32_t>(std::min<uint64_t>(grown, max_window));
+    }
+
+private:
+    struct Entry
+    {
+        uint16_t elo;
+        uint64_t sequence; // Thứ tự vào hàng đợi: cùng ELO thì người đến trước đứng trước
+        int fd;
+        Clock::time_point enqueued_at;
+
+        bool operator<(const Entry &other) const
+        {
+            return elo != other.elo ? elo < other.elo : sequence < other.sequence;
+        }
+    };
+
+    using Iterator = std::set<Entry>::iterator;
+
+    uint32_t base_window;
+    uint32_t max_window;
+    uint32_t growth_per_second;
+
+    std::set<Entry> entries;
+    std::unordered_map<int, Iterator> index; // fd -> vị trí trong entries
+    uint64_t next_sequence = 0;
+    Clock::time_point next_check = Clock::time_point::max();
+
+    static uint32_t gap(const Entry &a, const Entry &b)
+    {
+        return static_cast<uint32_t>(std::abs(static_cast<int>(a.elo) - static_cast<int>(b.elo)));
+    }
+
+    bool eligible(const Entry &a, const Entry &b, Clock::time_point now) const
+    {
+        return gap(a, b) <= window(std::min(a.enqueued_at, b.enqueued_at), now);
+    }
+
+    // Ghi nhận thời điểm cửa sổ của người chờ lâu hơn trong cặp (a, b) đủ rộng để ghép
+    void noteDeadline(const Entry &a, const Entry &b)
+    {
+        uint32_t needed = gap(a, b);
+        Clock::time_point since = std::min(a.enqueued_at, b.enqueued_at);
+        if (needed <= base_window)
+        {
+            next_check = std::min(next_check, since); // Đã đủ điều kiện
+            return;
+        }
+        if (needed > max_window || growth_per_second == 0)
+        {
+            return; // Không bao giờ đủ điều kiện, trừ khi hàng xóm thay đổi
+        }
+        uint64_t extra = needed - base_window;
+        auto wait = std::chrono::milliseconds((extra * 1000 + growth_per_second - 1) / growth_per_second);
+        next_check = std::min(next_check, since + wait);
+    }
+
+    void erase(Iterator it)
+    {
+        // Hai phần tử hai bên trở thành cặp kề mới
+        if (it != entries.begin())
+        {
+            Iterator next = std::next(it);
+            if (next != entries.end())
+                noteDeadline(*std::prev(it), *next);
+        }
+        index.erase(it->fd);
+        entries.erase(it);
+    }
+
+    // Lấy cặp (a, b) ra khỏi hàng đợi; người chờ lâu hơn đứng đầu (cầm quân trắng)
+    Match take(Iterator a, Iterator b)
+    {
+        if (b->sequence < a->sequence)
+            std::swap(a, b);
+        Match match{a->fd, a->elo, b->fd, b->elo};
+        erase(a);
+        erase(b);
+        return match;
+    }
+};
+
+#endif // MATCHMAKING_POOL_HPP
@@ -1,6 +1,7 @@
 #ifndef MESSAGE_HANDLER_HPP
 #define MESSAGE_HANDLER_HPP
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <memory>
@@ -26,6 +27,10 @@ public:
     {
         switch (packet.type)
         {
+        case MessageType::HELLO:
+            // Handle protocol version handshake
+            handleHello(client_fd, packet.payload);
+            break;
         case MessageType::REGISTER:
             // Handle register
             handleRegister(client_fd, packet.payload);
@@ -38,6 +43,14 @@ public:
             // Handle move
             handleMove(client_fd, packet.payload);
             break;
+        case MessageType::MOVE_V2:
+            // Handle binary move
+            handleMoveV2(client_fd, packet.payload);
+            break;
+        case MessageType::RESYNC_REQUEST:
+            // Handle board resync request
+            handleResyncRequest(client_fd, packet.payload);
+            break;
 
         case MessageType::AUTO_MATCH_REQUEST:
             // Handle auto match request
@@ -103,14 +116,54 @@ public:
 private:
     // Handle specific message types ============================================================================
 
+    // Phiên bản giao thức dùng để giải mã payload của client
+    static uint8_t versionOf(int client_fd)
+    {
+        return NetworkServer::getInstance().getProtocolVersion(client_fd);
+    }
+
+    // Số phần tử tối đa trả về cho một yêu cầu phân trang. Mỗi yêu cầu chỉ nhận một trang;
+    // client v2 lấy trang tiếp theo bằng next_cursor, limit 0 dùng kích thước trang mặc định
+    static size_t pageSize(uint32_t limit, uint8_t version)
+    {
+        if (version < Protocol::V2)
+        {
+            return max_list_size(version);
+        }
+        return limit == 0 ? Const::LIST_PAGE_ITEMS : std::min<size_t>(limit, Const::LIST_PAGE_ITEMS);
+    }
+
     void handleUnknown(int client_fd, const std::vector<uint8_t> &payload)
     {
         std::cout << "[UNKNOWN]" << std::endl;
     }
 
+    // Payload bị cắt cụt hoặc độ dài không khớp: bỏ qua gói tin
+    void handleMalformed(int client_fd, const char *type_name)
+    {
+        std::cerr << "[" << type_name << "] payload không hợp lệ từ client_fd: " << client_fd << std::endl;
+    }
+
+    void handleHello(int client_fd, const std::vector<uint8_t> &payload)
+    {
+        HelloMessage message = HelloMessage::deserialize(payload);
+        NetworkServer &server = NetworkServer::getInstance();
+
+        HelloAckMessage ack;
+        ack.version = std::max(Protocol::V1, std::min(message.max_version, Protocol::LATEST));
+
+        std::cout << "[HELLO] client_fd: " << client_fd << ", max_version: " << static_cast<int>(message.max_version)
+                  << ", chosen: " << static_cast<int>(ack.version) << std::endl;
+
+        // Đổi phiên bản trước khi gửi ACK: client có thể gửi frame mới ngay khi nhận ACK.
+        // Bản thân ACK luôn dùng frame v1.
+        server.setProtocolVersion(client_fd, ack.version);
+        server.sendFrame(client_fd, NetworkServer::makeMessageFrame(ack, Protocol::V1));
+    }
+
     void handleRegister(int client_fd, const std::vector<uint8_t> &payload)
     {
-        RegisterMessage message = RegisterMessage::deserialize(payload);
+        RegisterMessage message = RegisterMessage::deserialize(payload, versionOf(client_fd));
 
         std::cout << "[REGISTER] username: " << message.username << std::endl;
 
@@ -124,22 +177,20 @@ private:
             RegisterSuccessMessage successMessage;
             successMessage.username = message.username;
             successMessage.elo = Const::DEFAULT_ELO;
-            std::vector<uint8_t> serialized = successMessage.serialize();
-            server.sendPacket(client_fd, successMessage.getType(), serialized);
+            server.sendMessage(client_fd, successMessage);
             server.setUsername(client_fd, message.username);
         }
         else
         {
             RegisterFailureMessage failureMessage;
             failureMessage.error_message = "Username already exists.";
-            std::vector<uint8_t> serialized = failureMessage.serialize();
-            server.sendPacket(client_fd, failureMessage.getType(), serialized);
+            server.sendMessage(client_fd, failureMessage);
         }
     }
 
     void handleLogin(int client_fd, const std::vector<uint8_t> &payload)
     {
-        LoginMessage message = LoginMessage::deserialize(payload);
+        LoginMessage message = LoginMessage::deserialize(payload, versionOf(client_fd));
 
         std::cout << "[LOGIN] username: " << message.username << ", client_fd: " << client_fd << std::endl;
 
@@ -157,39 +208,72 @@ private:
             LoginSuccessMessage successMessage;
             successMessage.username = message.username;
             successMessage.elo = elo;
-            std::vector<uint8_t> serialized = successMessage.serialize();
-            server.sendPacket(client_fd, successMessage.getType(), serialized);
+            server.sendMessage(client_fd, successMessage);
             server.setUsername(client_fd, message.username);
         }
         else if (!isUserValid)
         {
             LoginFailureMessage failureMessage;
             failureMessage.error_message = "Invalid username.";
-            std::vector<uint8_t> serialized = failureMessage.serialize();
-            server.sendPacket(client_fd, failureMessage.getType(), serialized);
+            server.sendMessage(client_fd, failureMessage);
         }
         else
         {
             LoginFailureMessage failureMessage;
             failureMessage.error_message = "User already logged in.";
-            std::vector<uint8_t> serialized = failureMessage.serialize();
-            server.sendPacket(client_fd, failureMessage.getType(), serialized);
+            server.sendMessage(client_fd, failureMessage);
         }
     }
 
     void handleMove(int client_fd, const std::vector<uint8_t> &payload)
     {
-        MoveMessage message = MoveMessage::deserialize(payload);
+        MoveMessageView message;
+        if (!MoveMessageView::decode(payload.data(), payload.size(), message, versionOf(client_fd)))
+        {
+            handleMalformed(client_fd, "MOVE");
+            return;
+        }
 
         std::cout << "[MOVE] game_id: " << message.game_id
+                  << ", game_handle: " << message.game_handle
                   << ", uci_move: " << message.uci_move << std::endl;
 
-        GameManager::getInstance().handleMove(client_fd, message.game_id, message.uci_move);
+        GameManager::getInstance().handleMove(client_fd, message.game_id, message.game_handle, message.uci_move);
+    }
+
+    void handleMoveV2(int client_fd, const std::vector<uint8_t> &payload)
+    {
+        MoveV2Message message;
+        if (!MoveV2Message::decode(payload.data(), payload.size(), message, versionOf(client_fd)))
+        {
+            handleMalformed(client_fd, "MOVE_V2");
+            return;
+        }
+
+        std::cout << "[MOVE_V2] game_handle: " << message.game_handle
+                  << ", ply: " << message.ply
+                  << ", move: " << message.move << std::endl;
+
+        GameManager::getInstance().handleMoveV2(client_fd, message);
+    }
+
+    void handleResyncRequest(int client_fd, const std::vector<uint8_t> &payload)
+    {
+        ResyncRequestMessage message;
+        if (!ResyncRequestMessage::decode(payload.data(), payload.size(), message, versionOf(client_fd)))
+        {
+            handleMalformed(client_fd, "RESYNC_REQUEST");
+            return;
+        }
+
+        std::cout << "[RESYNC_REQUEST] game_handle: " << message.game_handle << std::endl;
+
+        GameManager::getInstance().handleResyncRequest(client_fd, message.game_handle);
     }
 
     void handleAutoMatchRequest(int client_fd, const std::vector<uint8_t> &payload)
     {
-        AutoMatchRequestMessage message = AutoMatchRequestMessage::deserialize(payload);
+        AutoMatchRequestMessage message = AutoMatchRequestMessage::deserialize(payload, versionOf(client_fd));
 
         std::cout << "[AUTO_MATCH_REQUEST] username: " << message.username << std::endl;
 
@@ -200,20 +284,24 @@ private:
 
     void handleAutoMatchAccepted(int client_fd, const std::vector<uint8_t> &payload)
     {
-        AutoMatchAcceptedMessage message = AutoMatchAcceptedMessage::deserialize(payload);
+        AutoMatchAcceptedMessage message = AutoMatchAcceptedMessage::deserialize(payload, versionOf(client_fd));
 
-        std::cout << "[AUTO_MATCH_ACCEPTED] game_id: " << message.game_id << std::endl;
+        std::cout << "[AUTO_MATCH_ACCEPTED] game_id: " << message.game_id
+                  << ", game_handle: " << message.game_handle << std::endl;
 
-        GameManager::getInstance().handleAutoMatchAccepted(client_fd, message.game_id);
+        GameManager &game_manager = GameManager::getInstance();
+        game_manager.handleAutoMatchAccepted(client_fd, game_manager.resolveHandle(message.game_id, message.game_handle));
     }
 
     void handleAutoMatchDeclined(int client_fd, const std::vector<uint8_t> &payload)
     {
-        AutoMatchDeclinedMessage message = AutoMatchDeclinedMessage::deserialize(payload);
+        AutoMatchDeclinedMessage message = AutoMatchDeclinedMessage::deserialize(payload, versionOf(client_fd));
 
-        std::cout << "[AUTO_MATCH_DECLINED] game_id: " << message.game_id << std::endl;
+        std::cout << "[AUTO_MATCH_DECLINED] game_id: " << message.game_id
+                  << ", game_handle: " << message.game_handle << std::endl;
 
-        GameManager::getInstance().handleAutoMatchDeclined(client_fd, message.game_id);
+        GameManager &game_manager = GameManager::getInstance();
+        game_manager.handleAutoMatchDeclined(client_fd, game_manager.resolveHandle(message.game_id, message.game_handle));
     }
 
     void handleRequestPlayerList(int client_fd, const std::vector<uint8_t> &payload)
@@ -222,37 +310,44 @@ private:
         NetworkServer &server = NetworkServer::getInstance();
         GameManager &gameManager = GameManager::getInstance();
 
-        RequestPlayerListMessage message = RequestPlayerListMessage::deserialize(payload);
+        uint8_t version = versionOf(client_fd);
+        RequestPlayerListMessage message = RequestPlayerListMessage::deserialize(payload, version);
 
-        std::cout << "[REQUEST_PLAYER_LIST] from " << server.getUsername(client_fd) << std::endl;
+        std::cout << "[REQUEST_PLAYER_LIST] from " << server.getUsername(client_fd)
+                  << ", limit: " << message.limit << ", cursor: " << message.cursor << std::endl;
 
-        std::unordered_map<std::string, UserModel> players = storage.getPlayerList();
-        PlayerListMessage response;
+        // Chỉ đọc đúng một trang từ chỉ mục, thêm một phần tử để biết còn trang sau hay không
+        size_t count = pageSize(message.limit, version);
+        std::vector<std::string> usernames = server.getOnlineUsernames(message.cursor, count + 1);
+        bool more = usernames.size() > count;
+        usernames.resize(std::min(usernames.size(), count));
 
-        for (const auto &pair : players)
+        PlayerListMessage response;
+        for (const std::string &username : usernames)
         {
             PlayerListMessage::Player player;
-            player.username = pair.second.username;
-            player.elo = pair.second.elo;
-            player.in_game = gameManager.isUserInGame(player.username);
+            player.username = username;
+            player.elo = storage.getUserELO(username);
 
-            if (player.in_game)
+            // Một lần tra chỉ mục cho cả in_game lẫn game_id
+            std::shared_ptr<Game> game = gameManager.getUserGame(username);
+            player.in_game = game != nullptr;
+            if (game)
             {
-                player.game_id = gameManager.getUserGameId(player.username);
+                player.game_id = game->game_id;
             }
 
-            if (server.isUserLoggedIn(player.username))
-            {
-                response.players.push_back(player);
-            }
+            response.players.push_back(player);
         }
 
-        server.sendPacket(client_fd, response.getType(), response.serialize());
+        response.next_cursor = more ? usernames.back() : "";
+        response.final = !more;
+        server.sendMessage(client_fd, response);
     }
 
     void handleChallengeRequest(int client_fd, const std::vector<uint8_t> &payload)
     {
-        ChallengeRequestMessage message = ChallengeRequestMessage::deserialize(payload);
+        ChallengeRequestMessage message = ChallengeRequestMessage::deserialize(payload, versionOf(client_fd));
         NetworkServer &server = NetworkServer::getInstance();
         DataStorage &storage = DataStorage::getInstance();
 
@@ -270,8 +365,7 @@ private:
             ChallengeNotificationMessage notification_msg;
             notification_msg.from_username = server.getUsername(client_fd);
             notification_msg.elo = storage.getUserELO(notification_msg.from_username);
-            std::vector<uint8_t> serialized = notification_msg.serialize();
-            server.sendPacket(to_client_fd, notification_msg.getType(), serialized);
+            server.sendMessage(to_client_fd, notification_msg);
 
             std::cout << "[CHALLENGE_NOTIFICATION] Sent challenge from "
                       << server.getUsername(client_fd)
@@ -285,7 +379,7 @@ private:
 
     void handleChallengeResponse(int client_fd, const std::vector<uint8_t> &payload)
     {
-        ChallengeResponseMessage message = ChallengeResponseMessage::deserialize(payload);
+        ChallengeResponseMessage message = ChallengeResponseMessage::deserialize(payload, versionOf(client_fd));
         NetworkServer &network_server = NetworkServer::getInstance();
         GameManager &gameManager = GameManager::getInstance();
 
@@ -301,40 +395,37 @@ private:
 
         if (message.response == ChallengeResponseMessage::Response::ACCEPTED)
         {
-            std::string game_id = gameManager.createGame(challenger_username, challenged_username);
+            std::shared_ptr<Game> game = gameManager.createGame(challenger_username, challenged_username);
 
             // Is handling PendingGame required? Review game_manager
 
             ChallengeAcceptedMessage challenge_accepted_msg;
             challenge_accepted_msg.from_username = challenged_username;
-            challenge_accepted_msg.game_id = game_id;
+            challenge_accepted_msg.game_id = game->game_id;
+            challenge_accepted_msg.game_handle = game->handle;
 
-            std::vector<uint8_t> serialized = challenge_accepted_msg.serialize();
-            network_server.sendPacket(challenger_fd, challenge_accepted_msg.getType(), serialized);
+            network_server.sendMessage(challenger_fd, challenge_accepted_msg);
 
-            std::cout << "Game " << game_id << " started." << std::endl;
+            std::cout << "Game " << game->game_id << " started." << std::endl;
 
             // Notify both players about the game start
             GameStartMessage game_start_msg;
-            game_start_msg.game_id = game_id;
+            game_start_msg.game_id = game->game_id;
+            game_start_msg.game_handle = game->handle;
             game_start_msg.player1_username = challenger_username;
             game_start_msg.player2_username = challenged_username;
 
             game_start_msg.starting_player_username = game_start_msg.player1_username; // Player 1 starts
             game_start_msg.fen = chess::constants::STARTPOS;
 
-            std::vector<uint8_t> gs_serialized = game_start_msg.serialize();
-
-            network_server.sendPacket(challenger_fd, MessageType::GAME_START, gs_serialized);
-            network_server.sendPacket(client_fd, MessageType::GAME_START, gs_serialized);
+            network_server.broadcastMessage({challenger_fd, client_fd}, game_start_msg);
         }
         else
         {
             // If the challenge was declined, send a message to the challenger
             ChallengeDeclinedMessage challenge_declined_msg;
             challenge_declined_msg.from_username = network_server.getUsername(client_fd);
-            std::vector<uint8_t> serialized = challenge_declined_msg.serialize();
-            network_server.sendPacket(challenger_fd, challenge_declined_msg.getType(), serialized);
+            network_server.sendMessage(challenger_fd, challenge_declined_msg);
 
             std::cout << "Decline message sent to " << message.from_username << std::endl;
         }
@@ -342,7 +433,7 @@ private:
 
     void handlePlayWithBot(int client_fd, const std::vector<uint8_t> &payload)
     {
-        PlayWithBotMessage message = PlayWithBotMessage::deserialize(payload);
+        PlayWithBotMessage message = PlayWithBotMessage::deserialize(payload, versionOf(client_fd));
         NetworkServer &network_server = NetworkServer::getInstance();
         GameManager &gameManager = GameManager::getInstance();
 
@@ -350,44 +441,48 @@ private:
 
         std::cout << "[PLAY_WITH_BOT] from: " << username << std::endl;
 
-        std::string game_id = gameManager.createGameWithBot(username);
+        std::shared_ptr<Game> game = gameManager.createGameWithBot(username);
 
         // Notify the player about the game start
         GameStartMessage game_start_msg;
-        game_start_msg.game_id = game_id;
+        game_start_msg.game_id = game->game_id;
+        game_start_msg.game_handle = game->handle;
         game_start_msg.player1_username = username;
         game_start_msg.player2_username = "Bot";
         game_start_msg.starting_player_username = username; // Player 1 starts
         game_start_msg.fen = chess::constants::STARTPOS;
 
-        std::vector<uint8_t> serialized = game_start_msg.serialize();
-        network_server.sendPacket(client_fd, MessageType::GAME_START, serialized);
+        network_server.sendMessage(client_fd, game_start_msg);
 
-        std::cout << "Game " << game_id << " started." << std::endl;
+        std::cout << "Game " << game->game_id << " started." << std::endl;
     }
 
     void handleRequestSpectate(int client_fd, const std::vector<uint8_t> &payload)
     {
-        RequestSpectateMessage message = RequestSpectateMessage::deserialize(payload);
+        RequestSpectateMessageView message;
+        if (!RequestSpectateMessageView::decode(payload.data(), payload.size(), message, versionOf(client_fd)))
+        {
+            handleMalformed(client_fd, "REQUEST_SPECTATE");
+            return;
+        }
         NetworkServer &network_server = NetworkServer::getInstance();
         GameManager &gameManager = GameManager::getInstance();
 
-        std::string playing_username = message.username;
+        std::string_view playing_username = message.username;
         std::string requester_username = network_server.getUsername(client_fd);
 
-        bool is_playing = gameManager.isUserInGame(playing_username);
+        std::shared_ptr<Game> game = gameManager.getUserGame(playing_username);
 
         std::cout << "[REQUEST_SPECTATE] from: " << requester_username << ", to watch: " << playing_username << std::endl;
 
-        if (is_playing)
+        if (game)
         {
-            std::string game_id = gameManager.getUserGameId(playing_username);
-
-            gameManager.addSpectator(game_id, client_fd);
+            gameManager.addSpectator(game->handle, client_fd);
 
             SpectateSuccessMessage spectate_success_msg;
-            spectate_success_msg.game_id = game_id;
-            network_server.sendPacket(client_fd, spectate_success_msg.getType(), spectate_success_msg.serialize());
+            spectate_success_msg.game_id = game->game_id;
+            spectate_success_msg.game_handle = game->handle;
+            network_server.sendMessage(client_fd, spectate_success_msg);
 
             std::cout << "Spectate success message sent to " << requester_username << std::endl;
         }
@@ -395,7 +490,7 @@ private:
         {
             // Notify the requester that the player is not in a game
             SpectateFailureMessage spectate_failure_msg;
-            network_server.sendPacket(client_fd, spectate_failure_msg.getType(), spectate_failure_msg.serialize());
+            network_server.sendMessage(client_fd, spectate_failure_msg);
 
             std::cout << "Spectate failure message sent to " << requester_username << std::endl;
         }
@@ -403,68 +498,66 @@ private:
 
     void handleSpectateExit(int client_fd, const std::vector<uint8_t> &payload)
     {
-        SpectateExitMessage message = SpectateExitMessage::deserialize(payload);
+        SpectateExitMessageView message;
+        if (!SpectateExitMessageView::decode(payload.data(), payload.size(), message, versionOf(client_fd)))
+        {
+            handleMalformed(client_fd, "SPECTATE_EXIT");
+            return;
+        }
         NetworkServer &network_server = NetworkServer::getInstance();
         GameManager &gameManager = GameManager::getInstance();
 
-        std::string game_id = message.game_id;
+        GameHandle handle = gameManager.resolveHandle(message.game_id, message.game_handle);
         std::string username = network_server.getUsername(client_fd);
 
-        gameManager.removeSpectator(game_id, client_fd);
+        gameManager.removeSpectator(handle, client_fd);
 
-        std::cout << "[SPECTATE_EXIT] " << username << " exited spectating game " << game_id << std::endl;
+        std::cout << "[SPECTATE_EXIT] " << username << " exited spectating game " << handle << std::endl;
     }
     
     void handleSurrender(int client_fd, const std::vector<uint8_t> &payload)
     {
-        SurrenderMessage message = SurrenderMessage::deserialize(payload);
-
-        std::cout << "[SURRENDER] game_id: " << message.game_id
-                  << ", from_username: " << message.from_username << std::endl;
-
-        NetworkServer &server = NetworkServer::getInstance();
-        GameManager &game_manager = GameManager::getInstance();
-
-        std::string surrendering_player = server.getUsername(client_fd);
-        std::string opponent_username = game_manager.getOpponent(message.game_id, surrendering_player);
-
-        if (opponent_username.empty())
+        SurrenderMessageView message;
+        if (!SurrenderMessageView::decode(payload.data(), payload.size(), message, versionOf(client_fd)))
         {
-            std::cerr << "Error: Could not find opponent for game_id: " << message.game_id << std::endl;
+            handleMalformed(client_fd, "SURRENDER");
             return;
         }
 
-        // Dừng trận đấu
-        game_manager.endGameForSurrender(message.game_id, message.from_username);
-
-        // Thông báo kết thúc trò chơi
-        GameEndMessage end_message;
-        end_message.game_id = message.game_id;
-        end_message.winner_username = opponent_username;
-        end_message.reason = surrendering_player + " has surrendered.";
-        end_message.half_moves_count = game_manager.getGameHalfMovesCount(message.game_id);
+        std::cout << "[SURRENDER] game_id: " << message.game_id
+                  << ", game_handle: " << message.game_handle
+                  << ", from_username: " << message.from_username << std::endl;
 
-        std::vector<uint8_t> serialized = end_message.serialize();
-        server.sendPacket(client_fd, end_message.getType(), serialized); // Người đầu hàng
-        int opponent_fd = server.getClientFD(opponent_username);
-        server.sendPacket(opponent_fd, end_message.getType(), serialized); // Đối thủ
+        GameManager &game_manager = GameManager::getInstance();
+        game_manager.handleSurrender(client_fd, game_manager.resolveHandle(message.game_id, message.game_handle),
+                                     std::string(message.from_username));
     }
 
     void handleRequestMatchHistory(int client_fd, const std::vector<uint8_t> &payload)
     {
-        RequestMatchHistoryMessage message = RequestMatchHistoryMessage::deserialize(payload);
+        uint8_t version = versionOf(client_fd);
+        RequestMatchHistoryMessage message = RequestMatchHistoryMessage::deserialize(payload, version);
         NetworkServer &server = NetworkServer::getInstance();
         DataStorage &storage = DataStorage::getInstance();
 
         std::string username = server.getUsername(client_fd);
 
-        std::cout << "[REQUEST_MATCH_HISTORY] from " << username << std::endl;
+        std::cout << "[REQUEST_MATCH_HISTORY] from " << username
+                  << ", limit: " << message.limit << ", cursor: " << message.cursor << std::endl;
+
+        // Cursor là vị trí trong lịch sử của người chơi, rỗng hoặc không hợp lệ thì bắt đầu từ trận mới nhất
+        size_t before = SIZE_MAX;
+        if (!message.cursor.empty() && message.cursor.find_first_not_of("0123456789") == std::string::npos)
+        {
+            before = std::strtoull(message.cursor.c_str(), nullptr, 10);
+        }
 
-        std::vector<MatchModel> matches = storage.getMatchHistory(username);
+        size_t count = pageSize(message.limit, version);
+        std::vector<MatchSummary> matches = storage.getMatchHistoryPage(username, before, count, before);
 
         // Cast the matches to MatchHistoryMessage
         MatchHistoryMessage response;
-        for (const MatchModel &match : matches)
+        for (const MatchSummary &match : matches)
         {
             MatchHistoryMessage::Match match_history;
             match_history.game_id = match.game_id;
@@ -475,7 +568,10 @@ private:
             response.matches.push_back(match_history);
         }
 
-        server.sendPacket(client_fd, response.getType(), response.serialize());
+        bool more = before > 0;
+        response.next_cursor = more ? std::to_string(before) : "";
+        response.final = !more;
+        server.sendMessage(client_fd, response);
     }
 };
 
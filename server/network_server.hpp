@@ -2,32 +2,57 @@
 #define NETWORK_SERVER_HPP
 
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <mutex>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <iterator>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
+#include <cerrno>
 #include <iostream>
 
 #include "../common/protocol.hpp"
+#include "../common/lz_codec.hpp"
 #include "../common/message.hpp"
 #include "../common/const.hpp"
 
-struct ClientInfo
-{
-    std::vector<uint8_t> buffer;
-    std::mutex mutex;
-    std::string username = "";
-};
+#include "client_table.hpp"
+#include "outbound_queue.hpp"
 
 class NetworkServer
 {
 private:
     int server_fd;
-    std::unordered_map<int, ClientInfo> clients;
-    std::mutex clients_mutex;
+    uint16_t listen_port = 0;
+    std::vector<int> extra_listen_fds; // Socket lắng nghe của các reactor phụ (SO_REUSEPORT)
+    ClientTable clients; // fd -> ClientInfo và username -> fd, chia shard theo khóa
+
+    // Số lượng iovec tối đa cho mỗi lần gọi writev
+    static constexpr int MAX_IOV = 64;
+
+    // SendBatch đang mở trên luồng hiện tại: gói tin chỉ được xếp hàng, xả khi batch kết thúc
+    static inline thread_local int batch_depth = 0;
+    static inline thread_local std::unordered_set<int> *batch_dirty = nullptr;
+
+    // Ngưỡng nén payload cho frame v2 (0: tắt), xem setCompressionThreshold()
+    static inline std::atomic<size_t> compression_threshold{Const::COMPRESSION_THRESHOLD};
+
+    // RequestScope đang mở trên luồng hiện tại: câu trả lời gửi cho request_fd mang request_id
+    static inline thread_local int request_fd = -1;
+    static inline thread_local uint32_t request_id = Protocol::NO_REQUEST_ID;
+
+    // Request ID cần gắn vào gói tin gửi cho client_fd, hoặc Protocol::NO_REQUEST_ID
+    static uint32_t requestIdFor(int client_fd)
+    {
+        return client_fd == request_fd ? request_id : Protocol::NO_REQUEST_ID;
+    }
 
     /**
      * @brief Khởi tạo máy chủ với cổng được chỉ định.
@@ -39,34 +64,181 @@ private:
      */
     void initialize(uint16_t port)
     {
-        server_fd = socket(AF_INET, SOCK_STREAM, 0);
+        listen_port = port;
+        server_fd = createListener(port);
         if (server_fd == -1)
         {
-            perror("socket failed");
             exit(EXIT_FAILURE);
         }
 
+        std::cout << "Server đang lắng nghe trên: 0.0.0.0:" << port << " ..." << std::endl;
+    }
+
+    /**
+     * @brief Tạo một socket lắng nghe với SO_REUSEPORT trên cổng đã cho.
+     *
+     * Nhiều socket cùng bind vào một cổng; kernel chia kết nối mới giữa chúng theo hash
+     * của địa chỉ, nên mỗi reactor có thể có hàng đợi accept riêng.
+     *
+     * @return fd của socket, -1 nếu thất bại.
+     */
+    static int createListener(uint16_t port)
+    {
+        int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listen_fd == -1)
+        {
+            perror("socket failed");
+            return -1;
+        }
+
+        int one = 1;
+        if (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0 ||
+            setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0)
+        {
+            perror("setsockopt SO_REUSEPORT failed");
+            close(listen_fd);
+            return -1;
+        }
+
         sockaddr_in address;
         std::memset(&address, 0, sizeof(address));
         address.sin_family = AF_INET;
         address.sin_addr.s_addr = INADDR_ANY;
         address.sin_port = htons(port);
 
-        if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0)
+        if (bind(listen_fd, (struct sockaddr *)&address, sizeof(address)) < 0)
         {
             perror("bind failed");
-            close(server_fd);
-            exit(EXIT_FAILURE);
+            close(listen_fd);
+            return -1;
         }
 
-        if (listen(server_fd, Const::BACKLOG) < 0)
+        if (listen(listen_fd, Const::BACKLOG) < 0)
         {
             perror("listen failed");
-            close(server_fd);
-            exit(EXIT_FAILURE);
+            close(listen_fd);
+            return -1;
         }
+        return listen_fd;
+    }
 
-        std::cout << "Server đang lắng nghe trên: " << inet_ntoa(address.sin_addr) << ":" << ntohs(address.sin_port) << " ..." << std::endl;
+    std::shared_ptr<ClientInfo> findOrCreateClient(int client_fd)
+    {
+        return clients.findOrCreate(client_fd);
+    }
+
+    /**
+     * @brief Gửi cho nhiều client; build(version) chỉ được gọi lần đầu gặp mỗi phiên bản.
+     */
+    template <typename FrameBuilder>
+    size_t broadcastEncoded(const std::vector<int> &client_fds, FrameBuilder &&build)
+    {
+        if (client_fds.empty())
+        {
+            return 0;
+        }
+
+        // Gom các lần xả của mọi người nhận vào một batch (hoặc batch đang mở của luồng gọi)
+        SendBatch batch;
+        OutboundFrame frames[Protocol::LATEST + 1];
+        size_t queued = 0;
+        for (int client_fd : client_fds)
+        {
+            uint8_t version = getProtocolVersion(client_fd);
+            OutboundFrame &frame = frames[version];
+            if (!frame)
+            {
+                frame = build(version);
+            }
+            if (sendFrame(client_fd, frame, true))
+            {
+                ++queued;
+            }
+        }
+        return queued;
+    }
+
+    /**
+     * @brief Xả hàng đợi gửi của client bằng writev cho đến khi rỗng hoặc socket đầy.
+     *
+     * Khi gặp EAGAIN phần còn lại được giữ nguyên; EpollReactor sẽ gọi flushPending()
+     * khi socket ghi được trở lại (EPOLLOUT). Yêu cầu giữ write_mutex của client.
+     *
+     * @return false nếu gặp lỗi không thể phục hồi trên socket.
+     */
+    bool flushLocked(int client_fd, ClientInfo &client)
+    {
+        bool ok = flushQueueLocked(client_fd, client);
+        checkSlowConsumerLocked(client_fd, client);
+        return ok;
+    }
+
+    bool flushQueueLocked(int client_fd, ClientInfo &client)
+    {
+        while (!client.outbound.empty())
+        {
+            iovec iov[MAX_IOV];
+            int iov_count = 0;
+            for (auto it = client.outbound.begin(); it != client.outbound.end() && iov_count < MAX_IOV; ++it)
+            {
+                size_t skip = (iov_count == 0) ? client.outbound_offset : 0;
+                iov[iov_count].iov_base = const_cast<uint8_t *>((*it)->data()) + skip;
+                iov[iov_count].iov_len = (*it)->size() - skip;
+                ++iov_count;
+            }
+
+            ssize_t sent = writev(client_fd, iov, iov_count);
+            if (sent < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    return true;
+                perror("writev failed");
+                client.outbound.clear();
+                client.outbound_offset = 0;
+                client.outbound_bytes = 0;
+                return false;
+            }
+
+            // Bỏ các gói tin đã gửi xong khỏi hàng đợi
+            size_t remaining = static_cast<size_t>(sent);
+            while (remaining > 0)
+            {
+                size_t front_left = client.outbound.front()->size() - client.outbound_offset;
+                if (remaining < front_left)
+                {
+                    client.outbound_offset += remaining;
+                    break;
+                }
+                remaining -= front_left;
+                client.outbound_bytes -= client.outbound.front()->size();
+                client.outbound.pop_front();
+                client.outbound_offset = 0;
+            }
+        }
+        return true;
+    }
+
+    void disconnectSlowConsumer(int client_fd, const ClientInfo &client)
+    {
+        std::cerr << "Client " << client_fd << " nhận quá chậm (" << client.outbound_bytes
+                  << " byte chờ gửi), ngắt kết nối." << std::endl;
+        shutdown(client_fd, SHUT_RDWR);
+    }
+
+    /**
+     * @brief Xếp frame vào hàng đợi gửi theo chính sách của OutboundQueue.
+     *
+     * Client vượt giới hạn liên tục quá Const::SLOW_CONSUMER_TIMEOUT_MS bị shutdown(); reactor
+     * sẽ thấy EOF và đi qua đường ngắt kết nối thông thường. Yêu cầu giữ write_mutex của client.
+     */
+    void enqueueLocked(int client_fd, ClientInfo &client, const OutboundFrame &frame)
+    {
+        if (OutboundQueue::push(client, frame, OutboundQueue::Clock::now()))
+        {
+            disconnectSlowConsumer(client_fd, client);
+        }
     }
 
     // Private constructor for Singleton
@@ -96,54 +268,458 @@ public:
         return instance;
     }
 
+    /**
+     * @brief Kiểm tra lại giới hạn hàng đợi sau khi dữ liệu đã được gửi đi.
+     *
+     * Gọi trên đường xả hàng đợi (EPOLLOUT, hoàn tất send của io_uring): xóa mốc vượt giới hạn
+     * khi hàng đợi đã xuống dưới giới hạn, và ngắt client vẫn vượt quá thời gian cho phép ngay
+     * cả khi không có frame mới được xếp. Yêu cầu giữ write_mutex của client.
+     */
+    void checkSlowConsumerLocked(int client_fd, ClientInfo &client)
+    {
+        if (OutboundQueue::updateOverLimit(client, OutboundQueue::Clock::now()))
+        {
+            disconnectSlowConsumer(client_fd, client);
+        }
+    }
+
+    /**
+     * @brief Backend gửi bất đồng bộ (io_uring) nhận việc xả hàng đợi thay cho writev trực tiếp.
+     */
+    class SendBackend
+    {
+    public:
+        virtual ~SendBackend() = default;
+
+        // Yêu cầu xả hàng đợi gửi của client; có thể được gọi từ bất kỳ luồng nào
+        virtual void requestFlush(int client_fd) = 0;
+    };
+
+    // Backend phải sống lâu hơn mọi luồng còn gửi (worker pool): một luồng có thể đã đọc con trỏ
+    // ngay trước khi nó được đặt về nullptr
+    void setSendBackend(SendBackend *backend)
+    {
+        send_backend.store(backend);
+    }
+
+    std::shared_ptr<ClientInfo> findClient(int client_fd)
+    {
+        return clients.find(client_fd);
+    }
+
+private:
+    std::atomic<SendBackend *> send_backend{nullptr};
+
+public:
+
     /**
      * @brief Chấp nhận kết nối mới từ khách hàng.
      *
+     * @param non_blocking Đặt socket của client ở chế độ non-blocking (dùng cho EpollReactor).
+     * @return fd của client nếu thành công, -1 nếu thất bại.
+     */
+    int acceptConnection(bool non_blocking = false)
+    {
+        return acceptConnection(server_fd, non_blocking);
+    }
+
+    /**
+     * @brief Chấp nhận kết nối mới trên một socket lắng nghe cụ thể (mỗi reactor một socket).
+     *
+     * @param listen_fd Socket lắng nghe.
+     * @param non_blocking Đặt socket của client ở chế độ non-blocking.
      * @return fd của client nếu thành công, -1 nếu thất bại.
      */
-    int acceptConnection()
+    int acceptConnection(int listen_fd, bool non_blocking)
     {
         sockaddr_in client_address;
         socklen_t client_len = sizeof(client_address);
 
-        int client_fd = accept(server_fd, (struct sockaddr *)&client_address, &client_len);
+        int flags = non_blocking ? SOCK_NONBLOCK | SOCK_CLOEXEC : 0;
+        int client_fd = accept4(listen_fd, (struct sockaddr *)&client_address, &client_len, flags);
         if (client_fd < 0)
         {
-            perror("accept failed");
+            // Socket lắng nghe non-blocking: hết kết nối chờ không phải là lỗi
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                perror("accept failed");
+            }
             return -1;
         }
 
+        registerConnection(client_fd, client_address);
+        return client_fd;
+    }
+
+    /**
+     * @brief Ghi nhận một kết nối đã được chấp nhận bên ngoài (ví dụ accept của io_uring).
+     *
+     * @param client_fd fd của client.
+     * @param client_address Địa chỉ của client.
+     */
+    void registerConnection(int client_fd, const sockaddr_in &client_address)
+    {
+        findOrCreateClient(client_fd);
+
         std::cout << "Client kết nối từ: " << inet_ntoa(client_address.sin_addr) << ":"
                   << ntohs(client_address.sin_port) << " (fd = " << client_fd << ")" << std::endl;
-        return client_fd;
+    }
+
+    /**
+     * @brief Phiên bản giao thức đã thỏa thuận với client (Protocol::V1 nếu chưa HELLO).
+     */
+    uint8_t getProtocolVersion(int client_fd)
+    {
+        std::shared_ptr<ClientInfo> client = findClient(client_fd);
+        if (client == nullptr)
+        {
+            return Protocol::V1;
+        }
+        return client->protocol_version.load();
+    }
+
+    /**
+     * @brief Chuyển client sang phiên bản giao thức mới.
+     *
+     * Các gói gửi sau lời gọi này dùng phiên bản mới; buffer nhận được chuyển sang header
+     * mới ở lần đọc tiếp theo của reactor. Client chỉ gửi frame mới sau khi nhận HELLO_ACK,
+     * nên phải gọi hàm này trước khi xếp HELLO_ACK vào hàng đợi.
+     */
+    void setProtocolVersion(int client_fd, uint8_t version)
+    {
+        std::shared_ptr<ClientInfo> client = findClient(client_fd);
+        if (client != nullptr)
+        {
+            client->protocol_version.store(version);
+        }
+    }
+
+    /**
+     * @brief Đóng gói payload thành một frame bất biến dùng chung được.
+     *
+     * v1: [type][length (htons, byte cao trước)][payload], giống Packet::serialize.
+     * v2: [type][request ID nếu có][length varint][payload].
+     */
+    static OutboundFrame makeFrame(MessageType messageType, const std::vector<uint8_t> &payload,
+                                   uint8_t version = Protocol::V1, uint32_t request_id = Protocol::NO_REQUEST_ID)
+    {
+        return compressFrame(encodeFrame(messageType, payload, version, request_id), version);
+    }
+
+    /**
+     * @brief Đóng gói thông điệp thẳng vào buffer của frame: header và payload được ghi trong
+     * một lượt, không qua vector payload trung gian.
+     */
+    template <typename Message>
+    static OutboundFrame makeMessageFrame(const Message &message, uint8_t version,
+                                          uint32_t request_id = Protocol::NO_REQUEST_ID)
+    {
+        std::vector<uint8_t> frame(encodedSize(message, version, request_id));
+        encodeTo(message, frame.data(), version, request_id);
+        return compressFrame(std::move(frame), version);
+    }
+
+    /**
+     * @brief Đặt ngưỡng nén: frame v2 có payload từ threshold byte trở lên được nén bằng Lz.
+     *
+     * @param threshold Số byte payload tối thiểu, 0 để tắt nén.
+     */
+    static void setCompressionThreshold(size_t threshold)
+    {
+        compression_threshold.store(threshold);
+    }
+
+    /**
+     * @brief Nén frame v2 đã đóng gói nếu payload vượt ngưỡng và nén có lợi.
+     *
+     * Frame nén: [COMPRESSED][request ID nếu có][length varint][type gốc][độ dài gốc varint][khối Lz].
+     * Frame v1, frame nhỏ hoặc nén không giảm kích thước được giữ nguyên.
+     */
+    static OutboundFrame compressFrame(std::vector<uint8_t> &&frame, uint8_t version)
+    {
+        size_t threshold = compression_threshold.load(std::memory_order_relaxed);
+        MessageType messageType;
+        uint32_t frame_request_id;
+        size_t header_size;
+        uint32_t length;
+        if (version < Protocol::V2 || threshold == 0 || frame.size() < threshold ||
+            parseFrameHeaderV2(frame.data(), frame.size(), messageType, frame_request_id, header_size, length) <= 0 ||
+            length < threshold || messageType == MessageType::BATCH || messageType == MessageType::COMPRESSED)
+        {
+            return std::make_shared<const std::vector<uint8_t>>(std::move(frame));
+        }
+
+        std::vector<uint8_t> body;
+        body.push_back(static_cast<uint8_t>(messageType));
+        append_varint(body, length);
+        size_t prefix = body.size();
+        body.resize(prefix + Lz::compressBound(length));
+        body.resize(prefix + Lz::compress(frame.data() + header_size, length, body.data() + prefix));
+        if (body.size() >= length)
+        {
+            return std::make_shared<const std::vector<uint8_t>>(std::move(frame));
+        }
+
+        return std::make_shared<const std::vector<uint8_t>>(
+            encodeFrame(MessageType::COMPRESSED, body, Protocol::V2, frame_request_id));
     }
 
     /**
      * Gửi một gói tin đến client.
      *
+     * Gói tin được đưa vào hàng đợi gửi của client rồi xả ngay bằng writev, không chặn
+     * luồng gọi khi socket đầy (phần còn lại được EpollReactor gửi tiếp khi có EPOLLOUT).
+     * Trong một SendBatch, gói tin chỉ được xếp hàng và được xả chung khi batch kết thúc.
+     * Header được đóng gói theo phiên bản giao thức của client; trong RequestScope của chính
+     * client này, header mang request ID của yêu cầu đang xử lý.
+     *
      * @param client_fd Định danh của client.
      * @param messageType Loại thông điệp.
      * @param payload Dữ liệu payload của gói tin.
-     * @return true nếu gửi thành công, false nếu thất bại.
+     * @return true nếu gói tin đã được nhận vào hàng đợi, false nếu thất bại.
      */
     bool sendPacket(int client_fd, MessageType messageType, const std::vector<uint8_t> &payload)
     {
-        Packet packet;
-        packet.type = messageType;
-        packet.length = htons(static_cast<uint16_t>(payload.size()));
-        packet.payload = payload;
-    
-        std::vector<uint8_t> serialized = packet.serialize();
-    
-        ssize_t sent = send(client_fd, serialized.data(), serialized.size(), 0);
-        if (sent != static_cast<ssize_t>(serialized.size()))
-        {
-            perror("send failed");
+        return sendFrame(client_fd, makeFrame(messageType, payload, getProtocolVersion(client_fd), requestIdFor(client_fd)));
+    }
+
+    /**
+     * @brief Tuần tự hóa thông điệp theo phiên bản giao thức của client rồi gửi.
+     */
+    template <typename Message>
+    bool sendMessage(int client_fd, const Message &message)
+    {
+        uint8_t version = getProtocolVersion(client_fd);
+        return sendFrame(client_fd, makeMessageFrame(message, version, requestIdFor(client_fd)));
+    }
+
+    /**
+     * @brief Gửi thông điệp đến người dùng bằng tên đăng nhập.
+     */
+    template <typename Message>
+    bool sendMessageToUsername(const std::string &username, const Message &message)
+    {
+        int client_fd = getClientFD(username);
+        if (client_fd == -1)
+        {
+            std::cerr << "Username " << username << " không được tìm thấy." << std::endl;
             return false;
         }
+        return sendMessage(client_fd, message);
+    }
+
+    /**
+     * @brief Gửi cùng một gói tin đến nhiều client, chỉ đóng gói một lần cho mỗi phiên bản.
+     *
+     * Mỗi người nhận chỉ tốn một lần xếp con trỏ vào hàng đợi (ví dụ cập nhật nước đi cho
+     * hàng trăm khán giả). Các fd không còn tồn tại được bỏ qua.
+     *
+     * @param client_fds Danh sách client nhận.
+     * @param messageType Loại thông điệp.
+     * @param payload Dữ liệu payload của gói tin.
+     * @return Số client đã nhận gói tin vào hàng đợi.
+     */
+    size_t broadcast(const std::vector<int> &client_fds, MessageType messageType, const std::vector<uint8_t> &payload)
+    {
+        return broadcastEncoded(client_fds, [messageType, &payload](uint8_t version)
+                                { return makeFrame(messageType, payload, version); });
+    }
+
+    /**
+     * @brief Broadcast một thông điệp, tuần tự hóa một lần cho mỗi phiên bản giao thức có mặt.
+     */
+    template <typename Message>
+    size_t broadcastMessage(const std::vector<int> &client_fds, const Message &message)
+    {
+        return broadcastEncoded(client_fds, [&message](uint8_t version)
+                                { return makeMessageFrame(message, version); });
+    }
+
+    /**
+     * @brief Xếp một frame đã đóng gói vào hàng đợi gửi của client.
+     *
+     * @param quiet Không in lỗi khi client không tồn tại (dùng cho broadcast).
+     * @return true nếu frame đã được nhận vào hàng đợi.
+     */
+    bool sendFrame(int client_fd, const OutboundFrame &frame, bool quiet = false)
+    {
+        std::shared_ptr<ClientInfo> client = findClient(client_fd);
+        if (client == nullptr)
+        {
+            if (!quiet)
+            {
+                std::cerr << "Client " << client_fd << " không tồn tại." << std::endl;
+            }
+            return false;
+        }
+
+        SendBackend *backend;
+        {
+            std::lock_guard<std::mutex> lock(client->write_mutex);
+            if (client->closed)
+            {
+                return false;
+            }
+
+            if (batch_depth > 0)
+            {
+                client->batch_frames.push_back(frame);
+                batch_dirty->insert(client_fd);
+                return true;
+            }
+
+            enqueueLocked(client_fd, *client, frame);
+
+            backend = send_backend.load();
+            if (backend == nullptr)
+            {
+                return flushLocked(client_fd, *client);
+            }
+        }
+
+        // Dùng đúng con trỏ đã đọc trong khóa: send_backend có thể về nullptr ngay sau đó
+        backend->requestFlush(client_fd);
         return true;
     }
 
+    /**
+     * @brief Kết thúc một SendBatch cho client: xếp các frame của batch vào hàng đợi (gộp thành
+     * frame BATCH với client v2, xem OutboundQueue::pushBatch) rồi xả hàng đợi.
+     */
+    void flushBatch(int client_fd)
+    {
+        std::shared_ptr<ClientInfo> client = findClient(client_fd);
+        if (client == nullptr)
+        {
+            return;
+        }
+
+        SendBackend *backend;
+        {
+            std::lock_guard<std::mutex> lock(client->write_mutex);
+            if (client->closed)
+            {
+                client->batch_frames.clear();
+                return;
+            }
+
+            std::vector<OutboundFrame> frames;
+            frames.swap(client->batch_frames);
+            bool coalesce = client->protocol_version.load() >= Protocol::V2;
+            if (OutboundQueue::pushBatch(*client, frames, coalesce, OutboundQueue::Clock::now()))
+            {
+                disconnectSlowConsumer(client_fd, *client);
+            }
+
+            backend = send_backend.load();
+            if (backend == nullptr)
+            {
+                flushLocked(client_fd, *client);
+                return;
+            }
+        }
+
+        backend->requestFlush(client_fd);
+    }
+
+    /**
+     * @brief Gửi tiếp dữ liệu còn trong hàng đợi của client (gọi khi socket ghi được).
+     *
+     * @param client_fd Định danh của client.
+     * @return false nếu gặp lỗi trên socket.
+     */
+    bool flushPending(int client_fd)
+    {
+        std::shared_ptr<ClientInfo> client = findClient(client_fd);
+        if (client == nullptr)
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(client->write_mutex);
+        if (client->closed)
+        {
+            return false;
+        }
+        return flushLocked(client_fd, *client);
+    }
+
+    /**
+     * @brief Gom các gói tin gửi trên luồng hiện tại để xả chung một lần.
+     *
+     * Trong thời gian tồn tại của đối tượng, sendPacket chỉ giữ gói tin lại cho client.
+     * Khi đối tượng bị hủy, hàng đợi của mỗi client liên quan được xả bằng một lần writev
+     * (ví dụ: cập nhật trạng thái + kết thúc trận + thông báo cho khán giả). Với client v2,
+     * các gói tin đó được gộp thành frame BATCH, trừ gói tin LATEST_ONLY.
+     */
+    class SendBatch
+    {
+    public:
+        SendBatch()
+        {
+            if (batch_depth++ == 0)
+            {
+                batch_dirty = &dirty;
+            }
+        }
+
+        ~SendBatch()
+        {
+            if (--batch_depth == 0)
+            {
+                batch_dirty = nullptr;
+                NetworkServer &network_server = NetworkServer::getInstance();
+                for (int client_fd : dirty)
+                {
+                    network_server.flushBatch(client_fd);
+                }
+            }
+        }
+
+        SendBatch(const SendBatch &) = delete;
+        SendBatch &operator=(const SendBatch &) = delete;
+
+    private:
+        std::unordered_set<int> dirty;
+    };
+
+    /**
+     * @brief Gắn request ID của gói tin đang xử lý vào các câu trả lời gửi cho client đó.
+     *
+     * Trong thời gian tồn tại của đối tượng, sendPacket/sendMessage tới client_fd trên luồng
+     * hiện tại ghi request ID vào header v2. Gói tin gửi cho client khác và frame broadcast
+     * (dùng chung cho nhiều người nhận) không bị ảnh hưởng.
+     */
+    class RequestScope
+    {
+    public:
+        RequestScope(int client_fd, uint32_t id)
+            : saved_fd(request_fd), saved_id(request_id)
+        {
+            request_fd = (id != Protocol::NO_REQUEST_ID) ? client_fd : -1;
+            request_id = id;
+        }
+
+        ~RequestScope()
+        {
+            request_fd = saved_fd;
+            request_id = saved_id;
+        }
+
+        RequestScope(const RequestScope &) = delete;
+        RequestScope &operator=(const RequestScope &) = delete;
+
+    private:
+        int saved_fd;
+        uint32_t saved_id;
+    };
+
+    // Request ID của RequestScope đang mở cho client_fd trên luồng hiện tại (để mang sang luồng khác)
+    static uint32_t currentRequestId(int client_fd)
+    {
+        return requestIdFor(client_fd);
+    }
+
     /**
      * Gửi một gói tin đến người dùng bằng tên đăng nhập.
      *
@@ -154,16 +730,13 @@ public:
      */
     bool sendPacketToUsername(const std::string &username, MessageType messageType, const std::vector<uint8_t> &payload)
     {
-        std::lock_guard<std::mutex> lock(clients_mutex);
-        for (const auto &pair : clients)
+        int client_fd = getClientFD(username);
+        if (client_fd == -1)
         {
-            if (pair.second.username == username)
-            {
-                return sendPacket(pair.first, messageType, payload);
-            }
+            std::cerr << "Username " << username << " không được tìm thấy." << std::endl;
+            return false;
         }
-        std::cerr << "Username " << username << " không được tìm thấy." << std::endl;
-        return false;
+        return sendPacket(client_fd, messageType, payload);
     }
 
     /**
@@ -175,106 +748,188 @@ public:
      */
     bool receivePacket(int client_fd, Packet &packet)
     {
-        // Đọc dữ liệu từ client_fd mà không giữ khóa
-        uint8_t buffer_temp[Const::BUFFER_SIZE];
-        ssize_t bytes_received = recv(client_fd, buffer_temp, sizeof(buffer_temp), 0);
-        if (bytes_received <= 0)
+        std::shared_ptr<ClientInfo> client = findOrCreateClient(client_fd);
+
+        std::lock_guard<std::mutex> lock(client->mutex);
+        PacketView view;
+        while (!client->framer.next(view))
         {
-            return false;
+            size_t span_size;
+            uint8_t *span = client->framer.writableSpan(span_size);
+            ssize_t bytes_received = recv(client_fd, span, span_size, 0);
+            if (bytes_received <= 0)
+            {
+                return false;
+            }
+            client->framer.commit(bytes_received);
         }
 
-        // Bảo vệ map clients khi thêm dữ liệu vào buffer
+        packet = view.toPacket();
+        return true;
+    }
+
+    /**
+     * @brief Đọc hết dữ liệu đang có trên socket non-blocking và tách mọi gói tin hoàn chỉnh.
+     *
+     * Dùng cho EpollReactor (edge-triggered): recv thẳng vào buffer vòng của client
+     * đến khi gặp EAGAIN, sau mỗi lần đọc gọi on_packet cho mọi gói tin hoàn chỉnh.
+     * Gói tin chưa nhận đủ được giữ lại cho lần đọc sau.
+     *
+     * @param client_fd Mô tả socket của client.
+     * @param on_packet Hàm nhận từng PacketView (chỉ hợp lệ trong lúc gọi).
+     * @return false nếu kết nối đã đóng, gặp lỗi hoặc nhận frame không hợp lệ, true nếu kết nối vẫn còn.
+     */
+    template <typename Callback>
+    bool readFromClient(int client_fd, Callback &&on_packet)
+    {
+        std::shared_ptr<ClientInfo> client = findClient(client_fd);
+        if (client == nullptr)
         {
-            std::lock_guard<std::mutex> lock(clients_mutex);
-            clients[client_fd].buffer.insert(clients[client_fd].buffer.end(), buffer_temp, buffer_temp + bytes_received);
+            return false;
         }
 
-        // Xử lý gói tin
+        std::lock_guard<std::mutex> lock(client->mutex);
+        PacketFramer &framer = client->framer;
+
+        while (true)
         {
-            // Bảo vệ buffer của client_fd
-            std::lock_guard<std::mutex> lock(clients[client_fd].mutex);
-            auto &buffer = clients[client_fd].buffer;
-            while (buffer.size() >= 3)
+            size_t span_size;
+            uint8_t *span = framer.writableSpan(span_size);
+            ssize_t bytes_received = recv(client_fd, span, span_size, 0);
+            if (bytes_received > 0)
             {
-                MessageType type = static_cast<MessageType>(buffer[0]);
-                uint16_t length = (static_cast<uint16_t>(buffer[1]) << 8) |
-                                  static_cast<uint16_t>(buffer[2]);
-
-                length = ntohs(length);
-
-                if (buffer.size() < 3 + length)
+                framer.commit(bytes_received);
+                framer.setVersion(client->protocol_version.load());
+                framer.drain(on_packet);
+                if (framer.failed())
                 {
-                    break; // Chưa đủ dữ liệu
+                    std::cerr << "Client " << client_fd << " gửi frame không hợp lệ." << std::endl;
+                    return false;
                 }
-
-                std::vector<uint8_t> payload(buffer.begin() + 3, buffer.begin() + 3 + length);
-                packet = Packet{type, length, payload};
-
-                buffer.erase(buffer.begin(), buffer.begin() + 3 + length);
+                continue;
+            }
+            if (bytes_received < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (bytes_received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
                 return true;
             }
+            return false; // Kết nối đã đóng hoặc lỗi
+        }
+    }
+
+    /**
+     * @brief Đưa dữ liệu đã nhận sẵn (ví dụ từ buffer của io_uring) vào buffer vòng của client.
+     *
+     * @param client_fd Mô tả socket của client.
+     * @param data Dữ liệu nhận được.
+     * @param size Số byte.
+     * @param on_packet Hàm nhận từng PacketView hoàn chỉnh (chỉ hợp lệ trong lúc gọi).
+     * @return false nếu client không tồn tại hoặc gửi frame không hợp lệ.
+     */
+    template <typename Callback>
+    bool consumeBytes(int client_fd, const uint8_t *data, size_t size, Callback &&on_packet)
+    {
+        std::shared_ptr<ClientInfo> client = findClient(client_fd);
+        if (client == nullptr)
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(client->mutex);
+        client->framer.append(data, size);
+        client->framer.setVersion(client->protocol_version.load());
+        client->framer.drain(on_packet);
+        if (client->framer.failed())
+        {
+            std::cerr << "Client " << client_fd << " gửi frame không hợp lệ." << std::endl;
+            return false;
         }
+        return true;
+    }
 
-        return false; // Chưa nhận đủ dữ liệu
+    int getServerFD() const
+    {
+        return server_fd;
+    }
+
+    /**
+     * @brief Mở thêm một socket lắng nghe trên cùng cổng cho một reactor khác.
+     *
+     * Socket được đóng cùng socket chính trong closeAllConnections().
+     *
+     * @return fd của socket mới, -1 nếu thất bại.
+     */
+    int openListener()
+    {
+        int listen_fd = createListener(listen_port);
+        if (listen_fd != -1)
+        {
+            extra_listen_fds.push_back(listen_fd);
+        }
+        return listen_fd;
     }
 
     void setUsername(int client_fd, const std::string &username)
     {
-        std::lock_guard<std::mutex> lock(clients_mutex);
-        clients[client_fd].username = username;
+        clients.setUsername(client_fd, username);
     }
 
     std::string getUsername(int client_fd)
     {
-        std::lock_guard<std::mutex> lock(clients_mutex);
-        return clients[client_fd].username;
+        return clients.getUsername(client_fd);
     }
 
     int getClientFD(const std::string &username)
     {
-        std::lock_guard<std::mutex> lock(clients_mutex);
-        for (const auto &pair : clients)
-        {
-            if (pair.second.username == username)
-            {
-                return pair.first;
-            }
-        }
-        return -1;
+        return clients.getClientFD(username);
     }
 
     bool isUserLoggedIn(const std::string &username)
     {
-        std::lock_guard<std::mutex> lock(clients_mutex);
-        for (const auto &pair : clients)
-        {
-            if (pair.second.username == username)
-            {
-                return true;
-            }
-        }
-        return false;
+        return clients.getClientFD(username) != -1;
+    }
+
+    /**
+     * @brief Một trang username đang đăng nhập, theo thứ tự từ điển, đứng sau cursor.
+     */
+    std::vector<std::string> getOnlineUsernames(const std::string &cursor, size_t limit)
+    {
+        return clients.usernamesAfter(cursor, limit);
     }
 
     void closeConnection(int client_fd)
     {
-        close(client_fd);
-        // Xóa thông tin client khỏi clients map
+        // Xóa thông tin client khỏi bảng clients
+        std::shared_ptr<ClientInfo> client = clients.erase(client_fd);
+
+        // Chặn các luồng đang giữ client gửi tiếp vào fd có thể đã được tái sử dụng
+        if (client)
         {
-            std::lock_guard<std::mutex> lock(clients_mutex);
-            clients.erase(client_fd);
+            std::lock_guard<std::mutex> lock(client->write_mutex);
+            client->closed = true;
+            client->outbound.clear();
+            client->outbound_bytes = 0;
         }
+        close(client_fd);
     }
 
     void closeAllConnections()
     {
-        std::lock_guard<std::mutex> lock(clients_mutex);
         close(server_fd);
-        for (auto &pair : clients)
+        for (int listen_fd : extra_listen_fds)
+        {
+            close(listen_fd);
+        }
+        extra_listen_fds.clear();
+        for (auto &pair : clients.clear())
         {
+            std::lock_guard<std::mutex> client_lock(pair.second->write_mutex);
+            pair.second->closed = true;
             close(pair.first);
         }
-        clients.clear();
     }
 
     void dispose()
@@ -0,0 +1,168 @@
+#ifndef OUTBOUND_QUEUE_HPP
+#define OUTBOUND_QUEUE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "client_table.hpp"
+
+/**
+ * @brief Giới hạn hàng đợi gửi của một client: chính sách theo loại thông điệp và phát hiện
+ * client nhận quá chậm.
+ *
+ * Các hàm chỉ thao tác trên ClientInfo, không đụng tới socket; người gọi giữ write_mutex của
+ * client và tự shutdown() kết nối khi được báo quá hạn. Thời điểm hiện tại được truyền vào
+ * để kiểm thử được.
+ */
+namespace OutboundQueue
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Chính sách khi hàng đợi gửi của client vượt giới hạn, theo loại thông điệp
+    enum class SendPolicy
+    {
+        RELIABLE,    // Luôn xếp hàng, không bao giờ bỏ (thông điệp của người chơi)
+        LATEST_ONLY, // Chỉ giữ gói mới nhất cùng loại (vị trí bàn cờ cho khán giả)
+    };
+
+    // Loại thông điệp của frame đã đóng gói (bỏ cờ request ID của header v2)
+    inline MessageType frameType(const OutboundFrame &frame)
+    {
+        return static_cast<MessageType>((*frame)[0] & ~Protocol::REQUEST_ID_FLAG);
+    }
+
+    inline SendPolicy sendPolicyFor(MessageType messageType)
+    {
+        switch (messageType)
+        {
+        case MessageType::SPECTATE_MOVE:
+            return SendPolicy::LATEST_ONLY;
+        default:
+            return SendPolicy::RELIABLE;
+        }
+    }
+
+    /**
+     * @brief Cập nhật mốc vượt giới hạn sau mọi thay đổi của outbound_bytes (xếp hàng hoặc gửi).
+     *
+     * Xuống dưới Const::OUTBOUND_LIMIT_BYTES thì mốc được xóa, nên một lần vượt giới hạn đã
+     * xả hết không làm lần vượt sau bị ngắt ngay.
+     *
+     * @return true nếu client đã vượt giới hạn liên tục quá Const::SLOW_CONSUMER_TIMEOUT_MS.
+     */
+    inline bool updateOverLimit(ClientInfo &client, Clock::time_point now)
+    {
+        if (client.outbound_bytes <= Const::OUTBOUND_LIMIT_BYTES)
+        {
+            client.over_limit_since = {};
+            return false;
+        }
+        if (client.over_limit_since == Clock::time_point{})
+        {
+            client.over_limit_since = now;
+            return false;
+        }
+        return now - client.over_limit_since > std::chrono::milliseconds(Const::SLOW_CONSUMER_TIMEOUT_MS);
+    }
+
+    /**
+     * @brief Xếp frame vào hàng đợi, áp dụng giới hạn byte và chính sách của loại thông điệp.
+     *
+     * Khi vượt Const::OUTBOUND_LIMIT_BYTES, các frame LATEST_ONLY cùng loại chưa gửi được thay
+     * bằng frame mới. Gói đầu hàng đợi đã gửi một phần không bao giờ bị bỏ.
+     *
+     * @return true nếu client đã nhận quá chậm quá lâu và nên bị ngắt kết nối.
+     */
+    inline bool push(ClientInfo &client, const OutboundFrame &frame, Clock::time_point now)
+    {
+        MessageType messageType = frameType(frame);
+        if (client.outbound_bytes + frame->size() > Const::OUTBOUND_LIMIT_BYTES &&
+            sendPolicyFor(messageType) == SendPolicy::LATEST_ONLY)
+        {
+            auto first = client.outbound.begin();
+            if (first != client.outbound.end() && client.outbound_offset > 0)
+            {
+                ++first;
+            }
+            for (auto it = first; it != client.outbound.end();)
+            {
+                if (frameType(*it) == messageType)
+                {
+                    client.outbound_bytes -= (*it)->size();
+                    it = client.outbound.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+
+        client.outbound.push_back(frame);
+        client.outbound_bytes += frame->size();
+        return updateOverLimit(client, now);
+    }
+
+    // Frame được gộp vào BATCH: không phải handshake (luôn ở dạng v1), BATCH, hay LATEST_ONLY
+    // (frame LATEST_ONLY phải nằm riêng trong hàng đợi để push() còn thay được)
+    inline bool coalescible(const OutboundFrame &frame)
+    {
+        MessageType messageType = frameType(frame);
+        return messageType != MessageType::HELLO_ACK && messageType != MessageType::BATCH &&
+               sendPolicyFor(messageType) == SendPolicy::RELIABLE;
+    }
+
+    // Đóng gói frames[first, last) thành một frame BATCH v2
+    inline OutboundFrame makeBatch(const std::vector<OutboundFrame> &frames, size_t first, size_t last, size_t payload_size)
+    {
+        auto batch = std::make_shared<std::vector<uint8_t>>(frameHeaderSize(payload_size, Protocol::V2) + payload_size);
+        uint8_t *out = storeFrameHeader(batch->data(), MessageType::BATCH, payload_size, Protocol::V2);
+        for (size_t i = first; i < last; ++i)
+        {
+            out = std::copy(frames[i]->begin(), frames[i]->end(), out);
+        }
+        return batch;
+    }
+
+    /**
+     * @brief Xếp các frame của một SendBatch vào hàng đợi theo đúng thứ tự.
+     *
+     * Với coalesce (client v2), mỗi dãy frame gộp được liên tiếp trở thành một frame BATCH
+     * không quá Protocol::MAX_PAYLOAD_SIZE. Chỉ các frame của batch này được gộp: frame đã nằm
+     * trong hàng đợi từ trước giữ nguyên, nên client nhận chậm vẫn được bỏ frame LATEST_ONLY cũ.
+     *
+     * @return true nếu client đã nhận quá chậm quá lâu và nên bị ngắt kết nối.
+     */
+    inline bool pushBatch(ClientInfo &client, const std::vector<OutboundFrame> &frames, bool coalesce, Clock::time_point now)
+    {
+        bool expired = false;
+        size_t i = 0;
+        while (i < frames.size())
+        {
+            size_t end = i;
+            size_t payload_size = 0;
+            while (coalesce && end < frames.size() && coalescible(frames[end]) &&
+                   payload_size + frames[end]->size() <= Protocol::MAX_PAYLOAD_SIZE)
+            {
+                payload_size += frames[end]->size();
+                ++end;
+            }
+
+            if (end - i >= 2)
+            {
+                expired = push(client, makeBatch(frames, i, end, payload_size), now) || expired;
+                i = end;
+            }
+            else
+            {
+                expired = push(client, frames[i], now) || expired;
+                ++i;
+            }
+        }
+        return expired;
+    }
+}
+
+#endif // OUTBOUND_QUEUE_HPP
@@ -1,69 +1,195 @@
-#include <thread>
-#include <vector>
 #include <iostream>
 #include <csignal>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "network_server.hpp"
 #include "message_handler.hpp"
+#include "epoll_reactor.hpp"
+#include "uring_reactor.hpp"
+#include "worker_pool.hpp"
 
 #include "../common/message.hpp"
 #include "../common/const.hpp"
 
-void handleClient(int client_fd);
+void handleDisconnect(int client_fd);
 
-int main()
+int main(int argc, char *argv[])
 {
+    // Chọn backend I/O: --backend=epoll (mặc định) hoặc --backend=io_uring
+    // Số reactor epoll: --reactors=N (0 = số CPU), --pin-cpus để ghim reactor i vào CPU i
+    // Số worker xử lý logic game: --workers=N (0 = số CPU), --pool-stats=S in thống kê mỗi S giây
+    // Nén payload v2 từ N byte trở lên: --compress-threshold=N (0 = tắt nén)
+    bool use_uring = false;
+    int reactor_count = 1;
+    bool pin_cpus = false;
+    int worker_count = 0;
+    int stats_interval = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--backend=io_uring")
+            use_uring = true;
+        else if (arg == "--backend=epoll")
+            use_uring = false;
+        else if (arg.rfind("--reactors=", 0) == 0)
+            reactor_count = std::max(0, std::atoi(arg.c_str() + std::strlen("--reactors=")));
+        else if (arg == "--pin-cpus")
+            pin_cpus = true;
+        else if (arg.rfind("--workers=", 0) == 0)
+            worker_count = std::max(0, std::atoi(arg.c_str() + std::strlen("--workers=")));
+        else if (arg.rfind("--pool-stats=", 0) == 0)
+            stats_interval = std::max(0, std::atoi(arg.c_str() + std::strlen("--pool-stats=")));
+        else if (arg.rfind("--compress-threshold=", 0) == 0)
+            NetworkServer::setCompressionThreshold(std::max(0, std::atoi(arg.c_str() + std::strlen("--compress-threshold="))));
+    }
+
+    unsigned cpu_count = std::max(1u, std::thread::hardware_concurrency());
+    if (reactor_count == 0)
+    {
+        reactor_count = static_cast<int>(cpu_count);
+    }
+    if (worker_count == 0)
+    {
+        worker_count = static_cast<int>(cpu_count);
+    }
+
+    // Ghi vào socket đã bị đóng trả về EPIPE thay vì kết thúc tiến trình
+    std::signal(SIGPIPE, SIG_IGN);
+
     // Khởi tạo NetworkServer
     NetworkServer &network_server = NetworkServer::getInstance();
 
-    // Tạo một vector chứa tất cả các thread xử lý client
-    std::vector<std::thread> client_threads;
+    MessageHandler message_handler;
+
+    // Luồng I/O chỉ tách gói tin; handler chạy trên worker pool. Khóa theo fd nên các gói
+    // của cùng một client (và sự kiện ngắt kết nối sau cùng) được xử lý đúng thứ tự.
+    WorkerPool worker_pool(worker_count, Const::WORKER_QUEUE_CAPACITY);
+    // Mỗi ván cờ có một strand trên cùng pool: nước đi, đầu hàng, ngắt kết nối và nước đi
+    // của bot trong một ván chạy tuần tự, các ván khác nhau chạy song song
+    GameManager::getInstance().setWorkerPool(&worker_pool);
+    auto on_packet = [&worker_pool, &message_handler](int client_fd, Packet packet)
+    {
+        worker_pool.submit(client_fd, [&message_handler, client_fd, packet = std::move(packet)]()
+                           {
+            NetworkServer::SendBatch batch;
+            NetworkServer::RequestScope request(client_fd, packet.request_id);
+            message_handler.handleMessage(client_fd, packet); });
+    };
+    auto on_disconnect = [&worker_pool](int client_fd)
+    {
+        worker_pool.submit(client_fd, [client_fd]()
+                           {
+            handleDisconnect(client_fd);
+            NetworkServer::getInstance().closeConnection(client_fd); });
+    };
 
-    while (true)
+    std::atomic<bool> stats_running(stats_interval > 0);
+    std::thread stats_thread;
+    if (stats_interval > 0)
     {
-        int client_fd = network_server.acceptConnection();
-        if (client_fd != -1)
+        stats_thread = std::thread([&worker_pool, &stats_running, stats_interval]()
+                                   {
+            while (stats_running)
+            {
+                std::this_thread::sleep_for(std::chrono::seconds(stats_interval));
+                WorkerPool::Stats stats = worker_pool.stats();
+                std::cout << "[WORKER_POOL] workers=" << stats.workers
+                          << " queued=" << stats.queued
+                          << " max_queued=" << stats.max_queued
+                          << " completed=" << stats.completed
+                          << " blocked_submits=" << stats.blocked_submits
+                          << " avg_wait_us=" << stats.avg_wait_us
+                          << " max_wait_us=" << stats.max_wait_us << std::endl;
+            } });
+    }
+
+    bool started = false;
+#ifdef HAS_IO_URING
+    // Reactor io_uring là backend gửi của NetworkServer: nó phải sống đến sau worker_pool.shutdown()
+    // vì worker có thể vẫn đang gọi requestFlush() khi vòng lặp sự kiện đã dừng
+    std::unique_ptr<UringReactor> uring_reactor;
+#endif
+    if (use_uring)
+    {
+#ifdef HAS_IO_URING
+        // io_uring dùng một ring duy nhất làm backend gửi, không chia nhiều reactor
+        uring_reactor = std::make_unique<UringReactor>(on_packet, on_disconnect);
+        if (uring_reactor->setup())
         {
-            // Tạo một thread mới để xử lý client
-            client_threads.emplace_back(std::thread(handleClient, client_fd));
+            std::cout << "Backend I/O: io_uring" << std::endl;
+            started = uring_reactor->run();
         }
+        else
+        {
+            std::cerr << "Không thể khởi tạo io_uring, chuyển sang epoll." << std::endl;
+        }
+#else
+        std::cerr << "Server được biên dịch không có io_uring, chuyển sang epoll." << std::endl;
+#endif
     }
 
-    // Join tất cả các thread trước khi kết thúc chương trình
-    for (auto &th : client_threads)
+    if (!started)
     {
-        if (th.joinable())
+        // Mỗi reactor epoll có socket lắng nghe SO_REUSEPORT riêng; reactor 0 dùng socket chính
+        // và chạy trên luồng main, các reactor còn lại chạy trên luồng riêng
+        std::vector<std::unique_ptr<EpollReactor>> reactors;
+        for (int i = 0; i < reactor_count; ++i)
         {
-            th.join();
+            int listen_fd = (i == 0) ? network_server.getServerFD() : network_server.openListener();
+            if (listen_fd == -1)
+            {
+                std::cerr << "Không thể mở socket lắng nghe cho reactor " << i << "." << std::endl;
+                break;
+            }
+            int cpu = pin_cpus ? static_cast<int>(i % cpu_count) : -1;
+            reactors.push_back(std::make_unique<EpollReactor>(on_packet, on_disconnect, listen_fd, cpu));
+        }
+        std::cout << "Backend I/O: epoll, " << reactors.size() << " reactor" << std::endl;
+
+        std::vector<std::thread> reactor_threads;
+        for (size_t i = 1; i < reactors.size(); ++i)
+        {
+            reactor_threads.emplace_back([&reactors, i]()
+                                         { reactors[i]->run(); });
+        }
+
+        if (!reactors[0]->run())
+        {
+            std::cerr << "Không thể khởi động vòng lặp sự kiện." << std::endl;
+        }
+
+        for (size_t i = 1; i < reactors.size(); ++i)
+        {
+            reactors[i]->stop();
+        }
+        for (auto &thread : reactor_threads)
+        {
+            thread.join();
         }
     }
 
+    worker_pool.shutdown();
+    stats_running = false;
+    if (stats_thread.joinable())
+    {
+        stats_thread.join();
+    }
     network_server.closeAllConnections();
 
     return 0;
 }
 
-void handleClient(int client_fd)
+void handleDisconnect(int client_fd)
 {
-    NetworkServer &network_server = NetworkServer::getInstance();
-    MessageHandler message_handler;
-
-    while (true)
-    {
-        Packet packet;
-        bool received = network_server.receivePacket(client_fd, packet);
-        if (!received)
-        {
-            std::cout << "Client " << client_fd << " ngắt kết nối." << std::endl;
-            GameManager &game_manager = GameManager::getInstance();
-            game_manager.clientDisconnected(client_fd);
-            game_manager.removeSpectatorFromAllGames(client_fd);
-
-            network_server.closeConnection(client_fd);
-            break;
-        }
-
-        // Handle message
-        message_handler.handleMessage(client_fd, packet);
-    }
-}
\ No newline at end of file
+    GameManager &game_manager = GameManager::getInstance();
+    game_manager.clientDisconnected(client_fd);
+    game_manager.removeSpectatorFromAllGames(client_fd);
+}
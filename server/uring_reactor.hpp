@@ -0,0 +1,718 @@
+#ifndef URING_REACTOR_HPP
+#define URING_REACTOR_HPP
+
+// Backend io_uring chỉ được biên dịch khi header của kernel hỗ trợ multishot recv và buffer ring
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+
+#if defined(IORING_RECV_MULTISHOT) && defined(IORING_ACCEPT_MULTISHOT) && defined(IORING_POLL_ADD_MULTI)
+#define HAS_IO_URING 1
+#endif
+
+#ifdef HAS_IO_URING
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <iostream>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "../common/protocol.hpp"
+
+#include "network_server.hpp"
+
+/**
+ * @brief Vòng lặp sự kiện dùng io_uring, thay thế cho EpollReactor với cùng giao diện.
+ *
+ * Một luồng duy nhất chạy run(). Kết nối mới được nhận bằng multishot accept, dữ liệu
+ * được nhận bằng multishot recv vào các buffer do server cấp sẵn (provided buffer ring),
+ * nên mỗi lần nhận không cần nộp lại yêu cầu và không cần buffer riêng cho từng client.
+ * Hàng đợi gửi của client được gửi bằng một chuỗi IORING_OP_SEND liên kết (IOSQE_IO_LINK)
+ * để giữ đúng thứ tự; mỗi client chỉ có tối đa một chuỗi đang gửi.
+ *
+ * Các luồng khác yêu cầu gửi thông qua NetworkServer::SendBackend; reactor được đánh thức
+ * bằng eventfd. Gọi các syscall io_uring trực tiếp, không phụ thuộc liburing. Cần kernel 6.0+.
+ */
+class UringReactor : public NetworkServer::SendBackend
+{
+public:
+    // Gói tin được chuyển quyền sở hữu cho callback (có thể đưa thẳng vào hàng đợi worker)
+    using PacketCallback = std::function<void(int client_fd, Packet packet)>;
+    // Callback chịu trách nhiệm gọi NetworkServer::closeConnection (có thể sau đó, trên luồng khác)
+    using DisconnectCallback = std::function<void(int client_fd)>;
+
+    UringReactor(PacketCallback on_packet, DisconnectCallback on_disconnect)
+        : ring_fd(-1),
+          event_fd(-1),
+          listen_fd(-1),
+          running(false),
+          on_packet(std::move(on_packet)),
+          on_disconnect(std::move(on_disconnect))
+    {
+    }
+
+    // Delete copy constructor and assignment operator
+    UringReactor(const UringReactor &) = delete;
+    UringReactor &operator=(const UringReactor &) = delete;
+
+    ~UringReactor()
+    {
+        NetworkServer::getInstance().setSendBackend(nullptr);
+        if (ring_fd != -1)
+        {
+            close(ring_fd);
+        }
+        if (event_fd != -1)
+        {
+            close(event_fd);
+        }
+        if (sqes != nullptr)
+        {
+            munmap(sqes, sqe_map_size);
+        }
+        if (cq_map != nullptr && cq_map != sq_map)
+        {
+            munmap(cq_map, cq_map_size);
+        }
+        if (sq_map != nullptr)
+        {
+            munmap(sq_map, sq_map_size);
+        }
+        if (buf_ring != nullptr)
+        {
+            munmap(buf_ring, buf_ring_size);
+        }
+    }
+
+    /**
+     * @brief Khởi tạo io_uring, buffer ring và eventfd đánh thức.
+     *
+     * @return false nếu kernel không hỗ trợ (khi đó server nên dùng EpollReactor).
+     */
+    bool setup()
+    {
+        io_uring_params params{};
+        ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, RING_ENTRIES, &params));
+        if (ring_fd < 0)
+        {
+            ring_fd = -1;
+            perror("io_uring_setup failed");
+            return false;
+        }
+
+        if (!mapRings(params) || !registerBufferRing())
+        {
+            return false;
+        }
+
+        event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (event_fd == -1)
+        {
+            perror("eventfd failed");
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Chạy vòng lặp sự kiện trên luồng hiện tại cho đến khi stop() được gọi.
+     *
+     * @return false nếu không thể khởi tạo io_uring, true khi vòng lặp kết thúc bình thường.
+     */
+    bool run()
+    {
+        if (ring_fd == -1 && !setup())
+        {
+            return false;
+        }
+
+        NetworkServer &network_server = NetworkServer::getInstance();
+        listen_fd = network_server.getServerFD();
+        loop_thread = std::this_thread::get_id();
+        network_server.setSendBackend(this);
+
+        prepareAccept();
+        prepareWakeup();
+
+        running = true;
+        while (running)
+        {
+            {
+                // Gói tin sinh ra khi xử lý các CQE trong lượt này được gửi chung một chuỗi
+                NetworkServer::SendBatch batch;
+                reapCompletions();
+            }
+            startPendingSends();
+
+            if (!submit(1))
+            {
+                break;
+            }
+        }
+
+        network_server.setSendBackend(nullptr);
+        return true;
+    }
+
+    void stop()
+    {
+        running = false;
+        wake();
+    }
+
+    void requestFlush(int client_fd) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(flush_mutex);
+            flush_requests.push_back(client_fd);
+        }
+        if (std::this_thread::get_id() != loop_thread)
+        {
+            wake();
+        }
+    }
+
+private:
+    static constexpr unsigned RING_ENTRIES = 256;
+    static constexpr unsigned BUFFER_COUNT = 256; // lũy thừa của 2
+    static constexpr unsigned BUFFER_SIZE = 4096;
+    static constexpr uint16_t BUFFER_GROUP = 0;
+    static constexpr size_t MAX_CHAIN = 32; // số gói tin tối đa trong một chuỗi send
+
+    // user_data: 8 bit loại thao tác | 16 bit chỉ số gói trong chuỗi | 40 bit fd hoặc id chuỗi
+    enum Op : uint64_t
+    {
+        OP_ACCEPT = 1,
+        OP_RECV = 2,
+        OP_SEND = 3,
+        OP_WAKEUP = 4,
+    };
+
+    static uint64_t packUserData(Op op, uint64_t index, uint64_t value)
+    {
+        return (static_cast<uint64_t>(op) << 56) | (index << 40) | (value & ((1ULL << 40) - 1));
+    }
+
+    // Một chuỗi send đang chờ kernel hoàn tất
+    struct InflightSend
+    {
+        int client_fd;
+        std::shared_ptr<ClientInfo> client;
+        std::vector<OutboundFrame> frames;
+        size_t first_offset; // Số byte của gói đầu đã được gửi trước đó
+        std::vector<int> results;
+        size_t completed = 0;
+    };
+
+    int ring_fd;
+    int event_fd;
+    int listen_fd;
+    std::atomic<bool> running;
+    std::thread::id loop_thread;
+
+    PacketCallback on_packet;
+    DisconnectCallback on_disconnect;
+
+    // Submission/completion queue được ánh xạ từ kernel
+    void *sq_map = nullptr;
+    void *cq_map = nullptr;
+    size_t sq_map_size = 0;
+    size_t cq_map_size = 0;
+    io_uring_sqe *sqes = nullptr;
+    size_t sqe_map_size = 0;
+    unsigned *sq_head = nullptr;
+    unsigned *sq_tail = nullptr;
+    unsigned *sq_mask = nullptr;
+    unsigned *sq_array = nullptr;
+    unsigned sq_entries = 0;
+    unsigned *cq_head = nullptr;
+    unsigned *cq_tail = nullptr;
+    unsigned *cq_mask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+    unsigned pending_submit = 0;
+
+    // Provided buffer ring cho multishot recv. Truy cập như mảng io_uring_buf thay vì qua
+    // io_uring_buf_ring::bufs: trong C++ macro mảng linh hoạt của header làm lệch bufs 8 byte
+    io_uring_buf *buf_ring = nullptr;
+    uint16_t *buf_ring_tail = nullptr; // nằm đè lên trường resv của phần tử đầu tiên
+    size_t buf_ring_size = 0;
+    std::vector<uint8_t> buffers;
+    uint16_t buf_tail = 0;
+
+    // Yêu cầu gửi từ mọi luồng, được xử lý ở đầu mỗi vòng lặp
+    std::mutex flush_mutex;
+    std::vector<int> flush_requests;
+
+    std::unordered_map<uint64_t, InflightSend> inflight;
+    uint64_t next_send_id = 1;
+
+    bool mapRings(const io_uring_params &params)
+    {
+        sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap)
+        {
+            sq_map_size = cq_map_size = std::max(sq_map_size, cq_map_size);
+        }
+
+        sq_map = mmap(nullptr, sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        if (sq_map == MAP_FAILED)
+        {
+            sq_map = nullptr;
+            perror("mmap SQ ring failed");
+            return false;
+        }
+
+        if (single_mmap)
+        {
+            cq_map = sq_map;
+        }
+        else
+        {
+            cq_map = mmap(nullptr, cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+            if (cq_map == MAP_FAILED)
+            {
+                cq_map = nullptr;
+                perror("mmap CQ ring failed");
+                return false;
+            }
+        }
+
+        sqe_map_size = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqe_map = mmap(nullptr, sqe_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+        if (sqe_map == MAP_FAILED)
+        {
+            perror("mmap SQEs failed");
+            return false;
+        }
+        sqes = static_cast<io_uring_sqe *>(sqe_map);
+
+        uint8_t *sq = static_cast<uint8_t *>(sq_map);
+        sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        sq_entries = params.sq_entries;
+
+        uint8_t *cq = static_cast<uint8_t *>(cq_map);
+        cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    bool registerBufferRing()
+    {
+        buf_ring_size = BUFFER_COUNT * sizeof(io_uring_buf);
+        void *ring_memory = mmap(nullptr, buf_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ring_memory == MAP_FAILED)
+        {
+            perror("mmap buffer ring failed");
+            return false;
+        }
+        // Chạm vào vùng nhớ trước khi đăng ký để kernel ghim đúng trang mà ta sẽ ghi
+        std::memset(ring_memory, 0, buf_ring_size);
+        buf_ring = static_cast<io_uring_buf *>(ring_memory);
+        buf_ring_tail = &buf_ring[0].resv;
+
+        io_uring_buf_reg reg{};
+        reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring);
+        reg.ring_entries = BUFFER_COUNT;
+        reg.bgid = BUFFER_GROUP;
+        if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+        {
+            perror("io_uring_register PBUF_RING failed");
+            return false;
+        }
+
+        buffers.resize(static_cast<size_t>(BUFFER_COUNT) * BUFFER_SIZE);
+        for (uint16_t bid = 0; bid < BUFFER_COUNT; ++bid)
+        {
+            addBuffer(bid);
+        }
+        publishBuffers();
+        return true;
+    }
+
+    void addBuffer(uint16_t bid)
+    {
+        io_uring_buf &buf = buf_ring[buf_tail & (BUFFER_COUNT - 1)];
+        buf.addr = reinterpret_cast<uint64_t>(buffers.data() + static_cast<size_t>(bid) * BUFFER_SIZE);
+        buf.len = BUFFER_SIZE;
+        buf.bid = bid;
+        ++buf_tail;
+    }
+
+    void publishBuffers()
+    {
+        __atomic_store_n(buf_ring_tail, buf_tail, __ATOMIC_RELEASE);
+    }
+
+    unsigned freeSqes() const
+    {
+        unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+        return sq_entries - (*sq_tail - head);
+    }
+
+    // Lấy một SQE trống, nộp bớt hàng đợi cho kernel nếu đã đầy
+    io_uring_sqe *getSqe()
+    {
+        if (freeSqes() == 0)
+        {
+            submit(0);
+        }
+        unsigned tail = *sq_tail;
+        unsigned index = tail & *sq_mask;
+        io_uring_sqe *sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+        ++pending_submit;
+        return sqe;
+    }
+
+    bool submit(unsigned wait_count)
+    {
+        unsigned flags = wait_count > 0 ? IORING_ENTER_GETEVENTS : 0;
+        while (true)
+        {
+            int submitted = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, pending_submit, wait_count, flags, nullptr, 0));
+            if (submitted >= 0)
+            {
+                pending_submit -= std::min<unsigned>(pending_submit, static_cast<unsigned>(submitted));
+                return true;
+            }
+            if (errno == EINTR)
+            {
+                if (wait_count > 0)
+                    return true;
+                continue;
+            }
+            if (errno == EAGAIN || errno == EBUSY)
+            {
+                return true; // CQ đầy: xử lý completion rồi nộp lại sau
+            }
+            perror("io_uring_enter failed");
+            return false;
+        }
+    }
+
+    void prepareAccept()
+    {
+        io_uring_sqe *sqe = getSqe();
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = listen_fd;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_CLOEXEC;
+        sqe->user_data = packUserData(OP_ACCEPT, 0, 0);
+    }
+
+    void prepareRecv(int client_fd)
+    {
+        io_uring_sqe *sqe = getSqe();
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = client_fd;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = BUFFER_GROUP;
+        sqe->user_data = packUserData(OP_RECV, 0, static_cast<uint64_t>(client_fd));
+    }
+
+    void prepareWakeup()
+    {
+        io_uring_sqe *sqe = getSqe();
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = event_fd;
+        sqe->poll32_events = POLLIN;
+        sqe->len = IORING_POLL_ADD_MULTI;
+        sqe->user_data = packUserData(OP_WAKEUP, 0, 0);
+    }
+
+    void wake()
+    {
+        if (event_fd != -1)
+        {
+            uint64_t one = 1;
+            ssize_t ignored = write(event_fd, &one, sizeof(one));
+            (void)ignored;
+        }
+    }
+
+    void reapCompletions()
+    {
+        unsigned head = *cq_head;
+        while (head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+        {
+            // Sao chép CQE rồi trả slot ngay, để việc xử lý có thể nộp thêm SQE
+            io_uring_cqe cqe = cqes[head & *cq_mask];
+            ++head;
+            __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+            Op op = static_cast<Op>(cqe.user_data >> 56);
+            uint64_t index = (cqe.user_data >> 40) & 0xFFFF;
+            uint64_t value = cqe.user_data & ((1ULL << 40) - 1);
+
+            switch (op)
+            {
+            case OP_ACCEPT:
+                handleAccept(cqe);
+                break;
+            case OP_RECV:
+                handleRecv(static_cast<int>(value), cqe);
+                break;
+            case OP_SEND:
+                handleSendCompletion(value, static_cast<size_t>(index), cqe.res);
+                break;
+            case OP_WAKEUP:
+                handleWakeup(cqe);
+                break;
+            }
+        }
+        publishBuffers();
+    }
+
+    void handleAccept(const io_uring_cqe &cqe)
+    {
+        if (cqe.res >= 0)
+        {
+            int client_fd = cqe.res;
+            sockaddr_in client_address{};
+            socklen_t client_len = sizeof(client_address);
+            getpeername(client_fd, (struct sockaddr *)&client_address, &client_len);
+            NetworkServer::getInstance().registerConnection(client_fd, client_address);
+            prepareRecv(client_fd);
+        }
+        else
+        {
+            std::cerr << "accept failed: " << strerror(-cqe.res) << std::endl;
+        }
+
+        if (!(cqe.flags & IORING_CQE_F_MORE))
+        {
+            prepareAccept();
+        }
+    }
+
+    void handleRecv(int client_fd, const io_uring_cqe &cqe)
+    {
+        if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER))
+        {
+            uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            const uint8_t *data = buffers.data() + static_cast<size_t>(bid) * BUFFER_SIZE;
+            NetworkServer &network_server = NetworkServer::getInstance();
+            bool ok = network_server.consumeBytes(
+                client_fd, data, static_cast<size_t>(cqe.res),
+                [this, client_fd](const PacketView &view)
+                { on_packet(client_fd, view.toPacket()); });
+            addBuffer(bid);
+            if (!ok && network_server.findClient(client_fd) != nullptr)
+            {
+                // Frame không hợp lệ: recv tiếp theo trả về 0 và đi qua dropClient
+                shutdown(client_fd, SHUT_RDWR);
+            }
+
+            if (!(cqe.flags & IORING_CQE_F_MORE))
+            {
+                prepareRecv(client_fd);
+            }
+            return;
+        }
+
+        if (cqe.res == -ENOBUFS)
+        {
+            // Hết buffer tạm thời: các buffer vừa trả sẽ được công bố cuối lượt này
+            prepareRecv(client_fd);
+            return;
+        }
+
+        // res == 0 (EOF) hoặc lỗi: multishot recv đã kết thúc
+        dropClient(client_fd);
+    }
+
+    void handleWakeup(const io_uring_cqe &cqe)
+    {
+        uint64_t value;
+        ssize_t ignored = read(event_fd, &value, sizeof(value));
+        (void)ignored;
+
+        if (!(cqe.flags & IORING_CQE_F_MORE))
+        {
+            prepareWakeup();
+        }
+    }
+
+    void startPendingSends()
+    {
+        std::vector<int> requests;
+        {
+            std::lock_guard<std::mutex> lock(flush_mutex);
+            requests.swap(flush_requests);
+        }
+        for (int client_fd : requests)
+        {
+            startSend(client_fd);
+        }
+    }
+
+    /**
+     * @brief Chuyển các gói tin trong hàng đợi của client thành một chuỗi send liên kết.
+     *
+     * Không làm gì nếu client đã có chuỗi đang gửi; khi chuỗi đó hoàn tất, phần còn lại
+     * của hàng đợi sẽ được gửi tiếp.
+     */
+    void startSend(int client_fd)
+    {
+        std::shared_ptr<ClientInfo> client = NetworkServer::getInstance().findClient(client_fd);
+        if (client == nullptr)
+        {
+            return;
+        }
+
+        InflightSend send{client_fd, client, {}, 0, {}};
+        {
+            std::lock_guard<std::mutex> lock(client->write_mutex);
+            if (client->closed || client->send_in_flight || client->outbound.empty())
+            {
+                return;
+            }
+
+            send.first_offset = client->outbound_offset;
+            client->outbound_offset = 0;
+            while (!client->outbound.empty() && send.frames.size() < MAX_CHAIN)
+            {
+                send.frames.push_back(std::move(client->outbound.front()));
+                client->outbound.pop_front();
+            }
+            client->send_in_flight = true;
+        }
+
+        // Cả chuỗi phải nằm trong cùng một lần nộp để liên kết không bị cắt
+        if (freeSqes() < send.frames.size())
+        {
+            submit(0);
+        }
+
+        uint64_t send_id = next_send_id++;
+        send.results.assign(send.frames.size(), 0);
+        for (size_t i = 0; i < send.frames.size(); ++i)
+        {
+            size_t offset = (i == 0) ? send.first_offset : 0;
+            io_uring_sqe *sqe = getSqe();
+            sqe->opcode = IORING_OP_SEND;
+            sqe->fd = client_fd;
+            sqe->addr = reinterpret_cast<uint64_t>(send.frames[i]->data() + offset);
+            sqe->len = static_cast<uint32_t>(send.frames[i]->size() - offset);
+            sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+            if (i + 1 < send.frames.size())
+            {
+                sqe->flags = IOSQE_IO_LINK;
+            }
+            sqe->user_data = packUserData(OP_SEND, i, send_id);
+        }
+        inflight.emplace(send_id, std::move(send));
+    }
+
+    void handleSendCompletion(uint64_t send_id, size_t index, int result)
+    {
+        auto it = inflight.find(send_id);
+        if (it == inflight.end())
+        {
+            return;
+        }
+
+        InflightSend &send = it->second;
+        send.results[index] = result;
+        if (++send.completed < send.frames.size())
+        {
+            return;
+        }
+
+        // Tìm gói đầu tiên chưa gửi xong; chuỗi bị ngắt từ đó (các gói sau nhận -ECANCELED)
+        size_t first_unsent = send.frames.size();
+        size_t sent_of_first = 0;
+        bool failed = false;
+        for (size_t i = 0; i < send.frames.size(); ++i)
+        {
+            size_t offset = (i == 0) ? send.first_offset : 0;
+            size_t expected = send.frames[i]->size() - offset;
+            int res = send.results[i];
+            if (res >= 0 && static_cast<size_t>(res) == expected)
+            {
+                continue;
+            }
+            first_unsent = i;
+            sent_of_first = offset + (res > 0 ? static_cast<size_t>(res) : 0);
+            failed = res < 0 && res != -ECANCELED && res != -EAGAIN && res != -EINTR;
+            break;
+        }
+
+        bool more = false;
+        bool closed = false;
+        {
+            std::lock_guard<std::mutex> lock(send.client->write_mutex);
+            send.client->send_in_flight = false;
+            closed = send.client->closed;
+            for (size_t i = 0; i < first_unsent && !closed; ++i)
+            {
+                send.client->outbound_bytes -= send.frames[i]->size();
+            }
+            if (!send.client->closed && !failed)
+            {
+                // Trả phần chưa gửi về đầu hàng đợi, giữ nguyên thứ tự
+                for (size_t i = send.frames.size(); i > first_unsent; --i)
+                {
+                    send.client->outbound.push_front(std::move(send.frames[i - 1]));
+                }
+                if (first_unsent < send.frames.size())
+                {
+                    send.client->outbound_offset = sent_of_first;
+                }
+                more = !send.client->outbound.empty();
+                NetworkServer::getInstance().checkSlowConsumerLocked(send.client_fd, *send.client);
+            }
+            else if (failed)
+            {
+                send.client->outbound.clear();
+                send.client->outbound_offset = 0;
+                send.client->outbound_bytes = 0;
+            }
+        }
+
+        int client_fd = send.client_fd;
+        inflight.erase(it);
+
+        if (failed && !closed)
+        {
+            // Đánh thức multishot recv để client đi qua đường ngắt kết nối thông thường
+            shutdown(client_fd, SHUT_RDWR);
+        }
+        else if (more)
+        {
+            startSend(client_fd);
+        }
+    }
+
+    // Multishot recv đã kết thúc nên fd không còn sinh completion nhận; on_disconnect đóng kết nối
+    void dropClient(int client_fd)
+    {
+        std::cout << "Client " << client_fd << " ngắt kết nối." << std::endl;
+        on_disconnect(client_fd);
+    }
+};
+
+#endif // HAS_IO_URING
+
+#endif // URING_REACTOR_HPP
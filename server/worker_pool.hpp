@@ -0,0 +1,301 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Nhóm luồng xử lý có giới hạn, tách logic game khỏi các luồng I/O.
+ *
+ * Mỗi worker có một hàng đợi riêng với sức chứa cố định. Công việc được gửi kèm một khóa
+ * (ví dụ fd của client): mọi công việc cùng khóa đi vào cùng một worker nên được xử lý
+ * tuần tự, đúng thứ tự gửi. Khi hàng đợi đầy, submit() chờ cho đến khi có chỗ, nên luồng
+ * I/O tự chậm lại thay vì để bộ nhớ tăng không giới hạn.
+ *
+ * Độ sâu hàng đợi và thời gian chờ trong hàng đợi được thống kê qua stats() để chọn số worker.
+ */
+class WorkerPool
+{
+public:
+    using Task = std::function<void()>;
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats
+    {
+        size_t workers = 0;
+        size_t queued = 0;       // Số công việc đang chờ (tổng mọi worker)
+        size_t max_queued = 0;   // Độ sâu lớn nhất của một hàng đợi từ trước đến nay
+        uint64_t completed = 0;  // Số công việc đã xử lý xong
+        uint64_t blocked_submits = 0; // Số lần submit phải chờ vì hàng đợi đầy
+        double avg_wait_us = 0;  // Thời gian chờ trung bình trong hàng đợi
+        double max_wait_us = 0;  // Thời gian chờ lớn nhất trong hàng đợi
+    };
+
+    /**
+     * @param worker_count Số luồng worker (ít nhất 1).
+     * @param queue_capacity Số công việc tối đa trong hàng đợi của mỗi worker.
+     */
+    WorkerPool(size_t worker_count, size_t queue_capacity)
+        : capacity(std::max<size_t>(1, queue_capacity))
+    {
+        worker_count = std::max<size_t>(1, worker_count);
+        for (size_t i = 0; i < worker_count; ++i)
+        {
+            workers.push_back(std::make_unique<Worker>());
+        }
+        for (auto &worker : workers)
+        {
+            worker->thread = std::thread(&WorkerPool::workerLoop, this, worker.get());
+        }
+    }
+
+    // Delete copy constructor and assignment operator
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    ~WorkerPool()
+    {
+        shutdown();
+    }
+
+    /**
+     * @brief Đưa một công việc vào hàng đợi của worker ứng với khóa.
+     *
+     * @param key Khóa tuần tự hóa: các công việc cùng khóa chạy theo đúng thứ tự gửi.
+     * @param task Công việc cần chạy.
+     * @return false nếu pool đã dừng.
+     */
+    bool submit(uint64_t key, Task task)
+    {
+        return enqueue(key, std::move(task), true);
+    }
+
+    /**
+     * @brief Như submit() nhưng không chờ khi hàng đợi đầy.
+     *
+     * Dùng cho công việc được gửi từ chính các worker (ví dụ lượt xử lý của một Strand):
+     * nếu worker này chờ hàng đợi của worker kia và ngược lại thì cả hai kẹt mãi.
+     * Số công việc như vậy bị chặn bởi số nguồn gửi (mỗi Strand tối đa một), nên không cần giới hạn.
+     */
+    bool post(uint64_t key, Task task)
+    {
+        return enqueue(key, std::move(task), false);
+    }
+
+    class Strand;
+
+    Stats stats() const
+    {
+        Stats result;
+        result.workers = workers.size();
+        uint64_t total_wait_ns = 0;
+        uint64_t max_wait_ns = 0;
+        for (const auto &worker : workers)
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            result.queued += worker->queue.size();
+            result.max_queued = std::max(result.max_queued, worker->max_queued);
+            result.completed += worker->completed;
+            result.blocked_submits += worker->blocked_submits;
+            total_wait_ns += worker->total_wait_ns;
+            max_wait_ns = std::max(max_wait_ns, worker->max_wait_ns);
+        }
+        if (result.completed > 0)
+        {
+            result.avg_wait_us = static_cast<double>(total_wait_ns) / result.completed / 1000.0;
+        }
+        result.max_wait_us = static_cast<double>(max_wait_ns) / 1000.0;
+        return result;
+    }
+
+    /**
+     * @brief Dừng nhận công việc mới, chạy nốt các công việc còn trong hàng đợi rồi dừng worker.
+     */
+    void shutdown()
+    {
+        for (auto &worker : workers)
+        {
+            {
+                std::lock_guard<std::mutex> lock(worker->mutex);
+                worker->stopping = true;
+            }
+            worker->not_empty.notify_all();
+            worker->not_full.notify_all();
+        }
+        for (auto &worker : workers)
+        {
+            if (worker->thread.joinable())
+            {
+                worker->thread.join();
+            }
+        }
+    }
+
+private:
+    struct QueuedTask
+    {
+        Task task;
+        Clock::time_point enqueued_at;
+    };
+
+    struct Worker
+    {
+        mutable std::mutex mutex;
+        std::condition_variable not_empty;
+        std::condition_variable not_full;
+        std::deque<QueuedTask> queue;
+        bool stopping = false;
+        std::thread thread;
+
+        size_t max_queued = 0;
+        uint64_t completed = 0;
+        uint64_t blocked_submits = 0;
+        uint64_t total_wait_ns = 0;
+        uint64_t max_wait_ns = 0;
+    };
+
+    size_t capacity;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    bool enqueue(uint64_t key, Task task, bool wait_for_space)
+    {
+        Worker &worker = *workers[key % workers.size()];
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        if (wait_for_space && worker.queue.size() >= capacity && !worker.stopping)
+        {
+            ++worker.blocked_submits;
+            worker.not_full.wait(lock, [&worker, this]
+                                 { return worker.queue.size() < capacity || worker.stopping; });
+        }
+        if (worker.stopping)
+        {
+            return false;
+        }
+
+        worker.queue.push_back(QueuedTask{std::move(task), Clock::now()});
+        worker.max_queued = std::max(worker.max_queued, worker.queue.size());
+        lock.unlock();
+        worker.not_empty.notify_one();
+        return true;
+    }
+
+    void workerLoop(Worker *worker)
+    {
+        while (true)
+        {
+            QueuedTask item;
+            {
+                std::unique_lock<std::mutex> lock(worker->mutex);
+                worker->not_empty.wait(lock, [worker]
+                                       { return !worker->queue.empty() || worker->stopping; });
+                if (worker->queue.empty())
+                {
+                    return; // stopping và đã chạy hết hàng đợi
+                }
+                item = std::move(worker->queue.front());
+                worker->queue.pop_front();
+
+                uint64_t wait_ns = static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - item.enqueued_at).count());
+                worker->total_wait_ns += wait_ns;
+                worker->max_wait_ns = std::max(worker->max_wait_ns, wait_ns);
+            }
+            worker->not_full.notify_one();
+
+            item.task();
+
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            ++worker->completed;
+        }
+    }
+};
+
+/**
+ * @brief Hộp thư tuần tự chạy trên WorkerPool (một "strand" cho mỗi đối tượng, ví dụ một ván cờ).
+ *
+ * Các công việc post() vào cùng một Strand chạy lần lượt, đúng thứ tự gửi, không bao giờ song
+ * song, nên trạng thái của đối tượng không cần khóa riêng. Khi hộp thư có việc, Strand gửi một
+ * lượt xử lý vào pool (khóa theo key của nó); mỗi lượt chạy tối đa BATCH công việc rồi nhường
+ * worker cho các Strand khác. Các Strand khác nhau chạy song song trên các worker khác nhau.
+ *
+ * Không có pool (nullptr), công việc chạy ngay trên luồng gọi, vẫn tuần tự.
+ */
+class WorkerPool::Strand : public std::enable_shared_from_this<WorkerPool::Strand>
+{
+public:
+    static constexpr size_t BATCH = 32;
+
+    Strand(WorkerPool *pool, uint64_t key) : pool(pool), key(key) {}
+
+    Strand(const Strand &) = delete;
+    Strand &operator=(const Strand &) = delete;
+
+    void post(Task task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            mailbox.push_back(std::move(task));
+            if (scheduled)
+            {
+                return; // Lượt xử lý đang chạy hoặc đang chờ sẽ lấy công việc này
+            }
+            scheduled = true;
+        }
+        schedule();
+    }
+
+private:
+    WorkerPool *pool;
+    uint64_t key;
+    std::mutex mutex;
+    std::deque<Task> mailbox;
+    bool scheduled = false; // Đã có một lượt xử lý trong pool hoặc đang chạy
+
+    void schedule()
+    {
+        if (pool == nullptr)
+        {
+            drain(SIZE_MAX);
+            return;
+        }
+        std::shared_ptr<Strand> self = shared_from_this();
+        if (!pool->post(key, [self]()
+                        { self->drain(BATCH); }))
+        {
+            // Pool đã dừng: bỏ các công việc còn lại, giống submit() trả về false
+            std::lock_guard<std::mutex> lock(mutex);
+            mailbox.clear();
+            scheduled = false;
+        }
+    }
+
+    void drain(size_t limit)
+    {
+        for (size_t i = 0; i < limit; ++i)
+        {
+            Task task;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (mailbox.empty())
+                {
+                    scheduled = false;
+                    return;
+                }
+                task = std::move(mailbox.front());
+                mailbox.pop_front();
+            }
+            task();
+        }
+        schedule(); // Còn việc: xếp lượt mới phía sau các Strand khác trên worker này
+    }
+};
+
+#endif // WORKER_POOL_HPP
@@ -0,0 +1,67 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../server/client_table.hpp"
+
+using Table = BasicClientTable<4>;
+
+void login(Table &table, int client_fd, const std::string &username)
+{
+    table.findOrCreate(client_fd);
+    table.setUsername(client_fd, username);
+}
+
+void test_usernames_after_pages_in_order()
+{
+    Table table;
+    login(table, 5, "delta");
+    login(table, 6, "alpha");
+    login(table, 7, "echo");
+    login(table, 8, "charlie");
+    login(table, 9, "bravo");
+
+    // Duyệt theo trang 2 phần tử, cursor là username cuối của trang trước
+    std::vector<std::string> all;
+    std::vector<size_t> page_sizes;
+    std::string cursor;
+    while (true)
+    {
+        std::vector<std::string> page = table.usernamesAfter(cursor, 2);
+        if (page.empty())
+            break;
+        page_sizes.push_back(page.size());
+        all.insert(all.end(), page.begin(), page.end());
+        cursor = page.back();
+    }
+
+    std::vector<std::string> expected = {"alpha", "bravo", "charlie", "delta", "echo"};
+    bool passed = all == expected && page_sizes == std::vector<size_t>({2, 2, 1}) &&
+                  table.usernamesAfter("", 0).empty() &&
+                  table.usernamesAfter("echo", 10).empty() &&
+                  table.usernamesAfter("b", 1) == std::vector<std::string>({"bravo"}); // cursor không cần là username đang online
+    std::cout << "Usernames after pages Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_usernames_after_tracks_logout_and_rename()
+{
+    Table table;
+    login(table, 5, "alpha");
+    login(table, 6, "bravo");
+    login(table, 7, "charlie");
+    table.findOrCreate(8); // Chưa đăng nhập: không xuất hiện trong danh sách
+
+    table.erase(6);
+    table.setUsername(7, "zulu");
+
+    bool passed = table.usernamesAfter("", 10) == std::vector<std::string>({"alpha", "zulu"}) &&
+                  table.usernamesAfter("alpha", 10) == std::vector<std::string>({"zulu"});
+    std::cout << "Usernames after logout/rename Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+int main()
+{
+    test_usernames_after_pages_in_order();
+    test_usernames_after_tracks_logout_and_rename();
+    return 0;
+}
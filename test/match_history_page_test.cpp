@@ -0,0 +1,97 @@
+// DataStorage đọc dữ liệu từ <thư mục chứa file chạy>/../data, nên cần build file chạy
+// trong test/ (hoặc build/) để dùng data/ của repo. Test chỉ đọc, không ghi dữ liệu.
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../server/data_storage.hpp"
+
+const size_t PAGE = 7;
+
+// Duyệt lịch sử bằng cursor, so với toàn bộ lịch sử (trận mới nhất trước)
+bool pagesMatchFullHistory(DataStorage &storage, const std::string &username, size_t &page_count)
+{
+    std::vector<MatchModel> full = storage.getMatchHistory(username);
+
+    std::vector<MatchSummary> paged;
+    size_t before = SIZE_MAX;
+    page_count = 0;
+    do
+    {
+        std::vector<MatchSummary> page = storage.getMatchHistoryPage(username, before, PAGE, before);
+        if (page.size() > PAGE || (before > 0 && page.size() != PAGE))
+            return false;
+        paged.insert(paged.end(), page.begin(), page.end());
+        ++page_count;
+    } while (before > 0);
+
+    if (paged.size() != full.size())
+        return false;
+    for (size_t i = 0; i < paged.size(); ++i)
+    {
+        if (paged[i].game_id != full[i].game_id || paged[i].white_username != full[i].white_username ||
+            paged[i].black_username != full[i].black_username || paged[i].result != full[i].result ||
+            paged[i].start_time != full[i].start_time)
+            return false;
+        if (i > 0 && paged[i].start_time > paged[i - 1].start_time)
+            return false;
+    }
+    return true;
+}
+
+void test_cursor_walks_whole_history()
+{
+    DataStorage &storage = DataStorage::getInstance();
+    bool passed = true;
+    bool multi_page = false;
+    for (const auto &[username, user] : storage.getPlayerList())
+    {
+        size_t page_count = 0;
+        passed = passed && pagesMatchFullHistory(storage, username, page_count);
+        multi_page = multi_page || page_count > 1;
+    }
+    std::cout << "Match history cursor Test: " << (passed && multi_page ? "Passed" : "Failed") << std::endl;
+}
+
+void test_cursor_bounds()
+{
+    DataStorage &storage = DataStorage::getInstance();
+
+    std::string username;
+    size_t total = 0;
+    for (const auto &[name, user] : storage.getPlayerList())
+    {
+        size_t count = storage.getMatchHistory(name).size();
+        if (count > total)
+        {
+            username = name;
+            total = count;
+        }
+    }
+
+    size_t next_before = 1;
+    bool unknown = storage.getMatchHistoryPage("no such user", SIZE_MAX, PAGE, next_before).empty() && next_before == 0;
+
+    // before lớn hơn số trận: bắt đầu từ trận mới nhất
+    size_t from_newest, from_large;
+    std::vector<MatchSummary> newest = storage.getMatchHistoryPage(username, SIZE_MAX, PAGE, from_newest);
+    std::vector<MatchSummary> large = storage.getMatchHistoryPage(username, total + 100, PAGE, from_large);
+    bool clamped = !newest.empty() && large.size() == newest.size() && from_large == from_newest &&
+                   large.front().game_id == newest.front().game_id;
+
+    // Trang cuối chỉ chứa các trận còn lại, limit 0 không đọc gì và giữ nguyên vị trí
+    size_t last_before, empty_before;
+    std::vector<MatchSummary> last = storage.getMatchHistoryPage(username, 2, PAGE, last_before);
+    bool tail = last.size() == std::min<size_t>(2, total) && last_before == 0;
+    bool zero = storage.getMatchHistoryPage(username, 3, 0, empty_before).empty() && empty_before == std::min<size_t>(3, total);
+
+    bool passed = total > PAGE && unknown && clamped && tail && zero;
+    std::cout << "Match history cursor bounds Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+int main()
+{
+    test_cursor_walks_whole_history();
+    test_cursor_bounds();
+    return 0;
+}
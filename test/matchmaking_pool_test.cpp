@@ -0,0 +1,107 @@
+#include <chrono>
+#include <iostream>
+
+#include "../server/matchmaking_pool.hpp"
+
+using Clock = MatchmakingPool::Clock;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+// Cửa sổ 100 ELO lúc vào, nới 50 mỗi giây, tối đa 400
+MatchmakingPool makePool()
+{
+    return MatchmakingPool(100, 400, 50);
+}
+
+void test_closest_opponent_is_chosen()
+{
+    MatchmakingPool pool = makePool();
+    Clock::time_point now = Clock::now();
+    pool.add(1, 1200, now);
+    pool.add(2, 1290, now);
+    pool.add(3, 1500, now);
+
+    pool.add(4, 1280, now);
+    auto match = pool.matchArrival(4, now);
+
+    bool passed = match && match->fd1 == 2 && match->fd2 == 4 && match->elo1 == 1290 &&
+                  pool.size() == 2 && !pool.contains(2) && !pool.contains(4);
+    std::cout << "Closest opponent Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_mismatched_pair_does_not_block_others()
+{
+    MatchmakingPool pool = makePool();
+    Clock::time_point now = Clock::now();
+    pool.add(1, 1000, now);
+    pool.add(2, 2000, now);
+    bool first = !pool.matchArrival(2, now);
+
+    pool.add(3, 2050, now);
+    auto match = pool.matchArrival(3, now);
+
+    bool passed = first && match && match->fd1 == 2 && match->fd2 == 3 && pool.contains(1);
+    std::cout << "Mismatched head does not block Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_window_widens_with_wait()
+{
+    MatchmakingPool pool = makePool();
+    Clock::time_point start = Clock::now();
+    pool.add(1, 1200, start);
+    pool.add(2, 1400, start + seconds(1));
+    bool not_yet = !pool.matchArrival(2, start + seconds(1));
+
+    // Chênh 200: người chờ lâu hơn cần 2 giây để cửa sổ nới từ 100 lên 200
+    bool deadline = pool.nextCheck() == start + seconds(2);
+    bool early = pool.matchWaiting(start + milliseconds(1999)).empty();
+    auto matches = pool.matchWaiting(start + seconds(2));
+
+    bool passed = not_yet && deadline && early && matches.size() == 1 &&
+                  matches[0].fd1 == 1 && matches[0].fd2 == 2 && pool.size() == 0 &&
+                  pool.nextCheck() == Clock::time_point::max();
+    std::cout << "Window widens with wait Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_gap_above_max_window_never_matches()
+{
+    MatchmakingPool pool = makePool();
+    Clock::time_point now = Clock::now();
+    pool.add(1, 1000, now);
+    pool.add(2, 1500, now);
+    pool.matchArrival(2, now);
+
+    bool passed = pool.nextCheck() == Clock::time_point::max() &&
+                  pool.matchWaiting(now + seconds(3600)).empty() &&
+                  pool.window(now, now + seconds(3600)) == 400;
+    std::cout << "Max window Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_remove_and_duplicate_add()
+{
+    MatchmakingPool pool = makePool();
+    Clock::time_point now = Clock::now();
+    pool.add(1, 1200, now);
+    bool duplicate = !pool.add(1, 1200, now);
+    pool.add(2, 1500, now);
+    pool.add(3, 1800, now);
+
+    // Bỏ người ở giữa: hai người còn lại thành cặp kề mới (chênh 600, không bao giờ đủ điều kiện)
+    bool removed = pool.remove(2) && !pool.remove(2);
+    pool.add(4, 1210, now);
+    auto match = pool.matchArrival(4, now);
+
+    bool passed = duplicate && removed && match && match->fd1 == 1 && match->fd2 == 4 &&
+                  pool.size() == 1 && pool.contains(3);
+    std::cout << "Remove and duplicate add Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+int main()
+{
+    test_closest_opponent_is_chosen();
+    test_mismatched_pair_does_not_block_others();
+    test_window_widens_with_wait();
+    test_gap_above_max_window_never_matches();
+    test_remove_and_duplicate_add();
+    return 0;
+}
@@ -282,6 +282,226 @@ void test_spectate_failure_message() {
               << std::endl;
 }
 
+void test_player_list_message_v2() {
+    // Arrange: vượt quá 255 người chơi và chuỗi dài hơn 255 byte
+    PlayerListMessage original_message;
+    for (int i = 0; i < 300; ++i) {
+        PlayerListMessage::Player player;
+        player.username = "player" + std::to_string(i);
+        player.elo = static_cast<uint16_t>(1000 + i);
+        player.in_game = (i % 2 == 0);
+        player.game_id = player.in_game ? std::string(300, 'g') : "";
+        original_message.players.push_back(player);
+    }
+
+    // Act
+    std::vector<uint8_t> serialized = original_message.serialize(Protocol::V2);
+    PlayerListMessage deserialized_message = PlayerListMessage::deserialize(serialized, Protocol::V2);
+    PlayerListMessage v1_message = PlayerListMessage::deserialize(original_message.serialize(Protocol::V1), Protocol::V1);
+
+    // Assert
+    bool passed = deserialized_message.players.size() == 300 &&
+                  deserialized_message.players[299].username == "player299" &&
+                  deserialized_message.players[298].game_id.size() == 300 &&
+                  v1_message.players.size() == 255;
+    std::cout << "PlayerListMessage v2 Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_move_message_view() {
+    // Arrange
+    MoveMessage original_message;
+    original_message.game_id = "game_alice_bob_20240101";
+    original_message.uci_move = "e2e4";
+    std::vector<uint8_t> serialized = original_message.serialize(Protocol::V1);
+
+    // Act
+    MoveMessageView view;
+    bool decoded = MoveMessageView::decode(serialized.data(), serialized.size(), view, Protocol::V1);
+    MoveMessageView truncated;
+    bool truncated_decoded = MoveMessageView::decode(serialized.data(), serialized.size() - 1, truncated, Protocol::V1);
+
+    // Assert: các trường trỏ thẳng vào payload, payload cắt cụt bị từ chối
+    bool passed = decoded && view.game_id == original_message.game_id && view.uci_move == "e2e4" &&
+                  view.game_id.data() == reinterpret_cast<const char *>(serialized.data() + 1) &&
+                  !truncated_decoded;
+    std::cout << "MoveMessageView Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_move_v2_message() {
+    // Arrange
+    MoveV2Message original_message;
+    original_message.game_handle = 300;
+    original_message.ply = 12;
+    original_message.move = (12 << 6) | 28; // e2e4
+    std::vector<uint8_t> serialized = original_message.serialize(Protocol::V2);
+
+    // Act
+    MoveV2Message decoded_message;
+    bool decoded = MoveV2Message::decode(serialized.data(), serialized.size(), decoded_message, Protocol::V2);
+    MoveV2Message truncated;
+    bool truncated_decoded = MoveV2Message::decode(serialized.data(), serialized.size() - 1, truncated, Protocol::V2);
+
+    // Assert: handle 2 byte + ply 1 byte + nước đi 2 byte
+    bool passed = decoded && serialized.size() == 5 &&
+                  decoded_message.game_handle == original_message.game_handle &&
+                  decoded_message.ply == original_message.ply &&
+                  decoded_message.move == original_message.move &&
+                  !truncated_decoded;
+    std::cout << "MoveV2Message Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_game_move_delta_message() {
+    // Arrange
+    GameMoveDeltaMessage original_message;
+    original_message.game_handle = 42;
+    original_message.ply = 31;
+    original_message.move = (52 << 6) | 36; // e7e5
+    original_message.flags = GameMoveDeltaMessage::CHECK;
+
+    GameKeyframeMessage keyframe;
+    keyframe.game_handle = 42;
+    keyframe.ply = 32;
+    for (size_t i = 0; i < keyframe.board.size(); ++i) {
+        keyframe.board[i] = static_cast<uint8_t>(i * 7);
+    }
+
+    // Act
+    size_t frame_size = encodedSize(original_message, Protocol::V2);
+    std::vector<uint8_t> serialized = original_message.serialize(Protocol::V2);
+    GameMoveDeltaMessage decoded_message;
+    bool decoded = GameMoveDeltaMessage::decode(serialized.data(), serialized.size(), decoded_message, Protocol::V2);
+    std::vector<uint8_t> keyframe_serialized = keyframe.serialize(Protocol::V2);
+    GameKeyframeMessage decoded_keyframe;
+    bool keyframe_decoded = GameKeyframeMessage::decode(keyframe_serialized.data(), keyframe_serialized.size(), decoded_keyframe, Protocol::V2);
+
+    // Assert: cả frame cập nhật dưới 10 byte
+    bool passed = decoded && frame_size < 10 &&
+                  decoded_message.game_handle == original_message.game_handle &&
+                  decoded_message.ply == original_message.ply &&
+                  decoded_message.move == original_message.move &&
+                  decoded_message.flags == original_message.flags &&
+                  keyframe_decoded && decoded_keyframe.ply == keyframe.ply &&
+                  decoded_keyframe.board == keyframe.board;
+    std::cout << "GameMoveDeltaMessage Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_game_handle_v2() {
+    // Arrange
+    SurrenderMessage original_message;
+    original_message.game_id = "alice_bob_20241201_120000";
+    original_message.game_handle = 1000;
+    original_message.from_username = "alice";
+
+    // Act
+    std::vector<uint8_t> serialized_v1 = original_message.serialize(Protocol::V1);
+    std::vector<uint8_t> serialized_v2 = original_message.serialize(Protocol::V2);
+    SurrenderMessage decoded_v1 = SurrenderMessage::deserialize(serialized_v1, Protocol::V1);
+    SurrenderMessage decoded_v2 = SurrenderMessage::deserialize(serialized_v2, Protocol::V2);
+    SurrenderMessageView view;
+    bool view_decoded = SurrenderMessageView::decode(serialized_v2.data(), serialized_v2.size(), view, Protocol::V2);
+
+    // Assert: v1 giữ chuỗi game_id, v2 chỉ gửi handle (2 byte varint)
+    bool passed = decoded_v1.game_id == original_message.game_id &&
+                  decoded_v2.game_id.empty() && decoded_v2.game_handle == original_message.game_handle &&
+                  decoded_v2.from_username == original_message.from_username &&
+                  serialized_v2.size() == 2 + 1 + original_message.from_username.size() &&
+                  view_decoded && view.game_handle == original_message.game_handle &&
+                  view.from_username == original_message.from_username;
+    std::cout << "Game handle v2 Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_paged_list_messages() {
+    // Arrange
+    RequestMatchHistoryMessage request;
+    request.limit = 20;
+    request.cursor = "46";
+    PlayerListMessage page;
+    page.players.push_back({"alice", 1200, false, ""});
+    page.next_cursor = "alice";
+    page.final = false;
+
+    // Act
+    RequestMatchHistoryMessage request_v2 = RequestMatchHistoryMessage::deserialize(request.serialize(Protocol::V2), Protocol::V2);
+    RequestMatchHistoryMessage request_v1 = RequestMatchHistoryMessage::deserialize(request.serialize(Protocol::V1), Protocol::V1);
+    PlayerListMessage page_v2 = PlayerListMessage::deserialize(page.serialize(Protocol::V2), Protocol::V2);
+    PlayerListMessage page_v1 = PlayerListMessage::deserialize(page.serialize(Protocol::V1), Protocol::V1);
+
+    // Assert: v1 giữ nguyên định dạng cũ (không limit/cursor, luôn là frame cuối)
+    bool passed = request_v2.limit == 20 && request_v2.cursor == "46" &&
+                  request_v1.limit == 0 && request_v1.cursor.empty() && request.serialize(Protocol::V1).empty() &&
+                  page_v2.players.size() == 1 && page_v2.next_cursor == "alice" && !page_v2.final &&
+                  page_v1.players.size() == 1 && page_v1.next_cursor.empty() && page_v1.final;
+    std::cout << "Paged list messages Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_encode_to_buffer() {
+    // Arrange
+    GameStatusUpdateMessage original_message;
+    original_message.game_id = "game_1";
+    original_message.fen = "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1";
+    original_message.current_turn_username = "bob";
+    original_message.is_game_over = 0;
+    original_message.message = "";
+
+    bool passed = true;
+    for (uint8_t version : {Protocol::V1, Protocol::V2}) {
+        // Act: ghi thẳng vào buffer của người gọi
+        uint8_t buffer[256];
+        size_t size = encodedSize(original_message, version);
+        size_t written = encodeTo(original_message, buffer, version);
+        std::vector<uint8_t> expected = encodeFrame(original_message.getType(), original_message.serialize(version), version);
+
+        // Assert: cùng byte với đường serialize() + encodeFrame
+        passed = passed && size == written && std::vector<uint8_t>(buffer, buffer + written) == expected;
+    }
+    std::cout << "Encode to buffer Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+// Mọi tiền tố ngắn hơn payload đầy đủ phải bị từ chối (v1 không có trường tùy chọn ở cuối)
+template <typename Message>
+bool rejectsEveryTruncation(const Message &message) {
+    std::vector<uint8_t> payload = message.serialize(Protocol::V1);
+    for (size_t size = 0; size < payload.size(); ++size) {
+        std::vector<uint8_t> truncated(payload.begin(), payload.begin() + size);
+        Message decoded;
+        if (Message::decode(truncated.data(), truncated.size(), decoded, Protocol::V1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_truncated_payloads() {
+    // Arrange
+    GameStatusUpdateMessage status;
+    status.game_id = "game_1";
+    status.fen = "8/8/8/8/8/8/8/K6k w - - 0 1";
+    status.current_turn_username = "alice";
+    status.is_game_over = 1;
+    status.message = "Checkmate";
+    MatchHistoryMessage history;
+    history.matches.push_back({"game_1", "bob", true, "2024-12-01"});
+    history.matches.push_back({"game_2", "carol", false, "2024-12-02"});
+    GameEndMessage end;
+    end.game_id = "game_1";
+    end.winner_username = "alice";
+    end.reason = "Checkmate";
+    end.half_moves_count = 42;
+
+    // Act: view sinh từ cùng khai báo trỏ thẳng vào payload
+    std::vector<uint8_t> payload = status.serialize(Protocol::V2);
+    BasicGameStatusUpdateMessage<std::string_view> view;
+    bool view_decoded = BasicGameStatusUpdateMessage<std::string_view>::decode(payload.data(), payload.size(), view, Protocol::V2);
+
+    // Assert
+    bool passed = rejectsEveryTruncation(status) && rejectsEveryTruncation(history) &&
+                  rejectsEveryTruncation(end) &&
+                  view_decoded && view.fen == status.fen && view.message == status.message &&
+                  view.fen.data() >= reinterpret_cast<const char *>(payload.data()) &&
+                  view.fen.data() < reinterpret_cast<const char *>(payload.data() + payload.size());
+    std::cout << "Truncated payloads Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
 int main() {
     // test_register_message();
     // test_register_failure_message();
@@ -301,5 +521,13 @@ int main() {
     test_request_spectate_message();
     test_spectate_success_message();
     test_spectate_failure_message();
+    test_player_list_message_v2();
+    test_move_message_view();
+    test_move_v2_message();
+    test_game_move_delta_message();
+    test_game_handle_v2();
+    test_paged_list_messages();
+    test_encode_to_buffer();
+    test_truncated_payloads();
     return 0;
 }
\ No newline at end of file
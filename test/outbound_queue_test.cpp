@@ -0,0 +1,182 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "../server/outbound_queue.hpp"
+
+using Clock = OutboundQueue::Clock;
+using std::chrono::milliseconds;
+
+// Frame giả có kích thước size; OutboundQueue chỉ đọc byte loại thông điệp ở đầu frame
+OutboundFrame makeFrame(MessageType type, size_t size)
+{
+    auto frame = std::make_shared<std::vector<uint8_t>>(size, 0);
+    (*frame)[0] = static_cast<uint8_t>(type);
+    return frame;
+}
+
+size_t countType(const ClientInfo &client, MessageType type)
+{
+    size_t count = 0;
+    for (const OutboundFrame &frame : client.outbound)
+    {
+        if (OutboundQueue::frameType(frame) == type)
+            ++count;
+    }
+    return count;
+}
+
+void test_latest_only_replaces_unsent_frames()
+{
+    ClientInfo client;
+    Clock::time_point now = Clock::now();
+    const size_t half = Const::OUTBOUND_LIMIT_BYTES / 2;
+
+    // Gói đầu hàng đợi đã gửi một phần, sau đó là một gói của người chơi và một vị trí cũ
+    OutboundQueue::push(client, makeFrame(MessageType::SPECTATE_MOVE, half), now);
+    client.outbound_offset = 100;
+    OutboundQueue::push(client, makeFrame(MessageType::GAME_STATUS_UPDATE, half), now);
+    OutboundQueue::push(client, makeFrame(MessageType::SPECTATE_MOVE, 1000), now);
+
+    OutboundFrame latest = makeFrame(MessageType::SPECTATE_MOVE, 1000);
+    OutboundQueue::push(client, latest, now);
+
+    bool passed = client.outbound.size() == 3 &&
+                  countType(client, MessageType::SPECTATE_MOVE) == 2 &&
+                  client.outbound.front()->size() == half &&
+                  client.outbound.back() == latest &&
+                  client.outbound_bytes == 2 * half + 1000;
+    std::cout << "Latest only replacement Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_reliable_frames_are_never_dropped()
+{
+    ClientInfo client;
+    Clock::time_point now = Clock::now();
+    for (int i = 0; i < 5; ++i)
+    {
+        OutboundQueue::push(client, makeFrame(MessageType::GAME_STATUS_UPDATE, Const::OUTBOUND_LIMIT_BYTES / 2), now);
+    }
+
+    bool passed = client.outbound.size() == 5 &&
+                  client.outbound_bytes == 5 * (Const::OUTBOUND_LIMIT_BYTES / 2);
+    std::cout << "Reliable frames kept Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_slow_consumer_timeout()
+{
+    ClientInfo client;
+    Clock::time_point start = Clock::now();
+    const milliseconds timeout(Const::SLOW_CONSUMER_TIMEOUT_MS);
+
+    bool first = !OutboundQueue::push(client, makeFrame(MessageType::GAME_STATUS_UPDATE, Const::OUTBOUND_LIMIT_BYTES + 1), start);
+    bool at_limit = !OutboundQueue::push(client, makeFrame(MessageType::GAME_STATUS_UPDATE, 10), start + timeout);
+    bool expired = OutboundQueue::push(client, makeFrame(MessageType::GAME_STATUS_UPDATE, 10), start + timeout + milliseconds(1));
+
+    // Đường xả hàng đợi cũng phải phát hiện quá hạn khi không có gói mới
+    bool flush_expired = OutboundQueue::updateOverLimit(client, start + timeout + milliseconds(1));
+
+    bool passed = first && at_limit && expired && flush_expired && client.over_limit_since == start;
+    std::cout << "Slow consumer timeout Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_drain_resets_timer()
+{
+    ClientInfo client;
+    Clock::time_point start = Clock::now();
+    const milliseconds timeout(Const::SLOW_CONSUMER_TIMEOUT_MS);
+
+    OutboundQueue::push(client, makeFrame(MessageType::GAME_STATUS_UPDATE, Const::OUTBOUND_LIMIT_BYTES + 1), start);
+
+    // Gửi hết gói lớn: hàng đợi xuống dưới giới hạn thì mốc được xóa
+    client.outbound_bytes -= client.outbound.front()->size();
+    client.outbound.pop_front();
+    bool cleared = !OutboundQueue::updateOverLimit(client, start + milliseconds(500)) &&
+                   client.over_limit_since == Clock::time_point{};
+
+    // Vượt giới hạn lần nữa sau mốc cũ + timeout: tính lại từ đầu, không bị ngắt ngay
+    Clock::time_point later = start + timeout + milliseconds(1000);
+    bool fresh = !OutboundQueue::push(client, makeFrame(MessageType::GAME_STATUS_UPDATE, Const::OUTBOUND_LIMIT_BYTES + 1), later);
+
+    bool passed = cleared && fresh && client.over_limit_since == later;
+    std::cout << "Drain resets timer Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_batch_coalesces_only_its_own_frames()
+{
+    ClientInfo client;
+    Clock::time_point now = Clock::now();
+
+    // Frame còn lại từ các lượt trước: không được gộp vào BATCH của lượt này
+    OutboundQueue::push(client, makeFrame(MessageType::GAME_STATUS_UPDATE, 100), now);
+    OutboundQueue::push(client, makeFrame(MessageType::SPECTATE_MOVE, 100), now);
+
+    std::vector<OutboundFrame> frames = {
+        makeFrame(MessageType::GAME_STATUS_UPDATE, 100),
+        makeFrame(MessageType::GAME_END, 50),
+        makeFrame(MessageType::SPECTATE_MOVE, 60),
+        makeFrame(MessageType::GAME_STATUS_UPDATE, 70),
+    };
+    bool expired = OutboundQueue::pushBatch(client, frames, true, now);
+
+    // Thứ tự giữ nguyên: 2 frame cũ, BATCH(2 frame đầu), SPECTATE_MOVE riêng, frame cuối riêng
+    std::vector<MessageType> types;
+    for (const OutboundFrame &frame : client.outbound)
+    {
+        types.push_back(OutboundQueue::frameType(frame));
+    }
+    std::vector<MessageType> expected = {MessageType::GAME_STATUS_UPDATE, MessageType::SPECTATE_MOVE,
+                                         MessageType::BATCH, MessageType::SPECTATE_MOVE,
+                                         MessageType::GAME_STATUS_UPDATE};
+    bool passed = !expired && types == expected && client.outbound[2]->size() == 1 + 2 + 150 &&
+                  client.outbound[3] == frames[2] && client.outbound[4] == frames[3];
+
+    // Client v1: không gộp
+    ClientInfo v1_client;
+    OutboundQueue::pushBatch(v1_client, frames, false, now);
+    passed = passed && v1_client.outbound.size() == frames.size();
+
+    std::cout << "Batch coalesces own frames Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_lagging_spectator_keeps_only_latest_position()
+{
+    ClientInfo client;
+    Clock::time_point start = Clock::now();
+
+    // Gói lớn đang gửi dở; mỗi lượt chỉ có một vị trí bàn cờ mới cho khán giả
+    OutboundQueue::push(client, makeFrame(MessageType::SPECTATE_SUCCESS, Const::OUTBOUND_LIMIT_BYTES - 1000), start);
+    client.outbound_offset = 1;
+
+    bool expired = false;
+    OutboundFrame latest;
+    for (int tick = 0; tick < 50; ++tick)
+    {
+        latest = makeFrame(MessageType::SPECTATE_MOVE, 2000);
+        expired = OutboundQueue::pushBatch(client, {latest}, true, start + milliseconds(100 * tick)) || expired;
+    }
+    bool bounded = client.outbound.size() == 2 && client.outbound.back() == latest &&
+                   client.outbound_bytes == Const::OUTBOUND_LIMIT_BYTES + 1000;
+
+    // Client đọc xong gói lớn: xuống dưới giới hạn, không bị ngắt
+    client.outbound_bytes -= client.outbound.front()->size();
+    client.outbound.pop_front();
+    client.outbound_offset = 0;
+    bool recovered = !OutboundQueue::updateOverLimit(client, start + milliseconds(5000)) &&
+                     client.over_limit_since == Clock::time_point{};
+
+    bool passed = !expired && bounded && recovered;
+    std::cout << "Lagging spectator Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+int main()
+{
+    test_latest_only_replaces_unsent_frames();
+    test_reliable_frames_are_never_dropped();
+    test_slow_consumer_timeout();
+    test_drain_resets_timer();
+    test_batch_coalesces_only_its_own_frames();
+    test_lagging_spectator_keeps_only_latest_position();
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../common/packet_framer.hpp"
+
+// Đóng gói giống NetworkServer::sendPacket
+std::vector<uint8_t> makeFrame(MessageType type, const std::string &text)
+{
+    Packet packet;
+    packet.type = type;
+    packet.length = htons(static_cast<uint16_t>(text.size()));
+    packet.payload = std::vector<uint8_t>(text.begin(), text.end());
+    return packet.serialize();
+}
+
+std::string payloadOf(const PacketView &view)
+{
+    return std::string(view.payload, view.payload + view.length);
+}
+
+void test_multiple_frames_in_one_read()
+{
+    PacketFramer framer(64);
+    std::vector<uint8_t> bytes = makeFrame(MessageType::LOGIN, "alice");
+    std::vector<uint8_t> second = makeFrame(MessageType::MOVE, "e2e4");
+    bytes.insert(bytes.end(), second.begin(), second.end());
+    framer.append(bytes.data(), bytes.size());
+
+    std::vector<std::string> received;
+    size_t count = framer.drain([&](const PacketView &view)
+                                { received.push_back(payloadOf(view)); });
+
+    bool passed = count == 2 && received[0] == "alice" && received[1] == "e2e4" && framer.used() == 0;
+    std::cout << "Multiple frames per read Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_partial_frame_is_kept()
+{
+    PacketFramer framer(64);
+    std::vector<uint8_t> bytes = makeFrame(MessageType::LOGIN, "partial");
+
+    PacketView view;
+    framer.append(bytes.data(), 2);
+    bool first = framer.next(view);
+    framer.append(bytes.data() + 2, 4);
+    bool second = framer.next(view);
+    framer.append(bytes.data() + 6, bytes.size() - 6);
+    bool third = framer.next(view);
+
+    bool passed = !first && !second && third && payloadOf(view) == "partial";
+    std::cout << "Partial frame Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_frame_wrapping_ring_end()
+{
+    PacketFramer framer(16);
+    std::vector<uint8_t> filler = makeFrame(MessageType::TEST, "0123456789");
+    std::vector<uint8_t> wrapped = makeFrame(MessageType::TEST, "abcdefgh");
+
+    PacketView view;
+    framer.append(filler.data(), filler.size());
+    framer.append(wrapped.data(), 1); // giữ lại 1 byte để buffer không quay về đầu
+    framer.next(view);
+    framer.append(wrapped.data() + 1, wrapped.size() - 2);
+    bool incomplete = !framer.next(view);
+    framer.append(wrapped.data() + wrapped.size() - 1, 1);
+    bool complete = framer.next(view);
+
+    bool passed = incomplete && complete && payloadOf(view) == "abcdefgh" && framer.capacity() == 16;
+    std::cout << "Ring wrap Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_frame_larger_than_capacity()
+{
+    PacketFramer framer(16);
+    std::string large(1000, 'x');
+    std::vector<uint8_t> bytes = makeFrame(MessageType::MATCH_HISTORY, large);
+    framer.append(bytes.data(), bytes.size());
+
+    PacketView view;
+    bool passed = framer.next(view) && payloadOf(view) == large;
+    std::cout << "Large frame Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_v2_frame_with_varint_length()
+{
+    PacketFramer framer(16);
+    framer.setVersion(Protocol::V2);
+    std::string large(70000, 'y'); // Vượt giới hạn 16 bit của v1
+    std::vector<uint8_t> payload(large.begin(), large.end());
+    std::vector<uint8_t> bytes = encodeFrame(MessageType::PLAYER_LIST, payload, Protocol::V2);
+
+    PacketView view;
+    framer.append(bytes.data(), 3); // header varint chưa đủ
+    bool incomplete = !framer.next(view) && !framer.failed();
+    framer.append(bytes.data() + 3, bytes.size() - 3);
+    bool complete = framer.next(view) && view.length == large.size() && payloadOf(view) == large;
+
+    bool passed = bytes.size() == 1 + 3 + large.size() && incomplete && complete;
+    std::cout << "V2 varint frame Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_v2_oversized_frame_fails()
+{
+    PacketFramer framer(16);
+    framer.setVersion(Protocol::V2);
+    std::vector<uint8_t> bytes = {static_cast<uint8_t>(MessageType::TEST)};
+    append_varint(bytes, static_cast<uint64_t>(Protocol::MAX_PAYLOAD_SIZE) + 1);
+    framer.append(bytes.data(), bytes.size());
+
+    PacketView view;
+    bool passed = !framer.next(view) && framer.failed();
+    std::cout << "V2 oversized frame Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_v2_batch_frame_is_split()
+{
+    PacketFramer framer(16);
+    framer.setVersion(Protocol::V2);
+    std::vector<uint8_t> first = encodeFrame(MessageType::GAME_MOVE_DELTA, {1, 2, 3}, Protocol::V2);
+    std::vector<uint8_t> second = encodeFrame(MessageType::GAME_END, {4, 5}, Protocol::V2);
+    std::vector<uint8_t> inner(first);
+    inner.insert(inner.end(), second.begin(), second.end());
+    std::vector<uint8_t> bytes = encodeFrame(MessageType::BATCH, inner, Protocol::V2);
+    std::vector<uint8_t> after = encodeFrame(MessageType::TEST, {9}, Protocol::V2);
+    bytes.insert(bytes.end(), after.begin(), after.end());
+    framer.append(bytes.data(), bytes.size());
+
+    // Các gói tin con được trả về như những frame riêng, theo đúng thứ tự
+    std::vector<MessageType> types;
+    framer.drain([&types](const PacketView &view)
+                 { types.push_back(view.type); });
+
+    std::vector<uint8_t> broken = {static_cast<uint8_t>(MessageType::BATCH), 3,
+                                   static_cast<uint8_t>(MessageType::TEST), 5, 0};
+    PacketFramer broken_framer(16);
+    broken_framer.setVersion(Protocol::V2);
+    broken_framer.append(broken.data(), broken.size());
+    PacketView view;
+    bool rejected = !broken_framer.next(view) && broken_framer.failed();
+
+    bool passed = types == std::vector<MessageType>{MessageType::GAME_MOVE_DELTA, MessageType::GAME_END, MessageType::TEST} &&
+                  !framer.failed() && rejected;
+    std::cout << "V2 batch frame Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_v2_request_id_in_header()
+{
+    PacketFramer framer(16);
+    framer.setVersion(Protocol::V2);
+    std::vector<uint8_t> tagged = encodeFrame(MessageType::PLAYER_LIST, {1, 2}, Protocol::V2, 0x01020304);
+    std::vector<uint8_t> plain = encodeFrame(MessageType::PLAYER_LIST, {3}, Protocol::V2);
+
+    PacketView view;
+    framer.append(tagged.data(), 4); // request ID chưa đủ
+    bool incomplete = !framer.next(view) && !framer.failed();
+    framer.append(tagged.data() + 4, tagged.size() - 4);
+    bool first = framer.next(view) && view.type == MessageType::PLAYER_LIST &&
+                 view.request_id == 0x01020304 && view.length == 2;
+    framer.append(plain.data(), plain.size());
+    bool second = framer.next(view) && view.type == MessageType::PLAYER_LIST &&
+                  view.request_id == Protocol::NO_REQUEST_ID && view.length == 1;
+
+    bool passed = tagged.size() == 1 + 4 + 1 + 2 && incomplete && first && second;
+    std::cout << "V2 request ID Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+// Đóng gói giống NetworkServer::compressFrame
+std::vector<uint8_t> compressedFrame(MessageType type, const std::string &text, size_t raw_length)
+{
+    std::vector<uint8_t> body = {static_cast<uint8_t>(type)};
+    append_varint(body, raw_length);
+    size_t prefix = body.size();
+    body.resize(prefix + Lz::compressBound(text.size()));
+    body.resize(prefix + Lz::compress(reinterpret_cast<const uint8_t *>(text.data()), text.size(), body.data() + prefix));
+    return encodeFrame(MessageType::COMPRESSED, body, Protocol::V2, 7);
+}
+
+void test_v2_compressed_frame_is_inflated()
+{
+    std::string text;
+    for (int i = 0; i < 40; ++i)
+    {
+        text += "player_" + std::to_string(i % 5) + ";";
+    }
+
+    PacketFramer framer(64);
+    framer.setVersion(Protocol::V2);
+    std::vector<uint8_t> single = compressedFrame(MessageType::MATCH_HISTORY, text, text.size());
+    std::vector<uint8_t> inner = compressedFrame(MessageType::PLAYER_LIST, text, text.size());
+    std::vector<uint8_t> batch = encodeFrame(MessageType::BATCH, inner, Protocol::V2);
+
+    PacketView view;
+    framer.append(single.data(), single.size());
+    bool first = framer.next(view) && view.type == MessageType::MATCH_HISTORY &&
+                 view.request_id == 7 && payloadOf(view) == text;
+    framer.append(batch.data(), batch.size());
+    bool second = framer.next(view) && view.type == MessageType::PLAYER_LIST && payloadOf(view) == text;
+
+    // Độ dài gốc không khớp khối Lz: framer báo lỗi thay vì trả về dữ liệu sai
+    std::vector<uint8_t> broken = compressedFrame(MessageType::MATCH_HISTORY, text, text.size() + 1);
+    PacketFramer broken_framer(64);
+    broken_framer.setVersion(Protocol::V2);
+    broken_framer.append(broken.data(), broken.size());
+    bool rejected = !broken_framer.next(view) && broken_framer.failed();
+
+    bool passed = single.size() < text.size() && first && second && !framer.failed() && rejected;
+    std::cout << "V2 compressed frame Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+void test_v2_compressed_frame_limits()
+{
+    PacketView view;
+
+    // Độ dài gốc vượt mức giãn tối đa của khối nén: từ chối trước khi cấp phát
+    std::vector<uint8_t> body = {static_cast<uint8_t>(MessageType::MATCH_HISTORY)};
+    append_varint(body, 60000);
+    body.insert(body.end(), {0x10, 'x'});
+    std::vector<uint8_t> bomb = encodeFrame(MessageType::COMPRESSED, body, Protocol::V2);
+    PacketFramer bomb_framer(64);
+    bomb_framer.setVersion(Protocol::V2);
+    bomb_framer.append(bomb.data(), bomb.size());
+    bool bomb_rejected = !bomb_framer.next(view) && bomb_framer.failed();
+
+    // Framer của máy chủ không nhận frame COMPRESSED từ client
+    std::vector<uint8_t> frame = compressedFrame(MessageType::MATCH_HISTORY, "abcdabcdabcd", 12);
+    PacketFramer server_framer(64);
+    server_framer.setVersion(Protocol::V2);
+    server_framer.setAcceptCompressed(false);
+    server_framer.append(frame.data(), frame.size());
+    bool refused = !server_framer.next(view) && server_framer.failed();
+
+    bool passed = bomb_rejected && refused;
+    std::cout << "V2 compressed frame limits Test: " << (passed ? "Passed" : "Failed") << std::endl;
+}
+
+int main()
+{
+    test_multiple_frames_in_one_read();
+    test_partial_frame_is_kept();
+    test_frame_wrapping_ring_end();
+    test_frame_larger_than_capacity();
+    test_v2_frame_with_varint_length();
+    test_v2_oversized_frame_fails();
+    test_v2_batch_frame_is_split();
+    test_v2_request_id_in_header();
+    test_v2_compressed_frame_is_inflated();
+    test_v2_compressed_frame_limits();
+    return 0;
+}
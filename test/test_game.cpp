@@ -4,7 +4,7 @@
 #include <thread>
 
 // Function to simulate a game
-void simulateGame(GameManager &gameManager, const std::string &game_id, const std::vector<std::string> &moves, const std::string &game_name)
+void simulateGame(GameManager &gameManager, GameHandle game_id, const std::vector<std::string> &moves, const std::string &game_name)
 {
     std::cout << "\nSimulating " << game_name << ":" << std::endl;
     for (const auto &move : moves)
@@ -51,11 +51,11 @@ int main()
 
     // Create multiple games
     std::string initial_fen1 = "r1bkr3/pp4b1/7p/8/P1P2p2/8/1P1Pp1PP/R1B1K3 b - - 3 26";
-    std::string game_id1 = gameManager.createGame("Alice", "Bob", initial_fen1);
+    GameHandle game_id1 = gameManager.createGame("Alice", "Bob", initial_fen1)->handle;
     std::cout << "Game 1 created with ID: " << game_id1 << std::endl;
 
     std::string initial_fen2 = chess::constants::STARTPOS; // Standard starting position
-    std::string game_id2 = gameManager.createGame("Charlie", "Diana");
+    GameHandle game_id2 = gameManager.createGame("Charlie", "Diana")->handle;
     std::cout << "Game 2 created with ID: " << game_id2 << std::endl;
 
     // Define moves for each game
@@ -99,13 +99,13 @@ int main()
     for (const auto &game : active_games)
     {
         std::cout << "Game ID: " << game->game_id << std::endl;
-        std::cout << "Final FEN: " << gameManager.getGameFen(game->game_id) << std::endl;
-        std::cout << "Total Half Moves: " << gameManager.getGameHalfMovesCount(game->game_id) << std::endl;
-        if (gameManager.isGameOver(game->game_id))
+        std::cout << "Final FEN: " << gameManager.getGameFen(game->handle) << std::endl;
+        std::cout << "Total Half Moves: " << gameManager.getGameHalfMovesCount(game->handle) << std::endl;
+        if (gameManager.isGameOver(game->handle))
         {
-            std::string winner = gameManager.getGameWinner(game->game_id);
+            std::string winner = gameManager.getGameWinner(game->handle);
             std::cout << "Winner: " << (winner.empty() ? "None" : winner) << std::endl;
-            std::cout << "Reason: " << gameManager.getGameResultReason(game->game_id) << std::endl;
+            std::cout << "Reason: " << gameManager.getGameResultReason(game->handle) << std::endl;
         }
         std::cout << "--------------------------" << std::endl;
     }